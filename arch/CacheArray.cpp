@@ -0,0 +1,110 @@
+#include "arch/CacheArray.h"
+#include "sim/sampling.h"
+#include "sim/log2.h"
+
+#include <cassert>
+
+using namespace std;
+
+namespace Simulator
+{
+    CacheArray::CacheArray(const Object& owner, size_t sets, size_t assoc, const string& policy)
+        : m_sets(sets),
+          m_assoc(assoc),
+          m_policy(POLICY_LRU),
+          m_tags(sets * assoc, 0),
+          m_access(),
+          m_tree()
+    {
+        if (assoc == 0 || assoc > MAX_ASSOCIATIVITY)
+        {
+            throw exceptf<InvalidArgumentException>(owner, "Associativity = %zd is not between 1 and %zd", assoc, MAX_ASSOCIATIVITY);
+        }
+
+        if (policy == "LRU")
+        {
+            m_access.resize(sets * assoc, 0);
+        }
+        else if (policy == "PLRU")
+        {
+            if (!IsPowerOfTwo(assoc))
+            {
+                throw exceptf<InvalidArgumentException>(owner, "PLRU replacement requires a power of two associativity, not %zd", assoc);
+            }
+            m_policy = POLICY_PLRU;
+            m_tree.resize(sets, 0);
+        }
+        else
+        {
+            throw exceptf<InvalidArgumentException>(owner, "Unknown replacement policy: %s", policy.c_str());
+        }
+    }
+
+    const char* CacheArray::GetPolicyName() const
+    {
+        return (m_policy == POLICY_LRU) ? "LRU" : "PLRU";
+    }
+
+    void CacheArray::RegisterState(Object& owner)
+    {
+        auto& reg = owner.GetKernel()->GetVariableRegistry();
+        reg.RegisterVariable(m_tags, owner.GetName() + ":tags", SVC_STATE);
+        if (m_policy == POLICY_LRU)
+            reg.RegisterVariable(m_access, owner.GetName() + ":access", SVC_STATE);
+        else
+            reg.RegisterVariable(m_tree, owner.GetName() + ":plru", SVC_STATE);
+    }
+
+    size_t CacheArray::Victim(size_t set, WayMask candidates) const
+    {
+        assert(candidates != 0);
+
+        if (m_policy == POLICY_LRU)
+        {
+            const CycleNo* access = &m_access[set * m_assoc];
+            size_t victim = LowestWay(candidates);
+            for (WayMask m = candidates & (candidates - 1); m != 0; m &= m - 1)
+            {
+                const size_t w = LowestWay(m);
+                if (access[w] < access[victim])
+                    victim = w;
+            }
+            return victim;
+        }
+
+        // Walk down the tree: each node points to its less recently
+        // used half, unless that half has no candidates.
+        const WayMask tree = m_tree[set];
+        size_t node = 1, lo = 0, size = m_assoc;
+        while (size > 1)
+        {
+            size /= 2;
+            const WayMask half = (size == 64) ? ~(WayMask)0 : (((WayMask)1 << size) - 1);
+            const bool left_ok  = (candidates >> lo) & half;
+            const bool right_ok = (candidates >> (lo + size)) & half;
+            const bool right = ((tree >> node) & 1) ? right_ok : !left_ok;
+            node = node * 2 + right;
+            lo += right ? size : 0;
+        }
+        return lo;
+    }
+
+    void CacheArray::TouchTree(size_t line)
+    {
+        const size_t set = line / m_assoc, way = line % m_assoc;
+        WayMask& tree = m_tree[set];
+        size_t node = 1, lo = 0, size = m_assoc;
+        while (size > 1)
+        {
+            size /= 2;
+            const bool right = way >= lo + size;
+            // Point the node to the other half
+            if (right)
+                tree &= ~((WayMask)1 << node);
+            else
+                tree |= (WayMask)1 << node;
+            node = node * 2 + right;
+            lo += right ? size : 0;
+        }
+    }
+}
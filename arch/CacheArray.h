@@ -0,0 +1,99 @@
+// -*- c++ -*-
+#ifndef CACHEARRAY_H
+#define CACHEARRAY_H
+
+#include <sim/kernel.h>
+#include <arch/simtypes.h>
+
+#include <string>
+#include <vector>
+
+namespace Simulator
+{
+    /// CacheArray: the tags and replacement state of a set-associative
+    /// cache.
+    //
+    // The array does not hold the lines themselves: line i of the cache
+    // model is way (i % assoc) of set (i / assoc). The tags of a set are
+    // contiguous, so that a lookup compares all ways of the set in one
+    // loop and returns the matching ways as a bit mask. Which ways hold
+    // a line is up to the model, which also decides which ways may be
+    // replaced; the array then chooses among them by its policy:
+    //
+    //   LRU   the way with the oldest access time, the lowest way first
+    //         among equal times. This is exact, and the default.
+    //   PLRU  tree pseudo-LRU, with one bit per inner node of a binary
+    //         tree over the ways. Requires a power of two associativity.
+    //
+    class CacheArray
+    {
+    public:
+        typedef uint64_t WayMask;
+
+        enum Policy
+        {
+            POLICY_LRU,
+            POLICY_PLRU,
+        };
+
+        static const size_t MAX_ASSOCIATIVITY = 64;
+
+        CacheArray(const Object& owner, size_t sets, size_t assoc, const std::string& policy);
+
+        size_t GetNumSets()        const { return m_sets; }
+        size_t GetAssociativity()  const { return m_assoc; }
+        Policy GetPolicy()         const { return m_policy; }
+        const char* GetPolicyName() const;
+
+        // The ways of the set whose tag is tag, regardless of whether
+        // they hold a line.
+        WayMask Match(size_t set, MemAddr tag) const
+        {
+            const MemAddr* __restrict__ tags = &m_tags[set * m_assoc];
+            WayMask mask = 0;
+            for (size_t w = 0; w < m_assoc; ++w)
+                mask |= (WayMask)(tags[w] == tag) << w;
+            return mask;
+        }
+
+        MemAddr& Tag(size_t line) { return m_tags[line]; }
+        MemAddr  Tag(size_t line) const { return m_tags[line]; }
+
+        // The last access time of a line, as recorded by Touch. Always
+        // zero with PLRU, which does not keep times.
+        CycleNo LastAccess(size_t line) const { return (m_policy == POLICY_LRU) ? m_access[line] : 0; }
+
+        // Records an access to a line.
+        void Touch(size_t line, CycleNo now)
+        {
+            if (m_policy == POLICY_LRU)
+                m_access[line] = now;
+            else
+                TouchTree(line);
+        }
+
+        // Returns the way to replace among the candidates of the set,
+        // which must not be empty.
+        size_t Victim(size_t set, WayMask candidates) const;
+
+        // Lowest and highest way in a non-empty mask
+        static size_t LowestWay(WayMask mask)  { return __builtin_ctzll(mask); }
+        static size_t HighestWay(WayMask mask) { return 63 - __builtin_clzll(mask); }
+
+        // Registers the tags and the replacement state as state
+        // variables of the owner.
+        void RegisterState(Object& owner);
+
+    private:
+        void TouchTree(size_t line);
+
+        size_t               m_sets;
+        size_t               m_assoc;
+        Policy               m_policy;
+        std::vector<MemAddr> m_tags;    ///< Per line, its tag
+        std::vector<CycleNo> m_access;  ///< Per line, last access time (LRU)
+        std::vector<WayMask> m_tree;    ///< Per set, the PLRU tree bits, node n at bit n
+    };
+}
+
+#endif
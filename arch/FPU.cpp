@@ -68,6 +68,9 @@ StorageTraceSet FPU::CreateStoragePermutation(size_t num_sources, std::vector<bo
 
 size_t FPU::RegisterSource(IFPUClient& client, const StorageTraceSet& output)
 {
+    // Results are written into the client from the FPU's process.
+    GetKernel()->DeclareAccess(GetName(), client.GetName());
+
     for (size_t i = 0; i < m_sources.size(); ++i)
     {
         if (m_sources[i]->client == NULL)
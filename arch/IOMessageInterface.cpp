@@ -123,6 +123,11 @@ namespace Simulator
         {
             throw exceptf<InvalidArgumentException>(*this, "Device number %u is already registered", (unsigned)id);
         }
+        // Messages are delivered to the client from the processes of
+        // the interconnect. The client's processes send them through
+        // storages of the interconnect, which orders them already.
+        GetKernel()->DeclareAccess(dynamic_cast<Object&>(m_ic).GetName(), client.GetIODeviceName());
+
         auto rk = m_ic.RegisterReceiver(client.GetIODeviceName());
         auto sk = m_ic.RegisterSender(client.GetIODeviceName());
 
@@ -94,7 +94,27 @@ namespace Simulator
             } active_message;
         };
         bool Dispatch(IIOMessageClient& cl) const;
-        SERIALIZE(a) { (void)a; }
+        SERIALIZE(a) {
+            a & "[iop" & type;
+            switch (type)
+            {
+            case READ_REQUEST:
+                a & read_request.from & read_request.addr & read_request.size;
+                break;
+            case READ_RESPONSE:
+            case WRITE_REQUEST:
+                a & write_request.from & write_request.addr & write_request.data;
+                break;
+            case INTERRUPT_REQUEST:
+            case NOTIFICATION:
+                a & notification.channel & notification.tag;
+                break;
+            case ACTIVE_MESSAGE:
+                a & active_message.from & active_message.pc & active_message.arg;
+                break;
+            }
+            a & "]";
+        }
     protected:
         ~IOPayload() {};
     };
@@ -119,9 +119,19 @@ namespace Simulator
     }
     namespace Serialization
     {
+        // Messages are serialized by value. When a checkpoint is
+        // loaded into an empty slot, the message is allocated.
         template<typename Payload>
         struct serialize_trait<IC::Message<Payload>*>
-            : public pointer_serializer<IC::Message<Payload> > {};
+        {
+            template<typename A>
+            static void serialize(A& arch, IC::Message<Payload>* &p)
+            {
+                if (p == NULL)
+                    p = new IC::Message<Payload>();
+                arch & *p;
+            }
+        };
     }
 }
 
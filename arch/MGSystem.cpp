@@ -1,6 +1,8 @@
 #include "MGSystem.h"
 
 #include "arch/drisc/DRISC.h"
+#include "arch/Sampler.h"
+#include "arch/mem/MemoryTrace.h"
 
 #ifdef ENABLE_MEM_SERIAL
 #include "arch/mem/SerialMemory.h"
@@ -392,10 +394,65 @@ void MGSystem::PrintCoreStats(ostream& os) const {
        << "# tcreates: total number of threads created" << endl;
 }
 
-void MGSystem::PrintMemoryStatistics(ostream& os) const {
+IMemory* Simulator::CreateMemory(const string& type, Object& parent, Clock& clock, IMemoryAdmin*& admin)
+{
+#ifdef ENABLE_MEM_SERIAL
+    if (type == "SERIAL") {
+        SerialMemory* memory = new SerialMemory("memory", parent, clock);
+        admin = memory; return memory;
+    } else
+#endif
+#ifdef ENABLE_MEM_PARALLEL
+    if (type == "PARALLEL") {
+        ParallelMemory* memory = new ParallelMemory("memory", parent, clock);
+        admin = memory; return memory;
+    } else
+#endif
+#ifdef ENABLE_MEM_BANKED
+    if (type == "BANKED") {
+        BankedMemory* memory = new BankedMemory("memory", parent, clock, "DIRECT");
+        admin = memory; return memory;
+    } else
+    if (type == "RANDOMBANKED") {
+        BankedMemory* memory = new BankedMemory("memory", parent, clock, "RMIX");
+        admin = memory; return memory;
+    } else
+#endif
+#ifdef ENABLE_MEM_DDR
+    if (type == "DDR") {
+        DDRMemory* memory = new DDRMemory("memory", parent, clock, "DIRECT");
+        admin = memory; return memory;
+    } else
+    if (type == "RANDOMDDR") {
+        DDRMemory* memory = new DDRMemory("memory", parent, clock, "RMIX");
+        admin = memory; return memory;
+    } else
+#endif
+#ifdef ENABLE_MEM_CDMA
+    if (type == "CDMA" || type == "COMA") {
+        CDMA* memory = new TwoLevelCDMA("memory", parent, clock);
+        admin = memory; return memory;
+    } else
+    if (type == "FLATCDMA" || type == "FLATCOMA") {
+        CDMA* memory = new OneLevelCDMA("memory", parent, clock);
+        admin = memory; return memory;
+    } else
+#endif
+#ifdef ENABLE_MEM_ZLCDMA
+    if (type == "ZLCDMA") {
+        ZLCDMA* memory = new ZLCDMA("memory", parent, clock);
+        admin = memory; return memory;
+    } else
+#endif
+    {
+        throw runtime_error("Unknown memory type: " + type);
+    }
+}
+
+void Simulator::PrintMemoryStatistics(const IMemory& memory, ostream& os) {
     uint64_t nr = 0, nrb = 0, nw = 0, nwb = 0, nrext = 0, nwext = 0;
 
-    m_memory->GetMemoryStatistics(nr, nw, nrb, nwb, nrext, nwext);
+    memory.GetMemoryStatistics(nr, nw, nrb, nwb, nrext, nwext);
     os << nr << "\t# number of load reqs. by the L1 cache from L2" << endl
        << nrb << "\t# number of bytes loaded by the L1 cache from L2" << endl
        << nw << "\t# number of store reqs. by the L1 cache to L2" << endl
@@ -405,7 +462,11 @@ void MGSystem::PrintMemoryStatistics(ostream& os) const {
 
 }
 
-void MGSystem::PrintState(const vector<string>& /*unused*/) const
+void MGSystem::PrintMemoryStatistics(ostream& os) const {
+    Simulator::PrintMemoryStatistics(*m_memory, os);
+}
+
+void MGSystem::PrintState(const vector<string>& /*unused*/)
 {
     // This should be all non-idle processes
     for (const Clock* clock = GetKernel()->GetActiveClocks(); clock != NULL; clock = clock->GetNext())
@@ -470,17 +531,117 @@ void MGSystem::PrintAllStatistics(ostream& os) const
        << GetFlop() << "\t# total issued fp instructions" << endl
        << ru.GetUserTime() << "\t# total real time in user mode (us)" << endl
        << ru.GetSystemTime() << "\t# total real time in system mode (us)" << endl
-       << ru.GetMaxResidentSize() << "\t# maximum resident set size (Kibytes)" << endl;
+       << ru.GetMaxResidentSize() << "\t# maximum resident set size (Kibytes)" << endl
+       << m_startupTime << "\t# total real time to start up (us)" << endl;
     PrintCoreStats(os);
     os << "## memory statistics:" << endl;
     PrintMemoryStatistics(os);
+    if (m_sampler->IsEnabled())
+    {
+        os << "## estimated statistics:" << endl;
+        m_sampler->PrintStatistics(os);
+    }
+}
+
+void MGSystem::SetInitialRegisters(const vector<string>& regs)
+{
+    for (auto p : m_procs)
+        p->SetInitialRegisters(regs);
+}
+
+bool MGSystem::IsFastForward() const
+{
+    return !m_procs.empty() && m_procs[0]->IsFastForward();
+}
+
+bool MGSystem::HasReachedFastForwardEnd() const
+{
+    if (m_ffUntilCycle != 0 && GetKernel()->GetCycleNo() >= m_ffUntilCycle)
+        return true;
+    for (DRISC* p : m_procs)
+        if (p->HasReachedFastForwardMarker())
+            return true;
+    return false;
+}
+
+void MGSystem::EndFastForward()
+{
+    m_ffUntilCycle = 0;
+    if (m_sampler->IsEnabled())
+    {
+        // Continue with sampled simulation
+        m_sampler->Start();
+        return;
+    }
+
+    // All cores switch at once, so that no core accesses memory
+    // directly while another goes through the memory system.
+    for (DRISC* p : m_procs)
+        p->SetFastForward(false);
 }
 
 // Steps the entire system this many cycles
 void MGSystem::Step(CycleNo nCycles)
 {
+    auto& kernel = *GetKernel();
     m_breakpoints.Resume();
-    RunState state = GetKernel()->Step(nCycles);
+
+    RunState state;
+    for (;;)
+    {
+        CycleNo cycles = nCycles;
+        if (IsFastForward() && m_ffUntilCycle != 0)
+        {
+            // Do not step past the end of fast-forwarding
+            CycleNo now = kernel.GetCycleNo();
+            cycles = std::min(cycles, (now < m_ffUntilCycle) ? m_ffUntilCycle - now : 0);
+        }
+
+        if (m_sampler->IsRunning())
+        {
+            // Do not step past the next sampling phase
+            cycles = std::min(cycles, m_sampler->GetCyclesToNextPhase());
+        }
+
+        // The cores access memory functionally while fast-forwarding,
+        // which the parallel kernel does not order (see DRISC::ReadMemory).
+        kernel.SetParallel(!IsFastForward());
+
+        const CycleNo start = kernel.GetCycleNo();
+        state = kernel.Step(cycles);
+        if (m_sampler->IsRunning())
+        {
+            if (!m_sampler->Update(state))
+            {
+                break;
+            }
+        }
+        else if (IsFastForward() && HasReachedFastForwardEnd())
+        {
+            // Switch to detailed simulation. The kernel was stopped by
+            // a fast-forward marker, unless a breakpoint was hit as well.
+            EndFastForward();
+        }
+        else
+        {
+            break;
+        }
+
+        // Continue with the remaining cycles
+        if (m_breakpoints.NewBreaksDetected())
+        {
+            break;
+        }
+        if (nCycles != INFINITE_CYCLES)
+        {
+            nCycles -= kernel.GetCycleNo() - start;
+            if (nCycles == 0)
+            {
+                return;
+            }
+        }
+    }
+
     switch(state)
     {
     case STATE_ABORTED:
@@ -610,9 +771,13 @@ MGSystem::MGSystem(Config& config, bool quiet)
       m_symtable(),
       m_breakpoints(),
       m_memory(0),
+      m_memoryTrace(0),
       m_objdump_cmd(),
       m_bootrom(0),
-      m_selector(0)
+      m_selector(0),
+      m_ffUntilCycle(0),
+      m_sampler(0),
+      m_startupTime(0)
 {
 #ifdef STATIC_KERNEL
     Kernel::InitGlobalKernel();
@@ -632,6 +797,10 @@ MGSystem::MGSystem(Config& config, bool quiet)
 
     ResourceUsage ru1(true); // mark resource usage so far
 
+    // Resource usage at the end of each phase, for the startup breakdown
+    vector<pair<const char*, ResourceUsage> > phases;
+    auto endPhase = [&](const char* phase) { phases.push_back(make_pair(phase, ResourceUsage(true))); };
+
     PSize numProcessors = GetTopConf("NumProcessors", PSize);
 
     const size_t numProcessorsPerFPU = GetTopConf("NumProcessorsPerFPU", size_t);
@@ -643,58 +812,7 @@ MGSystem::MGSystem(Config& config, bool quiet)
     Clock& memclock = kernel.CreateClock(GetTopConf("MemoryFreq", Clock::Frequency));
 
     IMemoryAdmin *memadmin;
-
-#ifdef ENABLE_MEM_SERIAL
-    if (memory_type == "SERIAL") {
-        SerialMemory* memory = new SerialMemory("memory", *m_root, memclock);
-        memadmin = memory; m_memory = memory;
-    } else
-#endif
-#ifdef ENABLE_MEM_PARALLEL
-    if (memory_type == "PARALLEL") {
-        ParallelMemory* memory = new ParallelMemory("memory", *m_root, memclock);
-        memadmin = memory; m_memory = memory;
-    } else
-#endif
-#ifdef ENABLE_MEM_BANKED
-    if (memory_type == "BANKED") {
-        BankedMemory* memory = new BankedMemory("memory", *m_root, memclock, "DIRECT");
-        memadmin = memory; m_memory = memory;
-    } else
-    if (memory_type == "RANDOMBANKED") {
-        BankedMemory* memory = new BankedMemory("memory", *m_root, memclock, "RMIX");
-        memadmin = memory; m_memory = memory;
-    } else
-#endif
-#ifdef ENABLE_MEM_DDR
-    if (memory_type == "DDR") {
-        DDRMemory* memory = new DDRMemory("memory", *m_root, memclock, "DIRECT");
-        memadmin = memory; m_memory = memory;
-    } else
-    if (memory_type == "RANDOMDDR") {
-        DDRMemory* memory = new DDRMemory("memory", *m_root, memclock, "RMIX");
-        memadmin = memory; m_memory = memory;
-    } else
-#endif
-#ifdef ENABLE_MEM_CDMA
-    if (memory_type == "CDMA" || memory_type == "COMA") {
-        CDMA* memory = new TwoLevelCDMA("memory", *m_root, memclock);
-        memadmin = memory; m_memory = memory;
-    } else
-    if (memory_type == "FLATCDMA" || memory_type == "FLATCOMA") {
-        CDMA* memory = new OneLevelCDMA("memory", *m_root, memclock);
-        memadmin = memory; m_memory = memory;
-    } else
-#endif
-#ifdef ENABLE_MEM_ZLCDMA
-    if (memory_type == "ZLCDMA") {
-        ZLCDMA* memory = new ZLCDMA("memory", *m_root, memclock);
-        memadmin = memory; m_memory = memory;
-    } else
-#endif
-    {
-        throw runtime_error("Unknown memory type: " + memory_type);
-    }
+    m_memory = CreateMemory(memory_type, *m_root, memclock, memadmin);
     if (!quiet)
     {
         clog << "memory: " << memory_type << endl;
@@ -702,6 +820,39 @@ MGSystem::MGSystem(Config& config, bool quiet)
     memadmin->SetSymbolTable(m_symtable);
     m_breakpoints.SetSymbolTable(m_symtable);
 
+    // The clients of the memory system connect to the trace recorder
+    // instead of the memory, if enabled.
+    IMemory* memclients = m_memory;
+    auto trace_file = GetTopConfOpt("MemoryTraceFile", string, "");
+    if (!trace_file.empty())
+    {
+        m_memoryTrace = new MemoryTraceRecorder("memtrace", *m_root, *m_memory, trace_file);
+        memclients = m_memoryTrace;
+        if (!quiet)
+        {
+            clog << "memory trace: " << trace_file << endl;
+        }
+    }
+
+    // Open the binary event trace, if enabled.
+    auto events_file = GetTopConfOpt("EventTraceFile", string, "");
+    if (!events_file.empty())
+    {
+        istringstream events(GetTopConfOpt("EventTraceEvents", string, "*"));
+        vector<string> patterns;
+        for (string pat; events >> pat; )
+        {
+            patterns.push_back(pat);
+        }
+        kernel.GetEventTrace().Open(events_file, patterns, GetTopConfOpt("EventTraceBufferSize", size_t, 4096));
+        if (!quiet)
+        {
+            clog << "event trace: " << events_file << endl;
+        }
+    }
+
+    endPhase("memory");
+
     // Create the event selector
     Clock& selclock = kernel.CreateClock(GetTopConf("EventCheckFreq", Clock::Frequency));
     m_selector = new Selector("selector", *m_root, selclock);
@@ -767,6 +918,7 @@ MGSystem::MGSystem(Config& config, bool quiet)
     {
         clog << numFPUs << " FPUs instantiated." << endl;
     }
+    endPhase("I/O networks and FPUs");
 
     // Create processor grid
     m_procs.resize(numProcessors);
@@ -777,7 +929,7 @@ MGSystem::MGSystem(Config& config, bool quiet)
         if (m_clock == 0)
             m_clock = &coreclock;
         m_procs[i]   = new DRISC(name, *m_root, coreclock, i, m_procs, m_breakpoints);
-        m_procs[i]->ConnectMemory(m_memory, memadmin);
+        m_procs[i]->ConnectMemory(memclients, memadmin);
         m_procs[i]->ConnectFPU(m_fpus[i / numProcessorsPerFPU]);
 
         if (GetTopSubConfOpt(name, "EnableIO", bool, false)) // I/O disabled unless specified
@@ -802,6 +954,7 @@ MGSystem::MGSystem(Config& config, bool quiet)
     {
         clog << numProcessors << " cores instantiated." << endl;
     }
+    endPhase("cores");
 
     // Create the I/O devices
     vector<string> dev_names = config.getWordList("IODevices");
@@ -885,6 +1038,15 @@ MGSystem::MGSystem(Config& config, bool quiet)
     auto masterfreq = kernel.GetMasterFrequency();
     (void)GetTopConfOpt("MasterFreq", Clock::Frequency, masterfreq); // The lookup will set the config key as side effect
 
+    // Optionally run the simulation processes on multiple host threads.
+    kernel.SetNumThreads(GetTopConfOpt("KernelThreads", size_t, 1));
+
+    // Optionally measure the host time spent in each process,
+    // arbitrator and storage.
+    kernel.SetProfiling(GetTopConfOpt("KernelProfile", bool, false));
+
+    endPhase("I/O devices");
+
     RegisterModelObject(*m_root, "system");
     RegisterModelProperty(*m_root, "version", PACKAGE_VERSION);
     RegisterModelProperty(*m_root, "masterfreq", (uint32_t)masterfreq);
@@ -935,6 +1097,50 @@ MGSystem::MGSystem(Config& config, bool quiet)
         cerr << "Warning: No bootable ROM configured." << endl;
     }
 
+    m_sampler = new Sampler("sampler", *m_root, m_procs, *m_memory, *m_clock);
+
+    // Set up fast-forwarding. This must happen after the ROMs are
+    // loaded, so that the end marker can refer to a program symbol.
+    if (GetTopConfOpt("FastForward", bool, false))
+    {
+        MemAddr marker = 0;
+        auto sym = GetTopConfOpt("FastForwardUntilPC", string, "");
+        if (!sym.empty())
+        {
+            char* end;
+            marker = strtoull(sym.c_str(), &end, 0);
+            if (*end != '\0' && !m_symtable.LookUp(sym, marker, true))
+            {
+                throw runtime_error("Unknown symbol or address for FastForwardUntilPC: " + sym);
+            }
+        }
+        m_ffUntilCycle = GetTopConfOpt("FastForwardUntilCycle", CycleNo, 0);
+
+        for (auto proc : m_procs)
+            proc->SetFastForward(true, marker);
+
+        if (!quiet)
+        {
+            clog << "Fast-forwarding until ";
+            if (marker != 0)
+                clog << "PC " << hex << showbase << marker << dec << noshowbase << ", ";
+            if (m_ffUntilCycle != 0)
+                clog << "cycle " << m_ffUntilCycle << ", ";
+            clog << "or the program's request" << endl;
+        }
+    }
+    else if (m_sampler->IsEnabled())
+    {
+        m_sampler->Start();
+    }
+
+    if (m_sampler->IsEnabled() && !quiet)
+    {
+        clog << "Sampled simulation: every " << GetTopConfOpt("SamplingPeriod", CycleNo, 0)
+             << " cycles, " << GetTopConfOpt("SamplingWarmup", CycleNo, 0) << " cycles of warm-up and "
+             << GetTopConfOpt("SamplingWindow", CycleNo, 0) << " cycles of measurement" << endl;
+    }
+
     if (!quiet)
     {
         clog << endl
@@ -964,6 +1170,7 @@ MGSystem::MGSystem(Config& config, bool quiet)
 
     // Set program debugging per default
     kernel.SetDebugMode(Kernel::DEBUG_PROG);
+    endPhase("initialization");
 
     // Find objdump command
 #if defined(TARGET_MTALPHA)
@@ -1028,8 +1235,22 @@ MGSystem::MGSystem(Config& config, bool quiet)
              << "simulation running at " << dec << masterfreq << " " << qual[q] << "Hz" << endl
              << "Instantiation costs: "
              << ru2.GetUserTime() << " us, "
-             << ru2.GetMaxResidentSize() << " KiB (approx)" << endl;
+             << ru2.GetMaxResidentSize() << " KiB (approx)" << endl
+             << "Startup breakdown:" << endl;
+
+        const ResourceUsage* prev = &ru1;
+        for (auto& p : phases)
+        {
+            clog << "  " << p.first << ": " << (p.second - *prev).GetUserTime() << " us" << endl;
+            prev = &p.second;
+        }
+        clog << "  ";
+        config.dumpLookupStatistics(clog);
+        clog << endl;
     }
+
+    ResourceUsage ru3(true);
+    m_startupTime = ru3.GetUserTime() + ru3.GetSystemTime();
 }
 
 MGSystem::~MGSystem()
@@ -1044,7 +1265,10 @@ MGSystem::~MGSystem()
         delete proc;
     for (auto fpu : m_fpus)
         delete fpu;
+    GetKernel()->GetEventTrace().Close();
+    delete m_sampler;
     delete m_selector;
+    delete m_memoryTrace;
     delete m_memory;
     delete m_root;
 }
@@ -21,6 +21,14 @@ namespace Simulator {
     class IOMessageInterface;
     class DRISC;
     class IMemory;
+    class IMemoryAdmin;
+    class MemoryTraceRecorder;
+    class Sampler;
+
+    // Creates a memory system of the given type (e.g. "SERIAL", "COMA")
+    IMemory* CreateMemory(const std::string& type, Object& parent, Clock& clock, IMemoryAdmin*& admin);
+
+    void PrintMemoryStatistics(const IMemory& memory, std::ostream& os);
 
     class MGSystem
     {
@@ -38,9 +46,18 @@ namespace Simulator {
         SymbolTable                 m_symtable;
         BreakPointManager           m_breakpoints;
         IMemory*                    m_memory;
+        MemoryTraceRecorder*        m_memoryTrace;  ///< Records the requests to memory, if enabled
         std::string                 m_objdump_cmd;
         ActiveROM*                  m_bootrom;
         Selector*                   m_selector;
+        CycleNo                     m_ffUntilCycle; ///< Cycle at which fast-forwarding ends, 0 for none
+        Sampler*                    m_sampler;
+        long long                   m_startupTime;  ///< Host CPU time (us) until the system was constructed
+
+        // Fast-forward mode, see DRISC::SetFastForward()
+        bool IsFastForward() const;
+        bool HasReachedFastForwardEnd() const;
+        void EndFastForward();
 
         // Writes the current configuration into memory and returns its address
         MemAddr WriteConfiguration();
@@ -78,7 +95,7 @@ namespace Simulator {
         void DumpArea(std::ostream& os, size_t tech) const;
 
         void PrintMemoryStatistics(std::ostream& os) const;
-        void PrintState(const std::vector<std::string>& arguments) const;
+        void PrintState(const std::vector<std::string>& arguments);
         void PrintRegFileAsyncPortActivity(std::ostream& os) const;
         void PrintAllFamilyCompletions(std::ostream& os) const;
         void PrintFamilyCompletions(std::ostream& os) const;
@@ -95,6 +112,10 @@ namespace Simulator {
         const SymbolTable& GetSymTable() const { return m_symtable; }
 	BreakPointManager& GetBreakPointManager() { return m_breakpoints; }
 
+        // Sets initial register values for the first thread on all
+        // cores (see DRISC::SetInitialRegisters), before boot
+        void SetInitialRegisters(const std::vector<std::string>& regs);
+
         // Steps the entire system this many cycles
         void Step(CycleNo nCycles);
         void Abort() { GetKernel()->Abort(); }
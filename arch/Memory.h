@@ -7,6 +7,7 @@
 #include <sim/ports.h>
 #include <sim/storage.h>
 #include <sim/inspect.h>
+#include <cstring>
 
 namespace Simulator
 {
@@ -15,51 +16,83 @@ namespace Simulator
 // allocate fixed-size arrays in request buffers.
 static const size_t MAX_MEMORY_OPERATION_SIZE = 64;
 
+// Byte mask of a memory line or operation: bit i is set when byte i is
+// valid or written.
+typedef uint64_t LineMask;
+static_assert(MAX_MEMORY_OPERATION_SIZE <= 64, "LineMask must hold one bit per byte");
+
 struct MemData
 {
-    char    data[MAX_MEMORY_OPERATION_SIZE];
-    bool    mask[MAX_MEMORY_OPERATION_SIZE];
+    char     data[MAX_MEMORY_OPERATION_SIZE];
+    LineMask mask;
     SERIALIZE(a) {
         a & "[md"
             & Serialization::binary(data, MAX_MEMORY_OPERATION_SIZE)
-            & Serialization::bitvec(mask, MAX_MEMORY_OPERATION_SIZE)
+            & mask
             & "]";
     }
 };
 
 namespace line {
 
-    // Utility functions to merge/set lines according to mask
-    template<typename T, typename M, typename S>
-    void blit(T* dst, const T* src, const M* mask, S sz)
+    // The mask of the bytes [offset, offset + size) of a line
+    inline LineMask range(size_t offset, size_t size)
     {
-        for (S i = 0; i < sz; ++i)
-            if (mask[i])
-                dst[i] = src[i];
+        return ((size >= 64) ? ~(LineMask)0 : ((LineMask)1 << size) - 1) << offset;
     }
 
-    template<typename T, typename M, typename S>
-    void blitnot(T* dst, const T* src, const M* mask, S sz)
+    // The mask of all bytes of a line of sz bytes
+    inline LineMask full(size_t sz) { return range(0, sz); }
+
+    // Test whether byte i is set in a mask
+    inline bool test(LineMask mask, size_t i) { return (mask >> i) & 1; }
+
+    // Spreads the 8 bits of a mask byte to the 8 bytes of a word,
+    // byte i becoming 0xff if bit i is set and 0 otherwise.
+    inline uint64_t spread(unsigned bits)
     {
-        for (S i = 0; i < sz; ++i)
-            if (!mask[i])
-                dst[i] = src[i];
+        uint64_t x = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+        x = ((x + 0x7f7f7f7f7f7f7f7fULL) | x) & 0x8080808080808080ULL;
+        return (x >> 7) * 0xff;
     }
 
-    template<typename T, typename M, typename S>
-    void setif(T* dst, const T& src, const M* mask, S sz)
+    // Copy the bytes of src selected by mask into dst. Works on 8
+    // bytes at a time, merging through a spread mask word unless
+    // all or none of them are selected.
+    inline void blit(char* dst, const char* src, LineMask mask, size_t sz)
     {
-        for (S i = 0; i < sz; ++i)
-            if (mask[i])
-                dst[i] = src;
+        mask &= full(sz);
+        for (size_t i = 0; mask != 0; i += 8, mask >>= 8)
+        {
+            const unsigned bits = mask & 0xff;
+            if (bits == 0)
+                continue;
+            if (i + 8 > sz)
+            {
+                // Tail of a line that is not a multiple of 8 bytes
+                for (size_t j = i; j < sz; ++j)
+                    if (test(bits, j - i))
+                        dst[j] = src[j];
+                break;
+            }
+            if (bits == 0xff)
+            {
+                memcpy(dst + i, src + i, 8);
+                continue;
+            }
+            uint64_t d, s;
+            memcpy(&d, dst + i, 8);
+            memcpy(&s, src + i, 8);
+            const uint64_t m = spread(bits);
+            d = (d & ~m) | (s & m);
+            memcpy(dst + i, &d, 8);
+        }
     }
 
-    template<typename T, typename M, typename S>
-    void setifnot(T* dst, const T& src, const M* mask, S sz)
+    // Copy the bytes of src not selected by mask into dst
+    inline void blitnot(char* dst, const char* src, LineMask mask, size_t sz)
     {
-        for (S i = 0; i < sz; ++i)
-            if (!mask[i])
-                dst[i] = src;
+        blit(dst, src, ~mask, sz);
     }
 
 }
@@ -72,7 +105,7 @@ public:
     virtual bool OnMemoryReadCompleted(MemAddr addr, const char* data) = 0;
     virtual bool OnMemoryWriteCompleted(WClientID wid) = 0;
     virtual bool OnMemoryInvalidated(MemAddr addr) = 0;
-    virtual bool OnMemorySnooped(MemAddr /* addr */, const char* /*data*/, const bool* /*mask*/) { return true; }
+    virtual bool OnMemorySnooped(MemAddr /* addr */, const char* /*data*/, LineMask /*mask*/) { return true; }
 
     virtual ~IMemoryCallback() {}
 
@@ -93,6 +126,9 @@ public:
         PERM_DCA_WRITE = 16
     };
 
+    // Implementations call back into the client from their own
+    // processes, and are called from the client's process, so they
+    // declare both accesses (see Kernel::DeclareAccess).
     virtual MCID RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool grouped = false) = 0;
     virtual void UnregisterClient(MCID id) = 0;
     virtual bool Read (MCID id, MemAddr address) = 0;
@@ -100,6 +136,14 @@ public:
 
     virtual void Initialize() {}
 
+    // Functional accesses read and write the memory contents directly,
+    // bypassing the timing model (cf. DRISC::ReadMemory). Memories that
+    // keep their own copies of the data merge them into the result of
+    // a functional read and update them on a functional write, so that
+    // the copies stay coherent with the contents.
+    virtual void OnFunctionalRead (MemAddr /*address*/, void* /*data*/, MemSize /*size*/) const {}
+    virtual void OnFunctionalWrite(MemAddr /*address*/, const void* /*data*/, MemSize /*size*/) {}
+
     virtual ~IMemory() {}
 
     virtual void GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites,
@@ -0,0 +1,292 @@
+#include "Sampler.h"
+#include <arch/Memory.h>
+#include <arch/drisc/DRISC.h>
+#include <sim/config.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace Simulator
+{
+
+static const char* const StatisticNames[Sampler::NUM_STATISTICS] = {
+    "ipc", "loads", "stores", "ext_reads", "ext_writes"
+};
+
+Sampler::Sampler(const string& name, Object& parent, const vector<DRISC*>& procs,
+                 IMemory& memory, const Clock& clock)
+    : Object(name, parent),
+      m_procs(procs),
+      m_memory(memory),
+      m_clock(clock),
+      m_memoryName(dynamic_cast<Simulator::Object&>(memory).GetName()),
+      m_period(GetTopConfOpt("SamplingPeriod", CycleNo, 0)),
+      m_warmup(GetTopConfOpt("SamplingWarmup", CycleNo, 0)),
+      m_window(GetTopConfOpt("SamplingWindow", CycleNo, 0)),
+      InitStateVariable(phase, PHASE_OFF),
+      InitStateVariable(phaseEnd, 0),
+      InitStateVariable(startOps, 0),
+      InitStateVariable(startCycles, 0),
+      InitStateVariable(startLoads, 0),
+      InitStateVariable(startStores, 0),
+      InitStateVariable(startExtReads, 0),
+      InitStateVariable(startExtWrites, 0),
+      InitSampleVariable(windows, SVC_CUMULATIVE),
+      InitSampleVariable(ops, SVC_CUMULATIVE),
+      InitSampleVariable(cycles, SVC_CUMULATIVE)
+{
+    if (m_period != 0 && (m_window == 0 || m_warmup + m_window >= m_period))
+    {
+        throw exceptf<InvalidArgumentException>(*this, "SamplingWindow must be non-zero and SamplingWarmup + SamplingWindow must be less than SamplingPeriod");
+    }
+
+    for (size_t i = 0; i < NUM_STATISTICS; ++i)
+    {
+        m_sum[i] = m_sumSquares[i] = 0;
+        RegisterSampleVariableInObjectWithName(m_sum[i], string(StatisticNames[i]) + "_sum", SVC_CUMULATIVE);
+        RegisterSampleVariableInObjectWithName(m_sumSquares[i], string(StatisticNames[i]) + "_sumsq", SVC_CUMULATIVE);
+    }
+}
+
+void Sampler::GetCounters(uint64_t& ops, CycleNo& cycles, uint64_t& loads, uint64_t& stores,
+                          uint64_t& ext_reads, uint64_t& ext_writes) const
+{
+    ops = 0;
+    for (DRISC* p : m_procs)
+        ops += p->GetPipeline().GetOp();
+    cycles = m_clock.GetCycleNo();
+
+    uint64_t load_bytes = 0, store_bytes = 0;
+    loads = stores = ext_reads = ext_writes = 0;
+    m_memory.GetMemoryStatistics(loads, stores, load_bytes, store_bytes, ext_reads, ext_writes);
+}
+
+// Checks that no requests are left in the L1 caches and the memory
+// system, so that the memory contents are up to date.
+bool Sampler::IsMemoryQuiescent() const
+{
+    for (DRISC* p : m_procs)
+        if (p->HasPendingMemoryRequests())
+            return false;
+
+    const size_t len = m_memoryName.size();
+    auto in_memory = [&](const string& name)
+    {
+        return name.size() > len && name.compare(0, len, m_memoryName) == 0 && (name[len] == '.' || name[len] == ':');
+    };
+
+    for (const Clock* clock = GetKernel()->GetActiveClocks(); clock != NULL; clock = clock->GetNext())
+    {
+        for (const Process* process = clock->GetActiveProcesses(); process != NULL; process = process->GetNext())
+            if (in_memory(process->GetName()))
+                return false;
+        for (const Storage* storage = clock->GetActiveStorages(); storage != NULL; storage = storage->GetNext())
+            if (in_memory(storage->GetName()))
+                return false;
+    }
+    return true;
+}
+
+bool Sampler::HasReachedMarker() const
+{
+    for (DRISC* p : m_procs)
+        if (p->HasReachedFastForwardMarker())
+            return true;
+    return false;
+}
+
+void Sampler::SetFastForward(bool enabled)
+{
+    // All cores switch at once, so that no core accesses memory
+    // directly while another goes through the memory system.
+    for (DRISC* p : m_procs)
+    {
+        p->SetFastForward(enabled);
+        p->SetFastForwardHeld(enabled);
+    }
+}
+
+void Sampler::StartDrain()
+{
+    SetFastForward(true);
+    m_phase    = PHASE_DRAIN;
+    m_phaseEnd = GetKernel()->GetCycleNo() + m_period - m_warmup - m_window;
+    DebugSimWrite("draining memory system; functional warming until cycle %llu", (unsigned long long)m_phaseEnd);
+}
+
+void Sampler::EndDrain()
+{
+    for (DRISC* p : m_procs)
+        p->SetFastForwardHeld(false);
+    m_phase = PHASE_FUNCTIONAL;
+}
+
+void Sampler::StartWindow()
+{
+    GetCounters(m_startOps, m_startCycles, m_startLoads, m_startStores, m_startExtReads, m_startExtWrites);
+    m_phase    = PHASE_MEASURE;
+    m_phaseEnd = GetKernel()->GetCycleNo() + m_window;
+    DebugSimWrite("starting measurement window until cycle %llu", (unsigned long long)m_phaseEnd);
+}
+
+void Sampler::EndWindow()
+{
+    uint64_t ops, loads, stores, ext_reads, ext_writes;
+    CycleNo  cycles;
+    GetCounters(ops, cycles, loads, stores, ext_reads, ext_writes);
+
+    ops        -= m_startOps;
+    cycles     -= m_startCycles;
+    loads      -= m_startLoads;
+    stores     -= m_startStores;
+    ext_reads  -= m_startExtReads;
+    ext_writes -= m_startExtWrites;
+    DebugSimWrite("window ended: %llu instructions in %llu core cycles",
+                  (unsigned long long)ops, (unsigned long long)cycles);
+
+    if (cycles == 0)
+    {
+        // The core clock did not tick; nothing was measured
+        return;
+    }
+
+    double values[NUM_STATISTICS];
+    values[STAT_IPC]        = (double)ops / cycles;
+    values[STAT_LOADS]      = 1000. * loads / cycles;
+    values[STAT_STORES]     = 1000. * stores / cycles;
+    values[STAT_EXT_READS]  = 1000. * ext_reads / cycles;
+    values[STAT_EXT_WRITES] = 1000. * ext_writes / cycles;
+    for (size_t i = 0; i < NUM_STATISTICS; ++i)
+    {
+        m_sum[i]        += values[i];
+        m_sumSquares[i] += values[i] * values[i];
+    }
+
+    ++m_windows;
+    m_ops    += ops;
+    m_cycles += cycles;
+}
+
+void Sampler::Start()
+{
+    assert(IsEnabled());
+    StartDrain();
+}
+
+CycleNo Sampler::GetCyclesToNextPhase() const
+{
+    const CycleNo now = GetKernel()->GetCycleNo();
+    if (m_phase == PHASE_DRAIN || m_phaseEnd <= now)
+    {
+        // Check for the end of the drain every cycle
+        return 1;
+    }
+    return m_phaseEnd - now;
+}
+
+bool Sampler::Update(RunState state)
+{
+    bool resume;
+    switch (state)
+    {
+    case STATE_RUNNING:
+        // The requested cycles were simulated
+        resume = true;
+        break;
+
+    case STATE_ABORTED:
+        // The kernel is stopped by the program's request to end
+        // fast-forwarding, or interrupted.
+        resume = HasReachedMarker();
+        break;
+
+    default:
+        // The kernel is idle when all cores are held while draining,
+        // but then the memory system is empty.
+        resume = (m_phase == PHASE_DRAIN && IsMemoryQuiescent());
+        break;
+    }
+
+    const CycleNo now = GetKernel()->GetCycleNo();
+    for (;;)
+    {
+        switch (m_phase)
+        {
+        case PHASE_DRAIN:
+            if (!IsMemoryQuiescent())
+                return resume;
+            EndDrain();
+            break;
+
+        case PHASE_FUNCTIONAL:
+            if (now < m_phaseEnd && !HasReachedMarker())
+                return resume;
+            SetFastForward(false);
+            m_phase    = PHASE_WARMUP;
+            m_phaseEnd = now + m_warmup;
+            break;
+
+        case PHASE_WARMUP:
+            if (now < m_phaseEnd)
+                return resume;
+            StartWindow();
+            break;
+
+        case PHASE_MEASURE:
+            if (now < m_phaseEnd)
+                return resume;
+            EndWindow();
+            StartDrain();
+            break;
+
+        default:
+            return false;
+        }
+    }
+}
+
+void Sampler::PrintStatistics(ostream& os) const
+{
+    static const char* const descriptions[NUM_STATISTICS] = {
+        "instructions per core cycle",
+        "load reqs. by the L1 cache from L2 per 1000 core cycles",
+        "store reqs. by the L1 cache to L2 per 1000 core cycles",
+        "cache lines read from the ext. mem. interface per 1000 core cycles",
+        "cache lines written to the ext. mem. interface per 1000 core cycles",
+    };
+
+    os << m_windows << "\t# number of measured windows" << endl
+       << m_ops << "\t# instructions executed in the measured windows" << endl
+       << m_cycles << "\t# core cycles in the measured windows" << endl;
+
+    // The confidence intervals assume a normal distribution of the
+    // window means, which holds for a sufficient number (>= 30) of windows.
+    const double n = (double)m_windows;
+    const streamsize precision = os.precision(4);
+    double mean[NUM_STATISTICS];
+    for (size_t i = 0; i < NUM_STATISTICS; ++i)
+    {
+        mean[i] = (n > 0) ? m_sum[i] / n : 0;
+        double ci = numeric_limits<double>::infinity();
+        if (n > 1)
+        {
+            double variance = max(0., (m_sumSquares[i] - m_sum[i] * mean[i]) / (n - 1));
+            ci = 1.96 * sqrt(variance / n);
+        }
+        os << mean[i] << "\t# mean " << descriptions[i] << endl
+           << ci << "\t# 95% confidence interval (+/-) of the mean " << descriptions[i] << endl;
+    }
+
+    if (mean[STAT_IPC] > 0)
+    {
+        uint64_t ops = 0;
+        for (DRISC* p : m_procs)
+            ops += p->GetPipeline().GetOp();
+        os << (uint64_t)(ops / mean[STAT_IPC]) << "\t# estimated core cycles for all executed instructions" << endl;
+    }
+    os.precision(precision);
+}
+
+}
@@ -0,0 +1,125 @@
+// -*- c++ -*-
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <sim/kernel.h>
+#include <sim/sampling.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Simulator
+{
+    class DRISC;
+    class IMemory;
+
+    /// Sampled simulation
+    ///
+    /// The sampler alternates fast-forwarding (cf. DRISC::SetFastForward)
+    /// with short windows of detailed simulation, in the style of
+    /// SMARTS. Every sampling period consists of:
+    ///
+    /// - a drain phase: the cores are in fast-forward mode, but hold
+    ///   their memory accesses until the requests issued by the
+    ///   previous window have left the memory system;
+    ///
+    /// - a functional warming phase: the cores fast-forward, with the
+    ///   L1 caches and the caches of the memory system kept warm by the
+    ///   functional accesses;
+    ///
+    /// - a detailed warm-up phase, which brings the pipelines, queues
+    ///   and memory system back into a representative state;
+    ///
+    /// - a detailed measurement window, over which the IPC and memory
+    ///   statistics are measured.
+    ///
+    /// The window measurements are accumulated into sample variables,
+    /// from which the mean and confidence interval of every statistic
+    /// is estimated for the entire run. A program can end a functional
+    /// warming phase early with the end of fast-forward action
+    /// (cf. ActionInterface), to take a sample at a point of interest.
+    class Sampler : public Object
+    {
+    public:
+        enum Phase
+        {
+            PHASE_OFF,          ///< Sampling has not started
+            PHASE_DRAIN,        ///< Fast-forward, memory accesses held
+            PHASE_FUNCTIONAL,   ///< Fast-forward with functional warming
+            PHASE_WARMUP,       ///< Detailed, not measured
+            PHASE_MEASURE,      ///< Detailed, measured
+        };
+
+        /// The statistics that are estimated, per window
+        enum Statistic
+        {
+            STAT_IPC,           ///< Instructions per core cycle
+            STAT_LOADS,         ///< Load requests to L2 per 1000 core cycles
+            STAT_STORES,        ///< Store requests to L2 per 1000 core cycles
+            STAT_EXT_READS,     ///< Lines read from external memory per 1000 core cycles
+            STAT_EXT_WRITES,    ///< Lines written to external memory per 1000 core cycles
+            NUM_STATISTICS
+        };
+
+    private:
+        const std::vector<DRISC*>& m_procs;
+        IMemory&                   m_memory;
+        const Clock&               m_clock;           ///< Clock by which IPC is measured
+        std::string                m_memoryName;      ///< Name of the memory system object
+        CycleNo                    m_period;          ///< Config: cycles per sampling period
+        CycleNo                    m_warmup;          ///< Config: cycles of detailed warm-up per period
+        CycleNo                    m_window;          ///< Config: cycles of measurement per period
+
+        DefineStateVariable(unsigned, phase);         ///< Current Phase
+        DefineStateVariable(CycleNo,  phaseEnd);      ///< Master cycle at which the phase ends
+        DefineStateVariable(uint64_t, startOps);      ///< Instructions at the start of the window
+        DefineStateVariable(CycleNo,  startCycles);   ///< Core cycles at the start of the window
+        DefineStateVariable(uint64_t, startLoads);    ///< L2 loads at the start of the window
+        DefineStateVariable(uint64_t, startStores);   ///< L2 stores at the start of the window
+        DefineStateVariable(uint64_t, startExtReads); ///< External reads at the start of the window
+        DefineStateVariable(uint64_t, startExtWrites);///< External writes at the start of the window
+
+        // Statistics
+        DefineSampleVariable(uint64_t, windows);      ///< Number of measured windows
+        DefineSampleVariable(uint64_t, ops);          ///< Instructions executed in the windows
+        DefineSampleVariable(CycleNo,  cycles);       ///< Core cycles in the windows
+        double m_sum[NUM_STATISTICS];                 ///< Sum of the per-window values
+        double m_sumSquares[NUM_STATISTICS];          ///< Sum of the squares of the per-window values
+
+        void GetCounters(uint64_t& ops, CycleNo& cycles, uint64_t& loads, uint64_t& stores,
+                         uint64_t& ext_reads, uint64_t& ext_writes) const;
+        bool IsMemoryQuiescent() const;
+        bool HasReachedMarker() const;
+        void SetFastForward(bool enabled);
+        void StartDrain();
+        void EndDrain();
+        void StartWindow();
+        void EndWindow();
+
+    public:
+        Sampler(const std::string& name, Object& parent, const std::vector<DRISC*>& procs,
+                IMemory& memory, const Clock& clock);
+        Sampler(const Sampler&) = delete;
+        Sampler& operator=(const Sampler&) = delete;
+
+        bool IsEnabled() const { return m_period != 0; }
+        bool IsRunning() const { return m_phase != PHASE_OFF; }
+
+        // Starts sampling with a drain phase
+        void Start();
+
+        // Returns the number of master cycles until the next phase
+        // change, to be simulated before Update() is called.
+        CycleNo GetCyclesToNextPhase() const;
+
+        // Moves to the next phase when the current one has ended, given
+        // the result of the last Kernel::Step. Returns false if the
+        // kernel did not stop for the sampler.
+        bool Update(RunState state);
+
+        void PrintStatistics(std::ostream& os) const;
+    };
+}
+
+#endif
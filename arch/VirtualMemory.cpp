@@ -10,6 +10,7 @@
 #include <iostream>
 #include <cstdlib>
 #include <sstream>
+#include <mutex>
 
 using namespace std;
 
@@ -33,6 +34,8 @@ void VirtualMemory::Reserve(MemAddr address, MemSize size, ProcessID pid, int pe
 {
     if (size != 0)
     {
+        lock_guard<mutex> lock(m_rangesLock);
+
         // Check that there is no overlap
         auto p = m_ranges.lower_bound(address);
         if (p != m_ranges.end())
@@ -78,6 +81,7 @@ VirtualMemory::RangeMap::const_iterator VirtualMemory::GetReservationRange(MemAd
 
 void VirtualMemory::Unreserve(MemAddr address, MemSize size)
 {
+    lock_guard<mutex> lock(m_rangesLock);
     auto p = m_ranges.find(address);
     if (p == m_ranges.end())
     {
@@ -100,7 +104,7 @@ void VirtualMemory::Unreserve(MemAddr address, MemSize size)
 void VirtualMemory::UnreserveAll(ProcessID pid)
 {
     // unreserve all ranges belonging to a given process ID
-
+    lock_guard<mutex> lock(m_rangesLock);
     for (auto p = m_ranges.begin(); p != m_ranges.end(); )
     {
         if (p->second.owner == pid)
@@ -124,6 +128,7 @@ bool VirtualMemory::CheckPermissions(MemAddr address, MemSize size, int access)
     }
 #endif
 
+    lock_guard<mutex> lock(m_rangesLock);
     auto p = GetReservationRange(address, size);
     return (p != m_ranges.end() && (p->second.permissions & access) == access);
 }
@@ -142,25 +147,18 @@ void VirtualMemory::Read(MemAddr address, void* _data, MemSize size) const
     size_t  offset = (size_t)(address - base);      // Offset within base block of address
     char*   data   = static_cast<char*>(_data);     // Byte-aligned pointer to destination
 
-    for (auto pos = m_blocks.lower_bound(base); size > 0;)
+    while (size > 0)
     {
-        if (pos == m_blocks.end())
-        {
-            // Rest of address range does not exist, fill with zero
-            fill(data, data + size, 0);
-            break;
-        }
-
-        // Number of bytes to read, initially
-        size_t count = min( (size_t)size, (size_t)BLOCK_SIZE);
+        // Number of bytes to read in this block
+        size_t count = min( (size_t)size, (size_t)BLOCK_SIZE - offset);
 
-        if (pos->first > base) {
+        const Block* block = m_blocks.Find(base);
+        if (block == NULL) {
             // This part of the request does not exist, fill with zero
             fill(data, data + count, 0);
         } else {
             // Read data
-            copy(pos->second.data + offset, pos->second.data + offset + count, data);
-            ++pos;
+            copy(block->data + offset, block->data + offset + count, data);
         }
         size  -= count;
         data  += count;
@@ -186,12 +184,9 @@ void VirtualMemory::Write(MemAddr address, const void* _data, const bool* mask,
     while (size > 0)
     {
         // Find or insert the block
-        auto ins = m_blocks.insert(make_pair(base, Block()));
-
-        auto& pos = ins.first;
-        if (ins.second) {
-            // A new element was inserted, allocate and clear memory
-            memset(pos->second.data, 0, BLOCK_SIZE);
+        bool created;
+        Block* block = m_blocks.Insert(base, created);
+        if (created) {
             m_total_allocated += BLOCK_SIZE;
         }
 
@@ -199,9 +194,12 @@ void VirtualMemory::Write(MemAddr address, const void* _data, const bool* mask,
         size_t count = min( (size_t)size, (size_t)BLOCK_SIZE - offset);
 
         // Write data
-        for (size_t i = 0; i < count; ++i)
-            if (mask == 0 || mask[i])
-                pos->second.data[offset + i] = data[i];
+        if (mask == 0)
+            memcpy(block->data + offset, data, count);
+        else
+            for (size_t i = 0; i < count; ++i)
+                if (mask[i])
+                    block->data[offset + i] = data[i];
 
         size  -= count;
         data  += count;
@@ -212,6 +210,131 @@ void VirtualMemory::Write(MemAddr address, const void* _data, const bool* mask,
     }
 }
 
+void VirtualMemory::WriteLine(MemAddr address, const char* data, LineMask mask, size_t size)
+{
+    assert(size <= MAX_MEMORY_OPERATION_SIZE);
+
+    MemAddr base   = address & -BLOCK_SIZE;
+    size_t  offset = (size_t)(address - base);
+    while (size > 0)
+    {
+        bool created;
+        Block* block = m_blocks.Insert(base, created);
+        if (created) {
+            m_total_allocated += BLOCK_SIZE;
+        }
+
+        size_t count = min(size, (size_t)BLOCK_SIZE - offset);
+        line::blit(block->data + offset, data, mask, count);
+
+        size  -= count;
+        data  += count;
+        mask   = (count < 64) ? mask >> count : 0;
+        base  += BLOCK_SIZE;
+        offset = 0;
+    }
+}
+
+VirtualMemory::BlockTable::BlockTable()
+    : m_root(NULL),
+      m_count(0),
+      m_last(NULL)
+{
+}
+
+VirtualMemory::BlockTable::~BlockTable()
+{
+    Clear();
+}
+
+void VirtualMemory::BlockTable::DeleteNode(Node* node, unsigned level)
+{
+    for (auto e : node->entries)
+    {
+        if (e == NULL)
+            continue;
+        if (level + 1 < LEVELS)
+            DeleteNode(static_cast<Node*>(e), level + 1);
+        else
+            delete static_cast<Page*>(e);
+    }
+    delete node;
+}
+
+void VirtualMemory::BlockTable::Clear()
+{
+    if (m_root != NULL)
+    {
+        DeleteNode(m_root, 0);
+        m_root = NULL;
+    }
+    m_count = 0;
+    m_last = NULL;
+}
+
+const VirtualMemory::Block* VirtualMemory::BlockTable::Find(MemAddr base) const
+{
+    // The cache may be used by several threads of the parallel
+    // kernel at once; pages are never freed while simulating.
+    const Page* last = m_last.load(std::memory_order_relaxed);
+    if (last != NULL && last->base == base)
+        return &last->block;
+
+    MemAddr index = base / BLOCK_SIZE;
+    const Node* node = m_root;
+    for (unsigned level = 0; node != NULL && level + 1 < LEVELS; ++level)
+    {
+        size_t i = (size_t)(index >> ((LEVELS - 1 - level) * LEVEL_BITS)) & (LEVEL_SIZE - 1);
+        node = static_cast<const Node*>(node->entries[i]);
+    }
+    if (node == NULL)
+        return NULL;
+
+    Page* page = static_cast<Page*>(node->entries[index & (LEVEL_SIZE - 1)]);
+    if (page == NULL)
+        return NULL;
+
+    m_last.store(page, std::memory_order_relaxed);
+    return &page->block;
+}
+
+VirtualMemory::Block* VirtualMemory::BlockTable::Insert(MemAddr base, bool& created)
+{
+    created = false;
+    Page* last = m_last.load(std::memory_order_relaxed);
+    if (last != NULL && last->base == base)
+        return &last->block;
+
+    MemAddr index = base / BLOCK_SIZE;
+    if (m_root == NULL)
+        m_root = new Node();
+
+    Node* node = m_root;
+    for (unsigned level = 0; level + 1 < LEVELS; ++level)
+    {
+        void*& e = node->entries[(size_t)(index >> ((LEVELS - 1 - level) * LEVEL_BITS)) & (LEVEL_SIZE - 1)];
+        if (e == NULL)
+            e = new Node();
+        node = static_cast<Node*>(e);
+    }
+
+    void*& e = node->entries[index & (LEVEL_SIZE - 1)];
+    if (e == NULL)
+    {
+        // Allocate and clear memory
+        Page* page = new Page;
+        page->base = base;
+        memset(page->block.data, 0, BLOCK_SIZE);
+        e = page;
+        ++m_count;
+        created = true;
+    }
+
+    Page* page = static_cast<Page*>(e);
+    m_last.store(page, std::memory_order_relaxed);
+    return &page->block;
+}
+
 void VirtualMemory::SetSymbolTable(SymbolTable& symtable)
 {
     m_symtable = &symtable;
@@ -230,7 +353,8 @@ VirtualMemory::VirtualMemory(const std::string& name, Object& parent)
       InitSampleVariable(total_reserved, SVC_LEVEL),
       InitSampleVariable(total_allocated, SVC_LEVEL),
       InitSampleVariable(number_of_ranges, SVC_LEVEL),
-      m_symtable(0)
+      m_symtable(0),
+      m_rangesLock()
 {
     RegisterStateObject(m_blocks, "blocks");
     RegisterStateObject(m_ranges, "ranges");
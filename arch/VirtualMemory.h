@@ -9,7 +9,9 @@
 #include <sim/sampling.h>
 #include <arch/Memory.h>
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace Simulator
@@ -38,7 +40,95 @@ public:
         SERIALIZE(a) { a & size & owner & permissions; }
     };
 
-    typedef std::map<MemAddr, Block> BlockMap;
+    // BlockTable: the allocated blocks, indexed by a radix tree over
+    // the block number. A lookup costs a fixed number of array
+    // accesses, and the last block found is cached as consecutive
+    // accesses tend to hit the same block. The blocks serialize like
+    // a std::map<MemAddr, Block>.
+    class BlockTable
+    {
+        static const unsigned LEVELS     = 4;
+        static const unsigned LEVEL_BITS = 13;
+        static const size_t   LEVEL_SIZE = (size_t)1 << LEVEL_BITS;
+        // The tree indexes the address bits above the 12 bits of offset in a block.
+        static_assert(LEVELS * LEVEL_BITS + 12 >= sizeof(MemAddr) * 8,
+                      "The block table does not cover the address space");
+
+        struct Page
+        {
+            MemAddr base;
+            Block   block;
+        };
+
+        struct Node
+        {
+            void* entries[LEVEL_SIZE]; ///< Nodes of the next level, or Pages in the last level.
+        };
+
+        Node*                      m_root;
+        size_t                     m_count; ///< Number of allocated blocks.
+        mutable std::atomic<Page*> m_last;  ///< The last page looked up.
+
+        static void DeleteNode(Node* node, unsigned level);
+        template<typename F>
+        static void VisitNode(const Node* node, unsigned level, F& f)
+        {
+            for (auto e : node->entries)
+            {
+                if (e == NULL)
+                    continue;
+                if (level + 1 < LEVELS)
+                    VisitNode(static_cast<const Node*>(e), level + 1, f);
+                else
+                    f(static_cast<const Page*>(e)->base, static_cast<const Page*>(e)->block);
+            }
+        }
+
+    public:
+        BlockTable();
+        ~BlockTable();
+        BlockTable(const BlockTable&) = delete;
+        BlockTable& operator=(const BlockTable&) = delete;
+
+        // Returns the block at the given block-aligned address, or NULL.
+        const Block* Find(MemAddr base) const;
+
+        // Returns the block at the given block-aligned address, after
+        // allocating it with zeroes if needed. Sets created accordingly.
+        Block* Insert(MemAddr base, bool& created);
+
+        // Removes all blocks.
+        void Clear();
+
+        size_t size() const { return m_count; }
+
+        // Calls f(base, block) for all blocks, in address order.
+        template<typename F>
+        void ForEach(F f) const { if (m_root != NULL) VisitNode(m_root, 0, f); }
+
+        SERIALIZE(a)
+        {
+            std::vector<std::pair<MemAddr, Block> > vec;
+            if (a.reading())
+            {
+                vec.reserve(m_count);
+                ForEach([&](MemAddr base, const Block& b) { vec.push_back(std::make_pair(base, b)); });
+            }
+
+            a & vec;
+
+            if (a.reading())
+                return;
+
+            Clear();
+            for (auto& p : vec)
+            {
+                bool created;
+                *Insert(p.first, created) = p.second;
+            }
+        }
+    };
+
     typedef std::map<MemAddr, Range> RangeMap;
 
     void Reserve(MemAddr address, MemSize size, ProcessID pid, int perm) override;
@@ -51,6 +141,10 @@ public:
     // to NULL, then write all bytes.
     void Write(MemAddr address, const void* data, const bool* mask, MemSize size) override;
 
+    // Writes the bytes of a memory line (at most MAX_MEMORY_OPERATION_SIZE
+    // bytes) selected by mask.
+    void WriteLine(MemAddr address, const char* data, LineMask mask, size_t size);
+
     bool CheckPermissions(MemAddr address, MemSize size, int access) const override;
 
     VirtualMemory(const std::string& name, Object& parent);
@@ -66,13 +160,19 @@ private:
     RangeMap::const_iterator GetReservationRange(MemAddr address, MemSize size) const;
     void ReportOverlap(MemAddr address, MemSize size) const;
 
-    DefineStateVariable(BlockMap, blocks);
+    DefineStateVariable(BlockTable, blocks);
     DefineStateVariable(RangeMap, ranges);
 
     DefineSampleVariable(size_t, total_reserved);
     DefineSampleVariable(size_t, total_allocated);
     DefineSampleVariable(size_t, number_of_ranges);
     SymbolTable *m_symtable;
+
+    // The cores reserve and check ranges from their own processes,
+    // which the parallel kernel may run concurrently. The result is
+    // the same as with the serial kernel unless a core accesses a
+    // range in the cycle that another core maps or unmaps it.
+    mutable std::mutex m_rangesLock; ///< Protects m_ranges and its counters.
 };
 
 }
@@ -145,7 +145,9 @@ namespace Simulator
           m_start_address(0),
           m_legacy(false),
           InitStateVariable(booting, false),
-          m_preloaded_at_boot(GetConf("PreloadROMToRAM", bool)),
+          // In fast-forward mode the cores read memory directly, so
+          // the contents cannot be loaded through the memory system.
+          m_preloaded_at_boot(GetConf("PreloadROMToRAM", bool) || GetTopConfOpt("FastForward", bool, false)),
           m_devid(devid),
           m_ioif(ioif),
           m_clock(m_ioif.RegisterClient(devid, *this)),
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 
 using namespace std;
 
@@ -294,6 +295,16 @@ namespace Simulator
           m_logical_screen_pixels(),
           m_sdl_enabled(false),
           m_sdl_context(new SDLContext),
+          m_xmap(),
+          m_screen_version(0),
+          m_capture_prefix(GetConfOpt("GfxCaptureFile", string, "")),
+          m_capture_interval(GetConfOpt("GfxCaptureInterval", CycleNo, 0)),
+          m_capture_changes(GetConfOpt("GfxCaptureOnlyChanges", bool, true)),
+          m_capture_raw(false),
+          m_next_capture(0),
+          m_captured_version(0),
+          m_capture_row(),
+          InitSampleVariable(captured_frames, SVC_CUMULATIVE),
           InitStateVariable(logical_width, 640),
           InitStateVariable(logical_height, 400),
           InitStateVariable(command_offset, 0),
@@ -306,7 +317,7 @@ namespace Simulator
         {
             DisplayManager::CreateManagerIfNotExists(*GetKernel()->GetConfig());
             auto dm = DisplayManager::GetManager();
-            if (dm == NULL || !dm->IsSDLInitialized())
+            if (dm == NULL || !dm->InitSDL())
                 cerr << "# " << GetName() << ": unable to use SDL, output to screen disabled" << endl;
             else
             {
@@ -319,13 +330,27 @@ namespace Simulator
             }
         }
 
+        if (!m_capture_prefix.empty())
+        {
+            string format = GetConfOpt("GfxCaptureFormat", string, "ppm");
+            if (format == "raw")
+                m_capture_raw = true;
+            else if (format != "ppm")
+                throw exceptf<InvalidArgumentException>(*this, "Unknown capture format: %s", format.c_str());
+
+            DisplayManager::CreateManagerIfNotExists(*GetKernel()->GetConfig());
+            DisplayManager::GetManager()->RegisterCapture(this);
+        }
     }
 
     Display::~Display()
     {
         auto dm = DisplayManager::GetManager();
         if (dm != NULL)
+        {
             dm->UnregisterDisplay(this);
+            dm->UnregisterCapture(this);
+        }
         CloseWindow();
         delete m_sdl_context;
         m_sdl_context = 0;
@@ -343,6 +368,69 @@ namespace Simulator
             memset(&m_logical_screen_pixels[0], 0, w * h * sizeof(m_logical_screen_pixels[0]));
 
         m_logical_screen_resized = true;
+        m_video_memory_updated = true;
+    }
+
+    void Display::Capture(CycleNo cycle)
+    {
+        if (cycle < m_next_capture)
+            return;
+        m_next_capture = (m_capture_interval == 0) ? cycle + 1
+            : (cycle / m_capture_interval + 1) * m_capture_interval;
+
+        if (m_video_memory_updated)
+        {
+            // Repaint here, as without SDL nothing else does. The
+            // window, if any, is then updated from the repainted
+            // screen.
+            m_video_memory_updated = false;
+            PrepareLogicalScreen();
+        }
+
+        if (m_logical_screen_pixels.size() < (size_t)m_logical_width * m_logical_height)
+            // The software has not set a resolution yet.
+            return;
+
+        if (m_capture_changes && m_screen_version == m_captured_version)
+            return;
+        m_captured_version = m_screen_version;
+
+        WriteCapture(cycle);
+    }
+
+    void Display::WriteCapture(CycleNo cycle)
+    {
+        // One file per frame, numbered from 0
+        char num[32];
+        snprintf(num, sizeof(num), ".%06llu", (unsigned long long)m_captured_frames);
+        string fname = m_capture_prefix + num;
+        if (m_capture_raw)
+            fname += '.' + to_string(m_logical_width) + 'x' + to_string(m_logical_height) + ".rgb";
+        else
+            fname += ".ppm";
+
+        ofstream os(fname.c_str(), ios_base::out | ios_base::trunc | ios_base::binary);
+        if (!m_capture_raw)
+        {
+            os << "P6" << endl
+               << "# " << GetName() << " at cycle " << cycle << endl
+               << m_logical_width << ' ' << m_logical_height << ' ' << 255 << endl;
+        }
+
+        m_capture_row.resize(m_logical_width * 3);
+        for (unsigned y = 0; y < m_logical_height; ++y)
+        {
+            ConvertRowToRGB24(&m_capture_row[0], &m_logical_screen_pixels[y * m_logical_width], m_logical_width);
+            os.write((const char*)&m_capture_row[0], m_capture_row.size());
+        }
+
+        if (!os.good())
+        {
+            cerr << "# " << GetName() << ": unable to write " << fname << ", capture disabled" << endl;
+            DisplayManager::GetManager()->UnregisterCapture(this);
+            return;
+        }
+        ++m_captured_frames;
     }
 
     void Display::DumpLogicalScreen(unsigned key, int stream, bool gen_ts)
@@ -564,6 +652,17 @@ namespace Simulator
         remove(m_displays.begin(), m_displays.end(), disp);
     }
 
+    void DisplayManager::RegisterCapture(Display *disp)
+    {
+        if (find(m_captures.begin(), m_captures.end(), disp) == m_captures.end())
+            m_captures.push_back(disp);
+    }
+
+    void DisplayManager::UnregisterCapture(Display *disp)
+    {
+        m_captures.erase(remove(m_captures.begin(), m_captures.end(), disp), m_captures.end());
+    }
+
     void DisplayManager::GetMaxWindowSize(unsigned& w, unsigned& h)
     {
         if (!m_sdl_initialized)
@@ -598,23 +697,38 @@ namespace Simulator
 
     DisplayManager::DisplayManager(unsigned refreshDelay)
         : m_sdl_initialized(false),
+          m_sdl_tried(false),
           m_refreshDelay_orig(refreshDelay),
           m_refreshDelay(refreshDelay),
           m_lastUpdate(0),
-          m_displays()
+          m_displays(),
+          m_captures()
     {
+    }
+
+    bool DisplayManager::InitSDL()
+    {
+        if (m_sdl_tried)
+            return m_sdl_initialized;
+        m_sdl_tried = true;
+
         if (SDL_Init(SDL_INIT_VIDEO) != 0)
         {
             cerr << "# unable to set up SDL: " << SDL_GetError() << endl;
-            return;
+            return false;
         }
         m_sdl_initialized = true;
         if (SDL_HasQuit)
             atexit(SDL_Quit);
+        return true;
     }
 
     void DisplayManager::CheckEvents()
     {
+        if (!m_sdl_initialized)
+            // Only capturing displays, nothing to show
+            return;
+
         SDL_Event event;
         while (SDL_PollEvent(&event))
         {
@@ -79,6 +79,19 @@ namespace Simulator
         bool                  m_sdl_enabled;
         SDLContext*           m_sdl_context;
 
+        std::vector<unsigned> m_xmap;             ///< Texture column to sample for each screen column
+        uint64_t              m_screen_version;   ///< Incremented each time the logical screen is painted
+
+        // Headless capture of the logical screen to files
+        std::string           m_capture_prefix;   ///< File name prefix of captured frames, empty if disabled
+        CycleNo               m_capture_interval; ///< Cycles between captures, 0 for every cycle
+        bool                  m_capture_changes;  ///< Only capture frames that differ from the last one
+        bool                  m_capture_raw;      ///< Write raw RGB data instead of PPM images
+        CycleNo               m_next_capture;     ///< Cycle of the next capture
+        uint64_t              m_captured_version; ///< m_screen_version of the last captured frame
+        std::vector<uint8_t>  m_capture_row;      ///< Scratch row for the RGB conversion
+        DefineSampleVariable(uint64_t, captured_frames);
+
         DefineStateVariable(unsigned int, logical_width);
         DefineStateVariable(unsigned int, logical_height);
         DefineStateVariable(uint32_t, command_offset);
@@ -107,6 +120,14 @@ namespace Simulator
         void PrepareLogicalScreen();
         // Dump the logical screen pixels to file/stream
         void DumpLogicalScreen(unsigned key, int stream, bool gen_timestamp);
+        // Convert a row of XRGB pixels to packed 24-bit RGB.
+        static void ConvertRowToRGB24(uint8_t* dst, const uint32_t* src, unsigned w);
+
+        // Capture the logical screen to a file if due at this cycle
+        // (used by DisplayManager).
+        void Capture(CycleNo cycle);
+        // Write the logical screen to the next capture file.
+        void WriteCapture(CycleNo cycle);
 
         // Perform the rendering pipeline to the screen
         void Show();
@@ -141,14 +162,27 @@ namespace Simulator
         void RegisterDisplay(Display *disp);
         void UnregisterDisplay(Display *disp);
 
+        // RegisterCapture/UnregisterCapture: register/unregister a
+        // display instance that captures its screen to files.
+        void RegisterCapture(Display *disp);
+        void UnregisterCapture(Display *disp);
+
+        // InitSDL: initialize SDL for the displays that render to a
+        // window, if not done already. Returns whether SDL is available.
+        bool InitSDL();
+
         // GetMaxWindowSize: retrieve the largest possible resolution
         // for a window.
         void GetMaxWindowSize(unsigned& w, unsigned& h);
 
         // OnCycle(): only call CheckEvents (which is expensive) every
         // m_refreshDelay cycles.  Called by Kernel::Step().
+        // Also lets capturing displays check whether a frame is due.
         void OnCycle(CycleNo cycle)
         {
+            for (auto d : m_captures)
+                d->Capture(cycle);
+
             if (m_lastUpdate + m_refreshDelay > cycle)
                 return;
             m_lastUpdate = cycle;
@@ -178,10 +212,12 @@ namespace Simulator
 
     protected:
         bool                   m_sdl_initialized;    ///< Whether SDL is available
+        bool                   m_sdl_tried;          ///< Whether InitSDL was called
         unsigned               m_refreshDelay_orig; ///< Initial refresh delay from config
         unsigned               m_refreshDelay;      ///< Current refresh delay as set by user
         CycleNo                m_lastUpdate;        ///< Cycle number of last check
         std::vector<Display*>  m_displays;          ///< Currently registered Display instances
+        std::vector<Display*>  m_captures;          ///< Display instances that capture to files
         static DisplayManager* g_singleton;         ///< Singleton instance
 
 
@@ -1,7 +1,62 @@
 #include <arch/dev/Display.h>
 
+#include <algorithm>
+
 namespace Simulator
 {
+    // Conversions of the direct color pixel formats to the XRGB
+    // format of the logical screen. The channels are scaled with
+    // integer arithmetic which yields the same values as scaling by
+    // 255/max in single precision, including the rounding down of
+    // the largest green value in RGB565.
+    static inline uint32_t FromRGB565(uint16_t color)
+    {
+        uint32_t r = (color >> 11) & 0x1f;
+        uint32_t g = (color >> 5) & 0x3f;
+        uint32_t b = color & 0x1f;
+        r = (r * 8 * 1053) >> 10;
+        g = std::min(g * 255 / 63, 254u);
+        b = (b * 8 * 1053) >> 10;
+        return (r << 16) | (g << 8) | b;
+    }
+
+    static inline uint32_t FromRGB332(uint8_t color)
+    {
+        uint32_t r = (color >> 5) & 0x7;
+        uint32_t g = (color >> 2) & 0x7;
+        uint32_t b = color & 0x3;
+        r = (r * 32 * 1165) >> 10;
+        g = (g * 32 * 1165) >> 10;
+        b = b * 85;
+        return (r << 16) | (g << 8) | b;
+    }
+
+    // Row conversion kernel: fills w pixels of dst with fetch(sx),
+    // where sx is the source column given by xmap, or the destination
+    // column itself when xmap is NULL. The fetch functions are small
+    // enough to be inlined, so that the unscaled loop vectorizes.
+    template<typename Fetch>
+    static inline void ConvertRow(uint32_t* __restrict__ dst, const unsigned* __restrict__ xmap,
+                                  unsigned w, const Fetch& fetch)
+    {
+        if (xmap == NULL)
+            for (unsigned dx = 0; dx < w; ++dx)
+                dst[dx] = fetch(dx);
+        else
+            for (unsigned dx = 0; dx < w; ++dx)
+                dst[dx] = fetch(xmap[dx]);
+    }
+
+    void Display::ConvertRowToRGB24(uint8_t* __restrict__ dst, const uint32_t* __restrict__ src, unsigned w)
+    {
+        for (unsigned x = 0; x < w; ++x)
+        {
+            dst[x * 3]     = src[x] >> 16;
+            dst[x * 3 + 1] = src[x] >> 8;
+            dst[x * 3 + 2] = src[x];
+        }
+    }
+
     void Display::PrepareLogicalScreen()
     {
         auto vsz = m_video_memory.size();
@@ -112,6 +167,18 @@ namespace Simulator
                     if (dst_y + dst_h > m_logical_height)
                         dst_h = m_logical_height - dst_y;
 
+                    // Columns of the texture to sample for each
+                    // column on screen; unscaled textures are read
+                    // contiguously.
+                    const unsigned* xmap = NULL;
+                    if (scale_x != 1.0)
+                    {
+                        m_xmap.resize(dst_w);
+                        for (unsigned dx = 0; dx < dst_w; ++dx)
+                            m_xmap[dx] = dx * scale_x;
+                        xmap = &m_xmap[0];
+                    }
+
                     // Now the rendering per se
                     if (bpp == 32 && !indexed)
                     {
@@ -121,12 +188,8 @@ namespace Simulator
                         {
                             unsigned sy = dy * scale_y;
                             const uint32_t* __restrict__ src = src_base + (src_y + sy) * src_pitch + src_x;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                dst[dx] = src[sx];
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src](unsigned sx) { return src[sx]; });
                         }
                     }
                     else if (bpp == 24 && !indexed)
@@ -137,126 +200,88 @@ namespace Simulator
                         {
                             unsigned sy = dy * scale_y;
                             const uint8_t* __restrict__ src = src_base + ((src_y + sy) * src_pitch + src_x) * 3;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                dst[dx] = (((uint32_t)src[sx * 3]) << 16)
-                                    | (((uint32_t)src[sx * 3 + 1]) << 8)
-                                    | (((uint32_t)src[sx * 3 + 2]));
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src](unsigned sx) {
+                                           return (((uint32_t)src[sx * 3]) << 16)
+                                               | (((uint32_t)src[sx * 3 + 1]) << 8)
+                                               | (((uint32_t)src[sx * 3 + 2]));
+                                       });
                         }
                     }
                     else if (bpp == 16 && !indexed)
                     {
                         // 16-bit RGB, "64K colors", akin to SDL_PIXELFORMAT_RGB565
-                        static constexpr float Rf = 0xff / (float)0xf8;
-                        static constexpr float Gf = 0xff / (float)0xfc;
-                        static constexpr float Bf = Rf;
                         const uint16_t* src_base = (const uint16_t*)(const void*)&m_video_memory[src_start];
                         for (unsigned dy = 0; dy < dst_h; ++dy)
                         {
                             unsigned sy = dy * scale_y;
                             const uint16_t* __restrict__ src = src_base + (src_y + sy) * src_pitch + src_x;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                uint16_t color = src[sx];
-                                dst[dx] = (((uint32_t)(((color & 0xf800) >> 8) * Rf)) << 16)
-                                    | (((uint32_t)(((color & 0x07e0) >> 3) * Gf)) << 8)
-                                    | (((uint32_t)(((color & 0x001f) << 3) * Bf)));
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src](unsigned sx) { return FromRGB565(src[sx]); });
                         }
                     }
                     else if (bpp == 16 && indexed && palette_offset != 0 && palette_ncolors >= 65536)
                     {
                         // 16-bit indexed (palette with 64K entries, uncommon)
                         const uint16_t* src_base = (const uint16_t*)(const void*)&m_video_memory[src_start];
+                        const uint32_t* palette = v32 + palette_offset;
                         for (unsigned dy = 0; dy < dst_h; ++dy)
                         {
                             unsigned sy = dy * scale_y;
                             const uint16_t* __restrict__ src = src_base + (src_y + sy) * src_pitch + src_x;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                uint16_t index = src[sx];
-                                dst[dx] = v32[palette_offset + index];
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src, palette](unsigned sx) { return palette[src[sx]]; });
                         }
                     }
                     else if (bpp == 8 && !indexed)
                     {
                         // 8-bit RGB "lowcolor", akin to SDL_PIXELFORMAT_RGB332, compact but uncommon
-                        static constexpr float Rf = 0xff / (float)0xe0;
-                        static constexpr float Gf = Rf;
-                        static constexpr float Bf = 0xff / (float)0xc0;
                         const uint8_t* src_base = (const uint8_t*)(const void*)&m_video_memory[src_start];
                         for (unsigned dy = 0; dy < dst_h; ++dy)
                         {
                             unsigned sy = dy * scale_y;
                             const uint8_t* __restrict__ src = src_base + (src_y + sy) * src_pitch + src_x;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                uint8_t color = src[sx];
-                                dst[dx] = ((uint32_t)(((color & 0xe0) * Rf)) << 16)
-                                    | (((uint32_t)(((color & 0x1c) << 3) * Gf)) << 8)
-                                    | (((uint32_t)(((color & 0x03) << 6) * Bf)));
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src](unsigned sx) { return FromRGB332(src[sx]); });
                         }
                     }
                     else if (bpp == 8 && indexed && palette_offset != 0 && palette_ncolors >= 256)
                     {
                         // 8-bit indexed (palette with 256 entries), compact & common
                         const uint8_t* src_base = (const uint8_t*)(const void*)&m_video_memory[src_start];
+                        const uint32_t* palette = v32 + palette_offset;
                         for (unsigned dy = 0; dy < dst_h; ++dy)
                         {
                             unsigned sy = dy * scale_y;
                             const uint8_t* __restrict__ src = src_base + (src_y + sy) * src_pitch + src_x;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                uint8_t index = src[sx];
-                                dst[dx] = v32[palette_offset + index];
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src, palette](unsigned sx) { return palette[src[sx]]; });
                         }
                     }
                     else if (bpp == 4 && indexed && palette_offset != 0 && palette_ncolors >= 16)
                     {
                         // 4-bit indexed (palette with 16 entries), akin to VGA/EGA "16 color mode"
                         const uint8_t* src_base = (const uint8_t*)(const void*)&m_video_memory[src_start];
+                        const uint32_t* palette = v32 + palette_offset;
                         for (unsigned dy = 0; dy < dst_h; ++dy)
                         {
                             unsigned sy = dy * scale_y;
                             const uint8_t* __restrict__ src = src_base + (src_y + sy) * src_pitch / 2 + src_x / 2;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                uint8_t index = (src[sx / 2] >> (4 * (sx % 2))) & 0xf;
-                                dst[dx] = v32[palette_offset + index];
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src, palette](unsigned sx) { return palette[(src[sx / 2] >> (4 * (sx % 2))) & 0xf]; });
                         }
                     }
                     else if (bpp == 1 && indexed && palette_offset != 0 && palette_ncolors >= 2)
                     {
                         // 1-bit indexed (palette with 2 entries) "mononochrome"
                         const uint8_t* src_base = (const uint8_t*)(const void*)&m_video_memory[src_start];
+                        const uint32_t* palette = v32 + palette_offset;
                         for (unsigned dy = 0; dy < dst_h; ++dy)
                         {
                             unsigned sy = dy * scale_y;
                             const uint8_t* __restrict__ src = src_base + (src_y + sy) * src_pitch / 8 + src_x / 8;
-                            uint32_t* __restrict__ dst = dst_base + (dst_y + dy) * dst_pitch + dst_x;
-                            for (unsigned dx = 0; dx < dst_w; ++dx)
-                            {
-                                unsigned sx = dx * scale_x;
-                                uint8_t index = (src[sx / 8] >> (sx % 8)) & 1;
-                                dst[dx] = v32[palette_offset + index];
-                            }
+                            ConvertRow(dst_base + (dst_y + dy) * dst_pitch + dst_x, xmap, dst_w,
+                                       [src, palette](unsigned sx) { return palette[(src[sx / 8] >> (sx % 8)) & 1]; });
                         }
                     }
                     else
@@ -269,6 +294,7 @@ namespace Simulator
         }
 
         m_logical_screen_updated = true;
+        ++m_screen_version;
     }
 
 }
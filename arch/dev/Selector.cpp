@@ -107,6 +107,9 @@ namespace Simulator
             throw exceptf<InvalidArgumentException>(*this, "Handler already registered for fd %d", fd);
         }
 
+        // The client is notified from the selector's process.
+        GetKernel()->DeclareAccess(GetName(), callback.GetSelectorClientName());
+
         ev::io * &ev = Event::handlers[fd];
 
         assert(Event::evbase != NULL);
@@ -1,4 +1,5 @@
 #include "ActionInterface.h"
+#include "DRISC.h"
 #include <cctype>
 #include <sstream>
 
@@ -19,9 +20,11 @@ namespace drisc
  *                     - 1 0 -> abort
  *                     - 1 1 -> exit
  *    maximum address: 1 1 1
+ *
+ *   word 8 -> end fast-forward mode on all cores (value ignored)
  */
 
-size_t ActionInterface::GetSize() const { return 8 * sizeof(Integer);  }
+size_t ActionInterface::GetSize() const { return 9 * sizeof(Integer);  }
 
 
 Result ActionInterface::Read (MemAddr /*address*/, void* /*data*/, MemSize /*size*/, LFID /*fid*/, TID /*tid*/, const RegAddr& /*writeback*/)
@@ -37,6 +40,13 @@ Result ActionInterface::Write(MemAddr address, const void *data, MemSize size, L
     }
 
     address /= sizeof(Integer);
+    if (address == 8)
+    {
+        DebugProgWrite("F%u/T%u END FAST-FORWARD", (unsigned)fid, (unsigned)tid);
+        COMMIT{ GetDRISC().OnFastForwardMarker(); }
+        return SUCCESS;
+    }
+
     Integer value = UnserializeRegister(RT_INTEGER, data, size);
 
     if (address & 4)
@@ -18,6 +18,9 @@ public:
 
     Result Read (MemAddr address, void* data, MemSize size, LFID fid, TID tid, const RegAddr& writeback);
     Result Write(MemAddr address, const void* data, MemSize size, LFID fid, TID tid);
+
+private:
+    Object& GetDRISCParent() const { return *GetParent(); }
 };
 
 }
@@ -1472,7 +1472,7 @@ Result Allocator::DoBundle()
         }
 
         Result      result;
-        if ((result = m_dcache.Read(info.addr, &m_bundleData[0], sizeof(Integer) * 2 + sizeof(MemAddr), 0)) == FAILED)
+        if ((result = m_dcache.Read(info.addr, &m_bundleData[0], sizeof(Integer) * 2 + sizeof(MemAddr), 0, 0)) == FAILED)
         {
             DeadlockWrite("Unable to fetch the D-Cache line for %#016llx for bundle creation", (unsigned long long)info.addr);
             return FAILED;
@@ -1878,15 +1878,15 @@ Result Allocator::DoFamilyCreate()
 Result Allocator::DoThreadActivation()
 {
     TID tid;
-    if ((m_prevReadyList == &m_readyThreadsOther || m_readyThreadsOther.Empty()) && !m_readyThreadsPipe.Empty()) {
+    if ((m_prevReadyOther || m_readyThreadsOther.Empty()) && !m_readyThreadsPipe.Empty()) {
         tid = m_readyThreadsPipe.Front();
         m_readyThreadsPipe.Pop();
-        COMMIT{ m_prevReadyList = &m_readyThreadsPipe; }
+        COMMIT{ m_prevReadyOther = false; }
     } else {
         assert(!m_readyThreadsOther.Empty());
         tid = m_readyThreadsOther.Front();
         m_readyThreadsOther.Pop();
-        COMMIT{ m_prevReadyList = &m_readyThreadsOther; }
+        COMMIT{ m_prevReadyOther = true; }
     }
     COMMIT{ --m_numThreadsPerState[TST_READY]; }
 
@@ -2005,7 +2005,7 @@ Allocator::Allocator(const string& name, DRISC& parent, Clock& clock)
     InitStateVariable(createLine, 0),
     InitStorage(m_readyThreadsPipe, clock, m_threadTable),
     InitStorage(m_readyThreadsOther, clock, m_threadTable),
-    m_prevReadyList (NULL),
+    InitStateVariable(prevReadyOther, false),
 
     InitBuffer(m_allocRequestsSuspend, clock, "FamilyAllocationSuspendQueueSize"),
     InitBuffer(m_allocRequestsNoSuspend, clock, "FamilyAllocationNoSuspendQueueSize"),
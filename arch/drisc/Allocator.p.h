@@ -207,7 +207,7 @@ private:
     DefineStateVariable(CID, createLine);            ///< Cache line that holds the register info
     ThreadList            m_readyThreadsPipe;        ///< Queue of the threads can be activated; from the pipeline
     ThreadList            m_readyThreadsOther;       ///< Queue of the threads can be activated; from the rest
-    ThreadList*           m_prevReadyList;           ///< Which ready list was used last cycle. For round-robin prioritization.
+    DefineStateVariable(bool, prevReadyOther);       ///< Whether m_readyThreadsOther was used last cycle. For round-robin prioritization.
 
     // The family allocation request queues
     Buffer<AllocRequest>  m_allocRequestsSuspend;        ///< Non-exclusive requests that want to suspend.
@@ -91,6 +91,7 @@ namespace drisc
         }
 
         m_registers.resize(m_numRegisters, 0);
+        RegisterStateVariable(m_registers, "registers");
 
         if (name == "asrs")
         {
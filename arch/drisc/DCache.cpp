@@ -1,5 +1,6 @@
 #include <arch/drisc/DCache.h>
 #include <arch/drisc/DRISC.h>
+#include <arch/drisc/Prefetcher.h>
 #include <sim/log2.h>
 #include <sim/config.h>
 #include <sim/sampling.h>
@@ -16,23 +17,37 @@ namespace Simulator
 namespace drisc
 {
 
+static const TraceEventType EV_READ_HIT ("dcache.read.hit",  {"address", "size", "pc"});
+static const TraceEventType EV_READ_MISS("dcache.read.miss", {"address", "size", "pc"});
+static const TraceEventType EV_WRITE    ("dcache.write",     {"address", "size", "tid"});
+static const TraceEventType EV_FILL     ("dcache.fill",      {"address", "mshr"});
+
 DCache::DCache(const std::string& name, DRISC& parent, Clock& clock)
 :   Object(name, parent),
     m_memory(NULL),
     m_mcid(0),
     m_lines(),
     m_data(),
-    m_valid(0),
 
     m_assoc          (GetConf("Associativity", size_t)),
     m_sets           (GetConf("NumSets", size_t)),
     m_lineSize       (GetTopConf("CacheLineSize", size_t)),
     m_selector       (IBankSelector::makeSelector(*this, GetConf("BankSelector", string), m_sets)),
+    m_array          (*this, m_sets, m_assoc, GetConfOpt("ReplacementPolicy", string, "LRU")),
     InitBuffer(m_read_responses, clock, "ReadResponsesBufferSize"),
     InitBuffer(m_write_responses, clock, "WriteResponsesBufferSize"),
     InitBuffer(m_writebacks, clock, "ReadWritebacksBufferSize"),
     InitBuffer(m_outgoing, clock, "OutgoingBufferSize"),
     m_wbstate(),
+    m_prefetcher     (Prefetcher::makePrefetcher(*this, m_lineSize)),
+    InitStorage(m_prefetches, clock, GetConfOpt("PrefetchBufferSize", BufferSize, 2)),
+    m_prefetchIndex(0),
+    m_mshrs(),
+    m_lineMSHRs(false),
+    m_wcb(),
+    InitStorage(m_wcbQueue, clock, std::max<BufferSize>(GetConfOpt("NumWriteCombineEntries", BufferSize, 0), 1)),
+    m_wcbDelay       (GetConfOpt("WriteCombineDelay", CycleNo, 4)),
+    m_wcbAckIndex(0),
     InitSampleVariable(numRHits, SVC_CUMULATIVE),
     InitSampleVariable(numDelayedReads, SVC_CUMULATIVE),
     InitSampleVariable(numEmptyRMisses, SVC_CUMULATIVE),
@@ -47,11 +62,20 @@ DCache::DCache(const std::string& name, DRISC& parent, Clock& clock)
     InitSampleVariable(numStallingRMisses, SVC_CUMULATIVE),
     InitSampleVariable(numStallingWMisses, SVC_CUMULATIVE),
     InitSampleVariable(numSnoops, SVC_CUMULATIVE),
+    InitSampleVariable(numPrefetches, SVC_CUMULATIVE),
+    InitSampleVariable(numUsefulPrefetches, SVC_CUMULATIVE),
+    InitSampleVariable(numLatePrefetches, SVC_CUMULATIVE),
+    InitSampleVariable(numUselessPrefetches, SVC_CUMULATIVE),
+    InitSampleVariable(numDroppedPrefetches, SVC_CUMULATIVE),
+    InitSampleVariable(numMSHRStalls, SVC_CUMULATIVE),
+    InitSampleVariable(numCombinedWrites, SVC_CUMULATIVE),
 
     InitProcess(p_ReadWritebacks, DoReadWritebacks),
     InitProcess(p_ReadResponses, DoReadResponses),
     InitProcess(p_WriteResponses, DoWriteResponses),
     InitProcess(p_Outgoing, DoOutgoingRequests),
+    InitProcess(p_Prefetches, DoPrefetches),
+    InitProcess(p_WriteCombine, DoWriteCombine),
 
     p_service       (clock, GetName() + ".p_service")
 {
@@ -60,6 +84,8 @@ DCache::DCache(const std::string& name, DRISC& parent, Clock& clock)
     m_read_responses.Sensitive(p_ReadResponses);
     m_write_responses.Sensitive(p_WriteResponses);
     m_outgoing.Sensitive(p_Outgoing);
+    m_prefetches.Sensitive(p_Prefetches);
+    m_wcbQueue.Sensitive(p_WriteCombine);
 
     // These things must be powers of two
     if (m_assoc == 0 || !IsPowerOfTwo(m_assoc))
@@ -85,24 +111,45 @@ DCache::DCache(const std::string& name, DRISC& parent, Clock& clock)
 
     m_lines.resize(m_sets * m_assoc);
     m_data.resize(m_lines.size() * m_lineSize);
-    m_valid = new bool[m_lines.size() * m_lineSize];
 
-    RegisterStateArray(m_valid, m_lines.size() * m_lineSize, "valid");
     RegisterStateVariable(m_data, "data");
+    m_array.RegisterState(*this);
 
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
         auto &line = m_lines[i];
         line.state  = LINE_EMPTY;
         line.data   = &m_data[i * m_lineSize];
-        line.valid  = &m_valid[i * m_lineSize];
+        line.valid  = 0;
         line.create = false;
+        line.prefetched = false;
         RegisterStateObject(line, "line" + to_string(i));
     }
 
     m_wbstate.size   = 0;
     m_wbstate.offset = 0;
     RegisterStateObject(m_wbstate, "wbstate");
+    RegisterStateVariable(m_prefetchIndex, "prefetchIndex");
+
+    // Without a configured size, there is an MSHR for every line, so
+    // the number of outstanding reads is only limited by the lines.
+    // The MSHRs are then indexed like the lines.
+    const size_t numMSHRs = GetConfOpt("NumMSHRs", size_t, 0);
+    m_lineMSHRs = (numMSHRs == 0);
+    m_mshrs.resize(m_lineMSHRs ? m_lines.size() : numMSHRs);
+    for (size_t i = 0; i < m_mshrs.size(); ++i)
+    {
+        m_mshrs[i].valid = false;
+        RegisterStateObject(m_mshrs[i], "mshr" + to_string(i));
+    }
+
+    m_wcb.resize(GetConfOpt("NumWriteCombineEntries", size_t, 0));
+    for (size_t i = 0; i < m_wcb.size(); ++i)
+    {
+        m_wcb[i].state = WCB_FREE;
+        RegisterStateObject(m_wcb[i], "wcb" + to_string(i));
+    }
+    RegisterStateVariable(m_wcbAckIndex, "wcbAckIndex");
 }
 
 void DCache::ConnectMemory(IMemory* memory)
@@ -117,10 +164,41 @@ void DCache::ConnectMemory(IMemory* memory)
 
 }
 
+bool DCache::HasPendingRequests() const
+{
+    if (!m_outgoing.Empty() || !m_prefetches.Empty() || !m_wcbQueue.Empty())
+    {
+        return true;
+    }
+    for (auto& line : m_lines)
+    {
+        if (line.state == LINE_LOADING || line.state == LINE_INVALID)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DCache::ReloadLines()
+{
+    auto& cpu = GetDRISC();
+    for (size_t i = 0; i < m_lines.size(); ++i)
+    {
+        Line& line = m_lines[i];
+        if (line.state == LINE_FULL)
+        {
+            MemAddr address = m_selector->Unmap(m_array.Tag(i), i / m_assoc) * m_lineSize;
+            cpu.ReadMemory(address, line.data, m_lineSize);
+            line.valid = line::full(m_lineSize);
+        }
+    }
+}
+
 DCache::~DCache()
 {
-    delete[] m_valid;
     delete m_selector;
+    delete m_prefetcher;
 }
 
 Result DCache::FindLine(MemAddr address, Line* &line, bool check_only)
@@ -130,35 +208,38 @@ Result DCache::FindLine(MemAddr address, Line* &line, bool check_only)
     m_selector->Map(address / m_lineSize, tag, setindex);
     const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    Line* empty   = NULL;
-    Line* replace = NULL;
-    for (size_t i = 0; i < m_assoc; ++i)
+    // Find the line; empty lines may not be touched or considered
+    for (CacheArray::WayMask m = m_array.Match(setindex, tag); m != 0; m &= m - 1)
     {
-        line = &m_lines[set + i];
-
-        // Invalid lines may not be touched or considered
-        if (line->state == LINE_EMPTY)
-        {
-            // Empty, unused line, remember this one
-            empty = line;
-        }
-        else if (line->tag == tag)
+        line = &m_lines[set + CacheArray::LowestWay(m)];
+        if (line->state != LINE_EMPTY)
         {
             // The wanted line was in the cache
             return SUCCESS;
         }
-        else if (line->state == LINE_FULL && (replace == NULL || line->access < replace->access))
-        {
-            // The line is available to be replaced and has a lower LRU rating,
-            // remember it for replacing
-            replace = line;
-        }
     }
 
-    // The line could not be found, allocate the empty line or replace an existing line
-    line = (empty != NULL) ? empty : replace;
-    if (line == NULL)
+    // The line could not be found, allocate the last empty line or
+    // replace a full line
+    CacheArray::WayMask empty = 0, replace = 0;
+    for (size_t i = 0; i < m_assoc; ++i)
+    {
+        const LineState state = m_lines[set + i].state;
+        if (state == LINE_EMPTY)
+            empty |= (CacheArray::WayMask)1 << i;
+        else if (state == LINE_FULL)
+            replace |= (CacheArray::WayMask)1 << i;
+    }
+
+    if (empty != 0)
+    {
+        line = &m_lines[set + CacheArray::HighestWay(empty)];
+    }
+    else if (replace != 0)
+    {
+        line = &m_lines[set + m_array.Victim(setindex, replace)];
+    }
+    else
     {
         // No available line
         if (!check_only)
@@ -173,10 +254,16 @@ Result DCache::FindLine(MemAddr address, Line* &line, bool check_only)
         // Reset the line
         COMMIT
         {
+            if (line->state == LINE_FULL && line->prefetched)
+            {
+                // Replacing a prefetched line that was never read
+                ++m_numUselessPrefetches;
+            }
             line->processing = false;
-            line->tag        = tag;
+            line->prefetched = false;
             line->waiting    = INVALID_REG;
-            std::fill(line->valid, line->valid + m_lineSize, false);
+            m_array.Tag(line - &m_lines[0]) = tag;
+            line->valid = 0;
         }
     }
 
@@ -185,7 +272,79 @@ Result DCache::FindLine(MemAddr address, Line* &line, bool check_only)
 
 
 
-Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg)
+bool DCache::FindFreeMSHR(const Line& line, size_t& index) const
+{
+    if (m_lineMSHRs)
+    {
+        // A line is only allocated when empty or full, and the MSHR
+        // of a line is released when it becomes so.
+        index = &line - &m_lines[0];
+        assert(!m_mshrs[index].valid);
+        return true;
+    }
+
+    for (index = 0; index < m_mshrs.size(); ++index)
+    {
+        if (!m_mshrs[index].valid)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t DCache::FindMSHR(MemAddr address) const
+{
+    if (m_lineMSHRs)
+    {
+        // The read can only be outstanding for a line with the tag
+        // of the address.
+        MemAddr tag;
+        size_t setindex;
+        m_selector->Map(address / m_lineSize, tag, setindex);
+        for (CacheArray::WayMask m = m_array.Match(setindex, tag); m != 0; m &= m - 1)
+        {
+            const size_t index = setindex * m_assoc + CacheArray::LowestWay(m);
+            if (m_mshrs[index].valid && m_mshrs[index].address == address)
+            {
+                return index;
+            }
+        }
+        return m_mshrs.size();
+    }
+
+    size_t index;
+    for (index = 0; index < m_mshrs.size(); ++index)
+    {
+        if (m_mshrs[index].valid && m_mshrs[index].address == address)
+        {
+            break;
+        }
+    }
+    return index;
+}
+
+void DCache::TrainPrefetcher(MemAddr pc, MemAddr address, bool miss, bool prefetched)
+{
+    PrefetchRun run;
+    if (m_prefetcher == NULL || pc == 0 || !m_prefetcher->OnRead(pc, address, miss, prefetched, run))
+    {
+        return;
+    }
+
+    // The demand read does not wait for the prefetches; if there is
+    // no room to queue them, they are dropped.
+    PrefetchRequest req;
+    req.address = run.address;
+    req.stride  = run.stride;
+    req.count   = run.count;
+    if (!m_prefetches.Push(std::move(req)))
+    {
+        COMMIT{ m_numDroppedPrefetches += run.count; }
+    }
+}
+
+Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg, MemAddr pc)
 {
     size_t offset = (size_t)(address % m_lineSize);
     if (offset + size > m_lineSize)
@@ -218,6 +377,44 @@ Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg)
         return FAILED;
     }
 
+    if (cpu.IsFastForward())
+    {
+        if (cpu.IsFastForwardHeld())
+        {
+            DeadlockWrite("Holding D-Cache read access (%#016llx, %zd) until memory requests have completed",
+                          (unsigned long long)address, (size_t)size);
+            return FAILED;
+        }
+
+        // Fast-forward: bypass the memory system, but keep the cache
+        // warm by loading the line as if it had been read from memory.
+        Line* line;
+        Result result = FindLine(address - offset, line, true);
+        COMMIT
+        {
+            cpu.ReadMemory(address, data, size);
+            if (result == DELAYED)
+            {
+                MemAddr tag;
+                size_t  setindex;
+                m_selector->Map((address - offset) / m_lineSize, tag, setindex);
+                cpu.ReadMemory(address - offset, line->data, m_lineSize);
+                line->valid = line::full(m_lineSize);
+                m_array.Tag(line - &m_lines[0]) = tag;
+                line->waiting    = INVALID_REG;
+                line->state      = LINE_FULL;
+                line->processing = false;
+                line->create     = false;
+                line->prefetched = false;
+            }
+            if (result != FAILED)
+            {
+                m_array.Touch(line - &m_lines[0], cpu.GetCycleNo());
+            }
+        }
+        return SUCCESS;
+    }
+
     Line*  line;
     Result result;
     // SUCCESS - A line with the address was found
@@ -232,11 +429,20 @@ Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg)
     }
 
     // Update last line access
-    COMMIT{ line->access = cpu.GetCycleNo(); }
+    COMMIT{ m_array.Touch(line - &m_lines[0], cpu.GetCycleNo()); }
 
     if (result == DELAYED)
     {
-        // A new line has been allocated; send the request to memory
+        // A new line has been allocated; track the miss and send the
+        // request to memory
+        size_t mshr;
+        if (!FindFreeMSHR(*line, mshr))
+        {
+            ++m_numMSHRStalls;
+            DeadlockWrite("Unable to allocate an MSHR for read miss (%#016llx)", (unsigned long long)address);
+            return FAILED;
+        }
+
         Request request;
         request.write     = false;
         request.address   = address - offset;
@@ -247,6 +453,13 @@ Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg)
             return FAILED;
         }
 
+        COMMIT
+        {
+            m_mshrs[mshr].address = address - offset;
+            m_mshrs[mshr].cid     = line - &m_lines[0];
+            m_mshrs[mshr].valid   = true;
+        }
+
         // statistics
         COMMIT {
             if (line->state == LINE_EMPTY)
@@ -254,29 +467,33 @@ Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg)
             else
                 ++m_numResolvedConflicts;
         }
+
+        TrainPrefetcher(pc, address, true, false);
     }
     else
     {
         // Check if the data that we want is valid in the line.
         // This happens when the line is FULL, or LOADING and has been
         // snooped to (written to from another core) in the mean time.
-        size_t i;
-        for (i = 0; i < size; ++i)
-        {
-            if (!line->valid[offset + i])
-            {
-                break;
-            }
-        }
-
-        if (i == size)
+        const LineMask want = line::range(offset, size);
+        if ((line->valid & want) == want)
         {
             // Data is entirely in the cache, copy it
+            const bool prefetched = line->prefetched;
             COMMIT
             {
                 memcpy(data, line->data + offset, (size_t)size);
                 ++m_numRHits;
+
+                if (prefetched)
+                {
+                    // First use of a prefetched line
+                    ++m_numUsefulPrefetches;
+                    line->prefetched = false;
+                }
             }
+            TrainPrefetcher(pc, address, false, prefetched);
+            TraceEvent(EV_READ_HIT, address, size, pc);
             return SUCCESS;
         }
 
@@ -289,10 +506,23 @@ Result DCache::Read(MemAddr address, void* data, MemSize size, RegAddr* reg)
         }
         else
         {
-            COMMIT{ ++m_numLoadingRMisses; }
+            const bool prefetched = line->prefetched;
+            COMMIT{
+                ++m_numLoadingRMisses;
+
+                if (prefetched)
+                {
+                    // The prefetch was issued, but too late
+                    ++m_numLatePrefetches;
+                    line->prefetched = false;
+                }
+            }
+            TrainPrefetcher(pc, address, false, prefetched);
         }
     }
 
+    TraceEvent(EV_READ_MISS, address, size, pc);
+
     // Data is being loaded, add request to the queue
     COMMIT
     {
@@ -350,6 +580,31 @@ Result DCache::Write(MemAddr address, void* data, MemSize size, LFID fid, TID ti
         return FAILED;
     }
 
+    if (cpu.IsFastForward())
+    {
+        if (cpu.IsFastForwardHeld())
+        {
+            DeadlockWrite("Holding D-Cache write access (%#016llx, %zd) until memory requests have completed",
+                          (unsigned long long)address, (size_t)size);
+            return FAILED;
+        }
+
+        // Fast-forward: bypass the memory system. The write completes
+        // immediately and updates the line if it is present.
+        Line* line;
+        Result result = FindLine(address, line, true);
+        COMMIT
+        {
+            cpu.WriteMemory(address, data, size);
+            if (result == SUCCESS && line->state == LINE_FULL)
+            {
+                std::copy((char*)data, (char*)data + size, line->data + offset);
+                m_array.Touch(line - &m_lines[0], cpu.GetCycleNo());
+            }
+        }
+        return SUCCESS;
+    }
+
     Line* line = NULL;
     Result result = FindLine(address, line, true);
     if (result == SUCCESS)
@@ -379,7 +634,7 @@ Result DCache::Write(MemAddr address, void* data, MemSize size, LFID fid, TID ti
             assert(line->state == LINE_FULL);
             COMMIT{
                 std::copy((char*)data, (char*)data + size, line->data + offset);
-                std::fill(line->valid + offset, line->valid + offset + size, true);
+                line->valid |= line::range(offset, size);
 
                 // Statistics
                 ++m_numWHits;
@@ -391,6 +646,14 @@ Result DCache::Write(MemAddr address, void* data, MemSize size, LFID fid, TID ti
         COMMIT{ ++m_numPassThroughWMisses; }
     }
 
+    TraceEvent(EV_WRITE, address, size, tid);
+
+    if (!m_wcb.empty())
+    {
+        // Store into the write-combining buffer
+        return CombineWrite(address - offset, offset, data, size, tid);
+    }
+
     // Store request for memory (pass-through)
     Request request;
     request.write     = true;
@@ -399,9 +662,7 @@ Result DCache::Write(MemAddr address, void* data, MemSize size, LFID fid, TID ti
 
     COMMIT{
     std::copy((char*)data, ((char*)data)+size, request.data.data+offset);
-    std::fill(request.data.mask, request.data.mask+offset, false);
-    std::fill(request.data.mask+offset, request.data.mask+offset+size, true);
-    std::fill(request.data.mask+offset+size, request.data.mask+m_lineSize, false);
+    request.data.mask = line::range(offset, size);
     }
 
     if (!m_outgoing.Push(std::move(request)))
@@ -416,13 +677,79 @@ Result DCache::Write(MemAddr address, void* data, MemSize size, LFID fid, TID ti
     return DELAYED;
 }
 
+Result DCache::CombineWrite(MemAddr address, size_t offset, const void* data, MemSize size, TID tid)
+{
+    // Merge into the open entry for the line, if any
+    WriteCombineEntry* entry = NULL;
+    for (auto& e : m_wcb)
+    {
+        if (e.state == WCB_COMBINING && e.address == address && e.stores < MAX_COMBINED_STORES)
+        {
+            entry = &e;
+            break;
+        }
+    }
+
+    const bool merged = (entry != NULL);
+    if (!merged)
+    {
+        // Open a new entry
+        for (auto& e : m_wcb)
+        {
+            if (e.state == WCB_FREE)
+            {
+                entry = &e;
+                break;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            ++m_numStallingWMisses;
+            DeadlockWrite("Unable to allocate a write-combining entry for %#016llx", (unsigned long long)address);
+            return FAILED;
+        }
+
+        if (!m_wcbQueue.Push(entry - &m_wcb[0]))
+        {
+            ++m_numStallingWMisses;
+            DeadlockWrite("Unable to push write-combining entry");
+            return FAILED;
+        }
+    }
+
+    COMMIT
+    {
+        if (!merged)
+        {
+            entry->state   = WCB_COMBINING;
+            entry->address = address;
+            entry->created = GetDRISC().GetCycleNo();
+            entry->stores  = 0;
+            entry->data.mask = 0;
+        }
+        else
+        {
+            ++m_numCombinedWrites;
+        }
+
+        std::copy((const char*)data, (const char*)data + size, entry->data.data + offset);
+        entry->data.mask |= line::range(offset, size);
+        entry->tids[entry->stores++] = tid;
+
+        ++m_numWAccesses;
+    }
+    return DELAYED;
+}
+
 bool DCache::OnMemoryReadCompleted(MemAddr addr, const char* data)
 {
-    // Check if we have the line and if its loading.
+    // Check if we have an outstanding read for the line.
     // This method gets called whenever a memory read completion is put on the
     // bus from memory, so we have to check if we actually need the data.
-    Line* line;
-    if (FindLine(addr, line, true) == SUCCESS && line->state != LINE_FULL && !line->processing)
+    const size_t mshr = FindMSHR(addr);
+    Line* line = (mshr < m_mshrs.size()) ? &m_lines[m_mshrs[mshr].cid] : NULL;
+    if (line != NULL && !line->processing)
     {
         assert(line->state == LINE_LOADING || line->state == LINE_INVALID);
 
@@ -449,10 +776,20 @@ bool DCache::OnMemoryReadCompleted(MemAddr addr, const char* data)
                 }
             }
 
+            // Same for the stores that are still being combined, in order
+            for (auto i : m_wcbQueue)
+            {
+                const WriteCombineEntry& entry = m_wcb[i];
+                if (entry.address == addr)
+                {
+                    line::blit(&mdata[0], entry.data.data, entry.data.mask, m_lineSize);
+                }
+            }
+
             // Copy the data into the cache line.
             // Mask by valid bytes (don't overwrite already written data).
             line::blitnot(line->data, mdata, line->valid, m_lineSize);
-            line::setifnot(line->valid, true, line->valid, m_lineSize);
+            line->valid = line::full(m_lineSize);
 
             line->processing = true;
         }
@@ -460,8 +797,10 @@ bool DCache::OnMemoryReadCompleted(MemAddr addr, const char* data)
         // Push the cache-line to the back of the queue
         ReadResponse response;
         response.cid   = line - &m_lines[0];
+        response.mshr  = mshr;
 
         DebugMemWrite("Received read completion for %#016llx -> CID %u", (unsigned long long)addr, (unsigned)response.cid);
+        TraceEvent(EV_FILL, addr, mshr);
 
         if (!m_read_responses.Push(std::move(response)))
         {
@@ -490,7 +829,7 @@ bool DCache::OnMemoryWriteCompleted(WClientID wid)
     return true;
 }
 
-bool DCache::OnMemorySnooped(MemAddr address, const char* data, const bool* mask)
+bool DCache::OnMemorySnooped(MemAddr address, const char* data, LineMask mask)
 {
     Line*  line;
 
@@ -520,7 +859,7 @@ bool DCache::OnMemorySnooped(MemAddr address, const char* data, const bool* mask
             // because we don't have to guarantee sequential semantics from other cores.
             // This falls within the non-determinism behavior of the architecture.
             line::blit(line->data, data, mask, m_lineSize);
-            line::setif(line->valid, true, mask, m_lineSize);
+            line->valid |= mask & line::full(m_lineSize);
 
             // Statistics
             ++m_numSnoops;
@@ -541,6 +880,9 @@ bool DCache::OnMemoryInvalidated(MemAddr address)
             // We have the line, invalidate it
             if (line->state == LINE_FULL) {
                 // Full lines are invalidated by clearing them. Simple.
+                if (line->prefetched) {
+                    ++m_numUselessPrefetches;
+                }
                 line->state = LINE_EMPTY;
             } else if (line->state == LINE_LOADING) {
                 // The data is being loaded. Invalidate the line and it will get cleaned up
@@ -602,6 +944,7 @@ Result DCache::DoReadResponses()
     COMMIT {
         line.waiting = INVALID_REG;
         line.state = (line.state == LINE_INVALID) ? LINE_EMPTY : LINE_FULL;
+        m_mshrs[response.mshr].valid = false;
     }
     m_read_responses.Pop();
     return SUCCESS;
@@ -752,19 +1095,187 @@ Result DCache::DoWriteResponses()
     assert(!m_write_responses.Empty());
     auto& response = m_write_responses.Front();
 
+    // With write combining, the completion is for an entry and
+    // every thread with a store in the entry is notified in turn.
+    WriteCombineEntry* entry = NULL;
+    TID tid = (TID)response.wid;
+    if (!m_wcb.empty())
+    {
+        entry = &m_wcb[response.wid];
+        assert(entry->state == WCB_SENT);
+        tid = entry->tids[m_wcbAckIndex];
+    }
+
     auto& alloc = GetDRISC().GetAllocator();
-    if (!alloc.DecreaseThreadDependency((TID)response.wid, THREADDEP_OUTSTANDING_WRITES))
+    if (!alloc.DecreaseThreadDependency(tid, THREADDEP_OUTSTANDING_WRITES))
     {
-        DeadlockWrite("Unable to decrease outstanding writes on T%u", (unsigned)response.wid);
+        DeadlockWrite("Unable to decrease outstanding writes on T%u", (unsigned)tid);
         return FAILED;
     }
 
-    DebugMemWrite("T%u completed store", (unsigned)response.wid);
+    DebugMemWrite("T%u completed store", (unsigned)tid);
+
+    if (entry != NULL)
+    {
+        if (m_wcbAckIndex + 1 < entry->stores)
+        {
+            COMMIT{ ++m_wcbAckIndex; }
+            return SUCCESS;
+        }
+
+        COMMIT
+        {
+            m_wcbAckIndex = 0;
+            entry->state  = WCB_FREE;
+        }
+    }
 
     m_write_responses.Pop();
     return SUCCESS;
 }
 
+Result DCache::DoPrefetches()
+{
+    assert(!m_prefetches.Empty());
+    const PrefetchRequest& req = m_prefetches.Front();
+    const MemAddr address = req.address + req.stride * (int64_t)m_prefetchIndex;
+
+    auto& cpu = GetDRISC();
+    if (!cpu.IsFastForward())
+    {
+        // Prefetches only use the memory port when it is idle
+        if (!m_outgoing.Empty())
+        {
+            DeadlockWrite("Waiting for idle memory port to prefetch %#016llx", (unsigned long long)address);
+            return FAILED;
+        }
+
+        if (!p_service.Invoke())
+        {
+            DeadlockWrite("Unable to acquire port for D-Cache prefetch (%#016llx)", (unsigned long long)address);
+            return FAILED;
+        }
+
+        const MemAddr base = address - address % m_lineSize;
+        Line* line;
+        if (!cpu.CheckPermissions(base, m_lineSize, IMemory::PERM_READ))
+        {
+            // Never prefetch from non-readable memory
+            COMMIT{ ++m_numDroppedPrefetches; }
+        }
+        else
+        {
+            switch (FindLine(base, line, true))
+            {
+            case SUCCESS:
+                // Already present or loading
+                break;
+
+            case FAILED:
+                // No line to load it into
+                COMMIT{ ++m_numDroppedPrefetches; }
+                break;
+
+            case DELAYED:
+            {
+                size_t mshr;
+                if (!FindFreeMSHR(*line, mshr))
+                {
+                    // Leave the MSHRs to demand misses
+                    COMMIT{ ++m_numDroppedPrefetches; }
+                    break;
+                }
+
+                Request request;
+                request.write   = false;
+                request.address = base;
+                if (!m_outgoing.Push(std::move(request)))
+                {
+                    DeadlockWrite("Unable to push prefetch request to outgoing buffer");
+                    return FAILED;
+                }
+
+                FindLine(base, line, false);
+                COMMIT
+                {
+                    line->state      = LINE_LOADING;
+                    line->create     = false;
+                    line->prefetched = true;
+                    m_array.Touch(line - &m_lines[0], cpu.GetCycleNo());
+                    m_mshrs[mshr].address = base;
+                    m_mshrs[mshr].cid     = line - &m_lines[0];
+                    m_mshrs[mshr].valid   = true;
+                    ++m_numPrefetches;
+                }
+
+                DebugMemWrite("Prefetching %#016llx", (unsigned long long)base);
+                break;
+            }
+            }
+        }
+    }
+    // else: the memory system is bypassed, the run is dropped.
+
+    // One line per cycle; move to the next line in the run
+    if (m_prefetchIndex + 1 < req.count)
+    {
+        COMMIT{ ++m_prefetchIndex; }
+    }
+    else
+    {
+        COMMIT{ m_prefetchIndex = 0; }
+        m_prefetches.Pop();
+    }
+    return SUCCESS;
+}
+
+Result DCache::DoWriteCombine()
+{
+    assert(!m_wcbQueue.Empty());
+    WriteCombineEntry& entry = m_wcb[m_wcbQueue.Front()];
+    assert(entry.state == WCB_COMBINING);
+
+    // The oldest entry stays open to more stores while the memory port
+    // is busy and for a few cycles after, unless it cannot take more
+    // stores or new stores need an entry.
+    if (entry.stores < MAX_COMBINED_STORES && m_wcbQueue.size() < m_wcb.size())
+    {
+        if (!m_outgoing.Empty())
+        {
+            DeadlockWrite("Combining stores to %#016llx while the memory port is busy", (unsigned long long)entry.address);
+            return FAILED;
+        }
+
+        if (GetDRISC().GetCycleNo() < entry.created + m_wcbDelay)
+        {
+            return SUCCESS;
+        }
+    }
+
+    if (!p_service.Invoke())
+    {
+        DeadlockWrite("Unable to acquire port for D-Cache write combining (%#016llx)", (unsigned long long)entry.address);
+        return FAILED;
+    }
+
+    Request request;
+    request.write   = true;
+    request.address = entry.address;
+    request.data    = entry.data;
+    request.wid     = m_wcbQueue.Front();
+    if (!m_outgoing.Push(std::move(request)))
+    {
+        DeadlockWrite("Unable to push combined write to outgoing buffer");
+        return FAILED;
+    }
+
+    DebugMemWrite("Sending %u combined stores to %#016llx", (unsigned)entry.stores, (unsigned long long)entry.address);
+
+    COMMIT{ entry.state = WCB_SENT; }
+    m_wcbQueue.Pop();
+    return SUCCESS;
+}
+
 Result DCache::DoOutgoingRequests()
 {
     assert(m_memory != NULL);
@@ -827,6 +1338,7 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
         }
 
         out << "L1 bank mapping:     " << m_selector->GetName() << endl
+            << "Prefetcher:          " << (m_prefetcher != NULL ? m_prefetcher->GetTypeName() : "none") << endl
             << "Cache size:          " << dec << (m_lineSize * m_lines.size()) << " bytes" << endl
             << "Cache line size:     " << dec << m_lineSize << " bytes" << endl
             << endl;
@@ -834,10 +1346,10 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
         uint64_t numRAccesses = m_numRHits + m_numDelayedReads;
 
         uint64_t numRRqst = m_numEmptyRMisses + m_numResolvedConflicts;
-        uint64_t numWRqst = m_numWAccesses;
+        uint64_t numWRqst = m_numWAccesses - m_numCombinedWrites;
         uint64_t numRqst = numRRqst + numWRqst;
 
-        uint64_t numRStalls = m_numHardConflicts + m_numInvalidRMisses + m_numStallingRMisses;
+        uint64_t numRStalls = m_numHardConflicts + m_numInvalidRMisses + m_numStallingRMisses + m_numMSHRStalls;
         uint64_t numWStalls = m_numLoadingWMisses + m_numStallingWMisses;
         uint64_t numStalls = numRStalls + numWStalls;
 
@@ -882,6 +1394,7 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
                 << "Breakdown of writes:" << endl
                 << "- to a loaded line with same tag:                               " << PRINTVAL(m_numWHits, w_factor) << endl
                 << "- to a an empty line or line with different tag (pass-through): " << PRINTVAL(m_numPassThroughWMisses, w_factor) << endl
+                << "Writes combined with an earlier write:                          " << PRINTVAL(m_numCombinedWrites, w_factor) << endl
                 << "(percentages relative to " << m_numWAccesses << " write requests)" << endl
                 << endl;
 
@@ -897,6 +1410,22 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
                 << endl;
 
 
+            if (m_prefetcher != NULL)
+            {
+                float p_factor = 100.f / m_numPrefetches;
+                out << "***********************************************************" << endl
+                    << "                      Prefetches                           " << endl
+                    << "***********************************************************" << endl
+                    << endl
+                    << "Number of prefetched lines:           " << m_numPrefetches << endl
+                    << "- read after arrival (useful):        " << PRINTVAL(m_numUsefulPrefetches, p_factor) << endl
+                    << "- read while loading (late):          " << PRINTVAL(m_numLatePrefetches, p_factor) << endl
+                    << "- evicted before use (useless):       " << PRINTVAL(m_numUselessPrefetches, p_factor) << endl
+                    << "(percentages relative to " << m_numPrefetches << " prefetched lines)" << endl
+                    << "Lines dropped for lack of space:      " << m_numDroppedPrefetches << endl
+                    << endl;
+            }
+
             if (numStalls != 0)
             {
                 float s_factor = 100.f / numStalls;
@@ -911,6 +1440,7 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
                     << "- read conflict to non-reusable line: " << PRINTVAL(m_numHardConflicts, s_factor) << endl
                     << "- read to invalidated line:           " << PRINTVAL(m_numInvalidRMisses, s_factor) << endl
                     << "- unable to send request upstream:    " << PRINTVAL(m_numStallingRMisses, s_factor) << endl
+                    << "- no free MSHR:                       " << PRINTVAL(m_numMSHRStalls, s_factor) << endl
                     << "Breakdown of write-related stalls:" << endl
                     << "- writes to loading line:             " << PRINTVAL(m_numLoadingWMisses, s_factor) << endl
                     << "- unable to send request upstream:    " << PRINTVAL(m_numStallingWMisses, s_factor) << endl
@@ -989,7 +1519,7 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
                 out << hex << setfill('0');
                 for (size_t x = 0; x < m_lineSize; ++x)
                 {
-                    if (p.data.mask[x])
+                    if (line::test(p.data.mask, x))
                         out << " " << setw(2) << (unsigned)(unsigned char)p.data.data[x];
                     else
                         out << " --";
@@ -997,6 +1527,37 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
             }
             out << dec << endl;
         }
+
+        out << endl << "Outstanding reads (MSHRs):" << endl;
+        for (size_t i = 0; i < m_mshrs.size(); ++i)
+        {
+            if (m_mshrs[i].valid)
+            {
+                out << setw(3) << setfill(' ') << dec << i << ": "
+                    << hex << "0x" << setw(16) << setfill('0') << m_mshrs[i].address
+                    << " -> CID " << dec << m_mshrs[i].cid << endl;
+            }
+        }
+
+        if (!m_wcb.empty())
+        {
+            out << endl << "Write-combining buffer:" << endl
+                << "Entry |      Address       | State     | Stores" << endl
+                << "------+--------------------+-----------+-------" << endl;
+            for (size_t i = 0; i < m_wcb.size(); ++i)
+            {
+                const WriteCombineEntry& entry = m_wcb[i];
+                if (entry.state == WCB_FREE)
+                    continue;
+                out << setw(5) << setfill(' ') << dec << i << " | "
+                    << hex << "0x" << setw(16) << setfill('0') << entry.address << " | "
+                    << (entry.state == WCB_COMBINING ? "Combining" : "Sent     ") << " |"
+                    << dec;
+                for (size_t j = 0; j < entry.stores; ++j)
+                    out << " T" << entry.tids[j];
+                out << endl;
+            }
+        }
         return;
     }
 
@@ -1017,7 +1578,7 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
             out << " |                     |                                                 |";
         } else {
             out << " | "
-                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(line.tag, set) * m_lineSize;
+                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(m_array.Tag(i), set) * m_lineSize;
 
             switch (line.state)
             {
@@ -1062,7 +1623,7 @@ void DCache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
             {
                 for (size_t x = y; x < y + BYTES_PER_LINE; ++x) {
                     out << " ";
-                    if (line.valid[x]) {
+                    if (line::test(line.valid, x)) {
                         out << setw(2) << (unsigned)(unsigned char)line.data[x];
                     } else {
                         out << "  ";
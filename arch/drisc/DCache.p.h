@@ -6,6 +6,7 @@
 #include <sim/inspect.h>
 #include <sim/buffer.h>
 #include <arch/Memory.h>
+#include <arch/CacheArray.h>
 #include <arch/drisc/forward.h>
 
 namespace Simulator
@@ -27,18 +28,28 @@ public:
         LINE_FULL        ///< Line is full.
     };
 
+    /// The state of a write-combining buffer entry
+    enum WriteCombineState
+    {
+        WCB_FREE,        ///< Entry is unused.
+        WCB_COMBINING,   ///< Entry accepts stores to its line.
+        WCB_SENT,        ///< Entry has been sent to memory and waits for completion.
+    };
+
+    /// Maximum number of stores combined in a single memory write
+    static const size_t MAX_COMBINED_STORES = 8;
+
     // {% from "sim/macros.p.h" import gen_struct %}
     // {% call gen_struct() %}
     ((name Line)
      (state
-      (MemAddr     tag)               ///< The address tag.
       (char*       data noserialize)  ///< The data in this line.
-      (bool*       valid noserialize) ///< A bitmap of valid bytes in this line.
-      (CycleNo     access)            ///< Last access time of this line (for LRU).
+      (LineMask    valid)             ///< The valid bytes in this line.
       (RegAddr     waiting)           ///< First register waiting on this line.
       (LineState   state)             ///< The line state.
       (bool        processing)        ///< Has the line been added to m_returned yet?
-      (bool        create)))          ///< Is the line expected by the create process (bundle)?
+      (bool        create)            ///< Is the line expected by the create process (bundle)?
+      (bool        prefetched)))      ///< Was the line loaded by the prefetcher and not used yet?
     // {% endcall %}
 
 private:
@@ -51,9 +62,43 @@ private:
       (bool      write)))
     // {% endcall %}
 
+    // A run of lines to prefetch, see PrefetchRun
+    // {% call gen_struct() %}
+    ((name PrefetchRequest)
+     (state
+      (MemAddr   address)
+      (int64_t   stride)
+      (size_t    count)))
+    // {% endcall %}
+
     // {% call gen_struct() %}
     ((name ReadResponse)
-     (state (CID cid)))
+     (state
+      (CID      cid)
+      (unsigned mshr)))
+    // {% endcall %}
+
+    // Miss status holding register: an outstanding line read.
+    // Secondary misses to the line wait on the line itself.
+    // {% call gen_struct() %}
+    ((name MSHR)
+     (state
+      (MemAddr   address)          ///< Address of the line being read.
+      (CID       cid)              ///< Cache line receiving the data.
+      (bool      valid)))          ///< Is the entry in use?
+    // {% endcall %}
+
+    // Write-combining buffer entry: stores to a line that are sent
+    // to memory as a single write.
+    // {% call gen_struct() %}
+    ((name WriteCombineEntry)
+     (state
+      (MemData           data)                            ///< Combined data and byte mask.
+      (MemAddr           address)                         ///< Address of the line.
+      (CycleNo           created)                         ///< Cycle of the first store.
+      (array tids TID MAX_COMBINED_STORES)                ///< Threads of the combined stores.
+      (unsigned          stores)                          ///< Number of combined stores.
+      (WriteCombineState state)))
     // {% endcall %}
 
     // {% call gen_struct() %}
@@ -82,21 +127,34 @@ private:
     // {% endcall %}
 
     Result FindLine(MemAddr address, Line* &line, bool check_only);
+    void   TrainPrefetcher(MemAddr pc, MemAddr address, bool miss, bool prefetched);
+    bool   FindFreeMSHR(const Line& line, size_t& index) const;
+    size_t FindMSHR(MemAddr address) const;
+    Result CombineWrite(MemAddr address, size_t offset, const void* data, MemSize size, TID tid);
 
     IMemory*             m_memory;          ///< Memory
     MCID                 m_mcid;            ///< Memory Client ID
     std::vector<Line>    m_lines;           ///< The cache-lines.
     std::vector<char>    m_data;            ///< The data in the cache lines.
-    bool*                m_valid;           ///< The valid bits.
     size_t               m_assoc;           ///< Config: Cache associativity.
     size_t               m_sets;            ///< Config: Number of sets in the cace.
     size_t               m_lineSize;        ///< Config: Size of a cache line, in bytes.
     IBankSelector*       m_selector;        ///< Mapping of cache line addresses to tags and set indices.
+    CacheArray           m_array;           ///< The tags and replacement state of the lines.
     Buffer<ReadResponse>  m_read_responses; ///< Incoming buffer for read responses from memory bus.
     Buffer<WriteResponse> m_write_responses;///< Incoming buffer for write acknowledgements from memory bus.
     Buffer<WritebackRequest> m_writebacks; ///< Incoming buffer for register writebacks after load.
     Buffer<Request>      m_outgoing;        ///< Outgoing buffer to memory bus.
     WritebackState       m_wbstate;         ///< Writeback state
+    Prefetcher*          m_prefetcher;      ///< Hardware prefetcher, NULL if none.
+    Buffer<PrefetchRequest> m_prefetches;   ///< Runs of lines waiting to be prefetched.
+    size_t               m_prefetchIndex;   ///< Number of lines already handled in the first run.
+    std::vector<MSHR>    m_mshrs;           ///< Outstanding line reads.
+    bool                 m_lineMSHRs;       ///< One MSHR per line, with the index of the line.
+    std::vector<WriteCombineEntry> m_wcb;   ///< Write-combining buffer, empty if disabled.
+    Buffer<size_t>       m_wcbQueue;        ///< Combining entries, in the order they were opened.
+    CycleNo              m_wcbDelay;        ///< Config: Cycles an entry stays open while the port is idle.
+    size_t               m_wcbAckIndex;     ///< Number of threads already notified for the completed write.
 
 
     // Statistics
@@ -119,11 +177,22 @@ private:
 
     DefineSampleVariable(uint64_t, numSnoops);
 
+    DefineSampleVariable(uint64_t, numPrefetches);          ///< Lines requested by the prefetcher
+    DefineSampleVariable(uint64_t, numUsefulPrefetches);    ///< Prefetched lines read after they arrived
+    DefineSampleVariable(uint64_t, numLatePrefetches);      ///< Prefetched lines read while still loading
+    DefineSampleVariable(uint64_t, numUselessPrefetches);   ///< Prefetched lines evicted before being read
+    DefineSampleVariable(uint64_t, numDroppedPrefetches);   ///< Lines not prefetched for lack of space
+
+    DefineSampleVariable(uint64_t, numMSHRStalls);          ///< Read misses stalled for lack of an MSHR
+    DefineSampleVariable(uint64_t, numCombinedWrites);      ///< Stores merged into an open write
+
 
     Result DoReadWritebacks();
     Result DoReadResponses();
     Result DoWriteResponses();
     Result DoOutgoingRequests();
+    Result DoPrefetches();
+    Result DoWriteCombine();
 
     Object& GetDRISCParent() const { return *GetParent(); }
 
@@ -139,19 +208,26 @@ public:
     Process p_ReadResponses;
     Process p_WriteResponses;
     Process p_Outgoing;
+    Process p_Prefetches;
+    Process p_WriteCombine;
 
     ArbitratedService<> p_service;
 
     // Public interface
-    Result Read (MemAddr address, void* data, MemSize size, RegAddr* reg);
+    // pc is the address of the load instruction for the prefetcher, or 0 for other reads.
+    Result Read (MemAddr address, void* data, MemSize size, RegAddr* reg, MemAddr pc);
     Result Write(MemAddr address, void* data, MemSize size, LFID fid, TID tid);
 
     size_t GetLineSize() const { return m_lineSize; }
 
+    // Fast-forward support, see DRISC::SetFastForward()
+    bool HasPendingRequests() const;
+    void ReloadLines();
+
     // Memory callbacks
     bool OnMemoryReadCompleted(MemAddr addr, const char* data) override;
     bool OnMemoryWriteCompleted(TID tid) override;
-    bool OnMemorySnooped(MemAddr addr, const char* data, const bool* mask) override;
+    bool OnMemorySnooped(MemAddr addr, const char* data, LineMask mask) override;
     bool OnMemoryInvalidated(MemAddr addr) override;
 
     Object& GetMemoryPeer() override;
@@ -27,6 +27,10 @@ DRISC::DRISC(const std::string& name, Object& parent, Clock& clock, PID pid, con
     m_fpu(NULL),
     m_symtable(NULL),
     m_pid(pid),
+    m_fastForward(false),
+    m_ffHeld(false),
+    m_ffReached(false),
+    m_ffMarker(0),
     m_reginits(),
     m_bits(),
     m_familyTable ("families",      *this),
@@ -61,6 +65,11 @@ DRISC::DRISC(const std::string& name, Object& parent, Clock& clock, PID pid, con
     RegisterModelProperty(*this, "fpregs", (uint32_t)m_registerFile.GetSizes()[RT_FLOAT]);
     RegisterModelProperty(*this, "freq", (uint32_t)clock.GetFrequency());
 
+    RegisterStateVariable(m_fastForward, "fastforward");
+    RegisterStateVariable(m_ffHeld, "ffheld");
+    RegisterStateVariable(m_ffReached, "ffreached");
+    RegisterStateVariable(m_ffMarker, "ffmarker");
+
     // Get the size, in bits, of various identifiers.
     // This is used for packing and unpacking various fields.
     m_bits.pid_bits = ilog2(GetGridSize());
@@ -79,42 +88,46 @@ DRISC::DRISC(const std::string& name, Object& parent, Clock& clock, PID pid, con
     // Check if there is an initial register configuration
     if (!GetConfOpt("InitRegs", string, "").empty())
     {
-        auto regs = GetConfStrings("InitRegs");
-        for (auto ri : regs)
+        SetInitialRegisters(GetConfStrings("InitRegs"));
+    }
+}
+
+void DRISC::SetInitialRegisters(const vector<string>& regs)
+{
+    for (auto ri : regs)
+    {
+        // format is RNNN=VAL or FNNN=VAL
+        transform(ri.begin(), ri.end(), ri.begin(), ::tolower);
+        if (ri[0] != 'r' && ri[0] != 'f')
         {
-            // format is RNNN=VAL or FNNN=VAL
-            transform(ri.begin(), ri.end(), ri.begin(), ::tolower);
-            if (ri[0] != 'r' && ri[0] != 'f')
-            {
-                throw exceptf<InvalidArgumentException>("Register name not recognized: %s", ri.c_str());
-            }
-            // find "=" sign
-            size_t i = ri.find('=');
-            if (i < 2 || i + 1 > ri.size()) // need at least 2 chars before and 1 char after
-            {
-                throw exceptf<InvalidArgumentException>("Invalid register specifier: %s", ri.c_str());
-            }
-            string sidx = ri.substr(1, i - 1);
-            string value = ri.substr(i + 1);
+            throw exceptf<InvalidArgumentException>("Register name not recognized: %s", ri.c_str());
+        }
+        // find "=" sign
+        size_t i = ri.find('=');
+        if (i < 2 || i + 1 > ri.size()) // need at least 2 chars before and 1 char after
+        {
+            throw exceptf<InvalidArgumentException>("Invalid register specifier: %s", ri.c_str());
+        }
+        string sidx = ri.substr(1, i - 1);
+        string value = ri.substr(i + 1);
 
-            char* endptr;
-            unsigned long idx = strtoul(sidx.c_str(), &endptr, 0);
-            if (*endptr != '\0')
-            {
-                throw exceptf<InvalidArgumentException>("Invalid register number: %s (%s)", sidx.c_str(), ri.c_str());
-            }
+        char* endptr;
+        unsigned long idx = strtoul(sidx.c_str(), &endptr, 0);
+        if (*endptr != '\0')
+        {
+            throw exceptf<InvalidArgumentException>("Invalid register number: %s (%s)", sidx.c_str(), ri.c_str());
+        }
 
-            RegAddr reg_addr = MAKE_REGADDR((ri[0] == 'r') ? RT_INTEGER : RT_FLOAT, idx);
+        RegAddr reg_addr = MAKE_REGADDR((ri[0] == 'r') ? RT_INTEGER : RT_FLOAT, idx);
 
-            assert(value.size() > 0); // because of check above
+        assert(value.size() > 0); // because of check above
 
-            // First handle value indirections
-            if (value[0] == '$')
-            {
-                value = GetTopConf(value.substr(1), string);
-            }
-            m_reginits[reg_addr] = value;
+        // First handle value indirections
+        if (value[0] == '$')
+        {
+            value = GetTopConf(value.substr(1), string);
         }
+        m_reginits[reg_addr] = value;
     }
 }
 
@@ -188,8 +201,10 @@ void DRISC::Initialize()
     // Unfortunately the D-Cache needs priority here because otherwise all cache-lines can
     // remain filled and we get deadlock because the pipeline keeps wanting to do a read.
     m_dcache.p_service.AddProcess(m_dcache.p_ReadResponses);     // Memory read returns
+    m_dcache.p_service.AddProcess(m_dcache.p_WriteCombine);      // Combined writes
     m_dcache.p_service.AddProcess(m_pipeline.p_Pipeline);         // Memory read/write
     m_dcache.p_service.AddProcess(m_allocator.p_BundleCreate);    // Indirect create read
+    m_dcache.p_service.AddProcess(m_dcache.p_Prefetches);         // Prefetches
 
     m_allocator.p_allocation.AddProcess(m_pipeline.p_Pipeline);         // ALLOCATE instruction
     m_allocator.p_allocation.AddProcess(m_network.p_DelegationIn);      // Delegated non-exclusive create
@@ -341,6 +356,10 @@ void DRISC::Initialize()
 
     m_dcache.p_ReadResponses.SetStorageTraces(opt(m_dcache.m_writebacks));
 
+    m_dcache.p_Prefetches.SetStorageTraces(opt(m_dcache.m_outgoing));
+
+    m_dcache.p_WriteCombine.SetStorageTraces(opt(m_dcache.m_outgoing));
+
     m_dcache.p_ReadWritebacks.SetStorageTraces(
         /* Thread wakeup */ opt(m_allocator.m_readyThreadsOther) *
         /* Family sync */   opt(m_network.m_link.out ^ m_network.m_syncs) );
@@ -354,7 +373,8 @@ void DRISC::Initialize()
             m_allocator.m_cleanup ^
             m_allocator.m_readyThreadsPipe);
     StorageTraceSet pls_memory =
-        m_dcache.m_outgoing;
+        (opt(m_dcache.m_outgoing) * opt(m_dcache.m_prefetches)) ^
+        m_dcache.m_wcbQueue;
     StorageTraceSet pls_fetch =
         m_allocator.m_activeThreads;
 
@@ -547,6 +567,54 @@ void DRISC::UnmapMemory(ProcessID pid)
     m_memadmin->UnreserveAll(pid);
 }
 
+// Functional accesses bypass the memory system without declaring an
+// access to it, so MGSystem::Step runs the serial kernel while the
+// cores fast-forward.
+void DRISC::ReadMemory(MemAddr address, void* data, MemSize size) const
+{
+    assert(m_memadmin != NULL);
+    m_memadmin->Read(address, data, size);
+    m_memory->OnFunctionalRead(address, data, size);
+}
+
+void DRISC::WriteMemory(MemAddr address, const void* data, MemSize size)
+{
+    assert(m_memadmin != NULL);
+    m_memadmin->Write(address, data, NULL, size);
+    m_memory->OnFunctionalWrite(address, data, size);
+}
+
+void DRISC::SetFastForward(bool enabled, MemAddr marker)
+{
+    if (m_fastForward && !enabled)
+    {
+        // Other cores may have written to memory while fast-forwarding
+        // without updating our D-Cache; bring it up to date.
+        m_dcache.ReloadLines();
+    }
+    m_fastForward = enabled;
+    m_ffHeld      = false;
+    m_ffReached   = false;
+    m_ffMarker    = marker;
+}
+
+bool DRISC::HasPendingMemoryRequests() const
+{
+    return m_dcache.HasPendingRequests() || m_icache.HasPendingRequests();
+}
+
+void DRISC::OnFastForwardMarker()
+{
+    // The system switches all cores to detailed simulation once
+    // the current cycle has completed.
+    if (m_fastForward && !m_ffReached)
+    {
+        DebugSimWrite("reached end of fast-forwarding");
+        m_ffReached = true;
+        GetKernel()->Stop();
+    }
+}
+
 bool DRISC::CheckPermissions(MemAddr address, MemSize size, int access) const
 {
     assert(m_memadmin != NULL);
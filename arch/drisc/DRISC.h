@@ -54,6 +54,11 @@ public:
 
     bool Boot(MemAddr addr, bool legacy);
 
+    // Sets the initial values of registers of the first thread, as
+    // strings of the form RNNN=VAL or FNNN=VAL. The other registers
+    // keep their initial values. Takes effect at boot.
+    void SetInitialRegisters(const std::vector<std::string>& regs);
+
 private:
     // Helper to Initialize()
     void InitializeRegisters();
@@ -105,6 +110,30 @@ public:
     void UnmapMemory(ProcessID pid);
     bool CheckPermissions(MemAddr address, MemSize size, int access) const;
 
+    // Fast-forward mode. While enabled, the L1 caches service misses
+    // in the same cycle by accessing the memory contents directly,
+    // without simulating the memory system. The D-Cache still allocates
+    // lines for reads, so that it stays warm. The program runs through
+    // the regular pipeline, so all architectural state stays in place
+    // when the mode is disabled. The marker is the address of an
+    // instruction whose execution ends fast-forwarding (0 for none).
+    bool IsFastForward() const { return m_fastForward; }
+    void SetFastForward(bool enabled, MemAddr marker = 0);
+    bool HasReachedFastForwardMarker() const { return m_ffReached; }
+    void OnFastForwardMarker();
+    void CheckFastForwardMarker(MemAddr pc) { if (m_fastForward && pc == m_ffMarker && pc != 0) OnFastForwardMarker(); }
+
+    // Requests issued through the memory system before fast-forwarding
+    // must complete before memory is accessed directly. While held, the
+    // L1 caches stall all accesses in fast-forward mode.
+    bool IsFastForwardHeld() const { return m_ffHeld; }
+    void SetFastForwardHeld(bool held) { m_ffHeld = held; }
+    bool HasPendingMemoryRequests() const;
+
+    // Functional memory access, for fast-forward mode
+    void ReadMemory(MemAddr address, void* data, MemSize size) const;
+    void WriteMemory(MemAddr address, const void* data, MemSize size);
+
     BreakPointManager& GetBreakPointManager() { return m_bp_manager; }
     drisc::Network& GetNetwork() { return m_network; }
     drisc::IOInterface* GetIOInterface() { return m_io_if; }
@@ -128,6 +157,10 @@ private:
     FPU*                           m_fpu;
     SymbolTable*                   m_symtable;
     PID                            m_pid;
+    bool                           m_fastForward; ///< Fast-forward mode enabled?
+    bool                           m_ffHeld;      ///< Are memory accesses held while fast-forwarding?
+    bool                           m_ffReached;   ///< Has the end of fast-forwarding been requested?
+    MemAddr                        m_ffMarker;    ///< Instruction address that ends fast-forwarding
     // Register initializers
     std::map<RegAddr, std::string> m_reginits;
 
@@ -1,5 +1,6 @@
 #include "DebugChannel.h"
 #include <iomanip>
+#include <sstream>
 
 namespace Simulator
 {
@@ -45,29 +46,33 @@ Result DebugChannel::Write(MemAddr address, const void *data, MemSize size, LFID
                      (unsigned long long)value, (unsigned long long)value,
                      (unsigned)address);
 
+        // Formatted as if into m_output, and written with
+        // Kernel::WriteOutput to keep the order of the serial kernel.
+        std::ostringstream out;
+        out.copyfmt(m_output);
         switch (address)
         {
         case 0:
-            m_output << (char)value;
+            out << (char)value;
             break;
         case 1:
-            m_output << std::dec << value;
+            out << std::dec << value;
             break;
         case 2:
-            m_output << std::dec << (SInteger)value;
+            out << std::dec << (SInteger)value;
             break;
         case 3:
-            m_output << std::hex << (Integer)value;
+            out << std::hex << (Integer)value;
             break;
         case 4:
             m_floatprecision = value;
             break;
         case 5:
-            m_output << std::setprecision(m_floatprecision) << std::scientific << floatval.tofloat();
+            out << std::setprecision(m_floatprecision) << std::scientific << floatval.tofloat();
             break;
         }
 
-        m_output.flush();
+        Kernel::WriteOutput(m_output, out);
     }
     return SUCCESS;
 }
@@ -77,6 +82,7 @@ DebugChannel::DebugChannel(const std::string& name, Object& parent, std::ostream
       m_output(output),
       m_floatprecision(6)
 {
+    RegisterStateVariable(m_floatprecision, "floatprecision");
 }
 
 }
@@ -1,4 +1,6 @@
 #include "Pipeline.h"
+#include <sim/config.h>
+#include <sim/log2.h>
 #include <cassert>
 #include <sstream>
 #include <iomanip>
@@ -114,15 +116,44 @@ Pipeline::PipeAction Pipeline::DecodeStage::OnCycle()
 
         try
         {
-            // Default cases are just naturally-sized operations
-            m_output.RaSize = sizeof(Integer);
-            m_output.RbSize = sizeof(Integer);
-            m_output.RcSize = sizeof(Integer);
+            DecodedInstruction* entry = NULL;
+            if (!m_cache.empty())
+            {
+                // Fibonacci hashing of the instruction word
+                const size_t index = (uint64_t)(uint32_t)(m_input.instr * 2654435769U) >> m_cacheShift;
+                entry = &m_cache[index];
+            }
+
+            if (entry != NULL && entry->valid && entry->instr == m_input.instr)
+            {
+                // This instruction word was decoded before
+                entry->Restore(m_output);
+                ++m_numCacheHits;
+            }
+            else
+            {
+                // Start from a clean latch, so that the decoded fields
+                // only depend on the instruction word
+                (ArchDecodeReadLatch&)m_output = ArchDecodeReadLatch();
+                m_output.literal = 0;
+                m_output.regofs  = 0;
+
+                // Default cases are just naturally-sized operations
+                m_output.RaSize = sizeof(Integer);
+                m_output.RbSize = sizeof(Integer);
+                m_output.RcSize = sizeof(Integer);
 #if defined(TARGET_MTSPARC)
-            m_output.RsSize = sizeof(Integer);
+                m_output.RsSize = sizeof(Integer);
 #endif
 
-            DecodeInstruction(m_input.instr);
+                DecodeInstruction(m_input.instr);
+
+                if (entry != NULL)
+                {
+                    entry->Save(m_input.instr, m_output);
+                    ++m_numCacheMisses;
+                }
+            }
 
             DebugPipeWrite("F%u/T%u(%llu) %s decoded %s %s %s"
 #if defined(TARGET_MTSPARC)
@@ -176,11 +207,54 @@ Pipeline::PipeAction Pipeline::DecodeStage::OnCycle()
     return PIPE_CONTINUE;
 }
 
+void Pipeline::DecodeStage::DecodedInstruction::Save(Instruction i, const DecodeReadLatch& latch)
+{
+    valid        = true;
+    instr        = i;
+    arch         = latch;
+    literal      = latch.literal;
+    Ra           = latch.Ra;
+    Rb           = latch.Rb;
+    Rc           = latch.Rc;
+    RaSize       = latch.RaSize;
+    RbSize       = latch.RbSize;
+    RcSize       = latch.RcSize;
+    RaNotPending = latch.RaNotPending;
+    regofs       = latch.regofs;
+}
+
+void Pipeline::DecodeStage::DecodedInstruction::Restore(DecodeReadLatch& latch) const
+{
+    (ArchDecodeReadLatch&)latch = arch;
+    latch.literal      = literal;
+    latch.Ra           = Ra;
+    latch.Rb           = Rb;
+    latch.Rc           = Rc;
+    latch.RaSize       = RaSize;
+    latch.RbSize       = RbSize;
+    latch.RcSize       = RcSize;
+    latch.RaNotPending = RaNotPending;
+    latch.regofs       = regofs;
+}
+
 Pipeline::DecodeStage::DecodeStage(Pipeline& parent, const FetchDecodeLatch& input, DecodeReadLatch& output)
   : Stage("decode", parent),
     m_input(input),
-    m_output(output)
+    m_output(output),
+    m_cache(GetConfOpt("CacheSize", size_t, 0)),
+    m_cacheShift(0),
+    InitSampleVariable(numCacheHits, SVC_CUMULATIVE),
+    InitSampleVariable(numCacheMisses, SVC_CUMULATIVE)
 {
+    if (!IsPowerOfTwo(m_cache.size()))
+    {
+        throw InvalidArgumentException(*this, "CacheSize is not a power of two");
+    }
+    if (!m_cache.empty())
+    {
+        m_cacheShift = 32 - ilog2(m_cache.size());
+    }
+    RegisterStateObject(m_cache, "cache");
 }
 
 }
@@ -22,6 +22,8 @@ namespace Simulator
 namespace drisc
 {
 
+static const TraceEventType EV_EXEC("pipe.exec", {"pc", "tid", "fid"});
+
 /*static*/
 RegValue Pipeline::ExecuteStage::PipeValueToRegValue(RegType type, const PipeValue& v)
 {
@@ -108,11 +110,16 @@ Pipeline::PipeAction Pipeline::ExecuteStage::OnCycle()
     PipeAction action = ExecuteInstruction();
     if (action != PIPE_STALL)
     {
+        TraceEvent(EV_EXEC, m_input.pc, m_input.tid, m_input.fid);
+
         // Operation succeeded
         COMMIT
         {
             // We've executed an instruction
             m_op++;
+
+            GetDRISC().CheckFastForwardMarker(m_input.pc);
+
             if (action == PIPE_FLUSH)
             {
                 // Pipeline was flushed, thus there's a thread switch
@@ -395,8 +402,13 @@ void Pipeline::ExecuteStage::ExecDebugOutput(Integer value, int command, int fla
     //  3 -> (undefined)
     int outstream = flags & 3;
 
-    ostringstream stringout;
-    ostream& out = (outstream == 0) ? stringout : ((outstream == 2) ? cerr : cout);
+    // The output is formatted as if into the stream itself, and
+    // written with Kernel::WriteOutput to keep the order of the
+    // serial kernel with the parallel kernel.
+    ostream& stream = (outstream == 2) ? cerr : cout;
+    ostringstream out;
+    if (outstream != 0)
+        out.copyfmt(stream);
 
     switch (command)
     {
@@ -405,13 +417,16 @@ void Pipeline::ExecuteStage::ExecDebugOutput(Integer value, int command, int fla
     case 2: out << dec << (SInteger)value; break;
     case 3: out << (char)value; break;
     }
-    out << flush;
 
     if (outstream == 0)
     {
         DebugProgWrite("F%u/T%u(%llu) %s PRINT: %s",
                        (unsigned)m_input.fid, (unsigned)m_input.tid, (unsigned long long)m_input.logical_index, m_input.pc_sym,
-                       stringout.str().c_str());
+                       out.str().c_str());
+    }
+    else
+    {
+        Kernel::WriteOutput(stream, out);
     }
 }
 
@@ -434,8 +449,11 @@ void Pipeline::ExecuteStage::ExecStatusAction(Integer value, int command, int fl
 
     int outstream = flags & 3;
 
-    ostringstream stringout;
-    ostream& out = (outstream == 0) ? stringout : ((outstream == 2) ? cerr : cout);
+    // See ExecDebugOutput.
+    ostream& stream = (outstream == 2) ? cerr : cout;
+    ostringstream out;
+    if (outstream != 0)
+        out.copyfmt(stream);
 
     Integer msg = value;
     unsigned i;
@@ -449,7 +467,11 @@ void Pipeline::ExecuteStage::ExecStatusAction(Integer value, int command, int fl
     {
         DebugProgWrite("F%u/T%u(%llu) %s STATUS: %s",
                        (unsigned)m_input.fid, (unsigned)m_input.tid, (unsigned long long)m_input.logical_index, m_input.pc_sym,
-                       stringout.str().c_str());
+                       out.str().c_str());
+    }
+    else
+    {
+        Kernel::WriteOutput(stream, out);
     }
 
     switch(command)
@@ -556,9 +578,14 @@ void Pipeline::ExecuteStage::ExecDebug(double value, Integer stream) const
       break;
     case 1:
     case 2:
-      ostream& out = (s == 2) ? cerr : cout;
-        out << setprecision(prec) << scientific << value;
-    break;
+    {
+      ostream& stream = (s == 2) ? cerr : cout;
+      ostringstream out;
+      out.copyfmt(stream);
+      out << setprecision(prec) << scientific << value;
+      Kernel::WriteOutput(stream, out);
+      break;
+    }
     }
 }
 
@@ -31,6 +31,9 @@ FamilyTable::FamilyTable(const std::string& name, DRISC& parent)
     m_free[CONTEXT_EXCLUSIVE] = 1;
     m_free[CONTEXT_RESERVED]  = 0;
     m_free[CONTEXT_NORMAL]    = m_families.size() - 1;
+
+    RegisterStateObject(m_families, "families");
+    RegisterStateArray(&m_free[0], NUM_CONTEXT_TYPES, "free");
 }
 
 bool FamilyTable::IsEmpty() const
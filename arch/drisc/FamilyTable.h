@@ -22,6 +22,8 @@ struct Family
         RegIndex base;             // Base address of this family's register block
         RegSize  size;             // Size of the allocated registers (could be calculated from other values)
         RegIndex last_shareds;     // Address of the last allocated thread's shareds
+
+        SERIALIZE(a) { a & "fri" & count & base & size & last_shareds; }
     };
 
     // Groups all dependencies that need to be resolved before termination and/or cleanup
@@ -71,6 +73,12 @@ struct Family
          dependency.
         */
         unsigned int numPendingReads;
+
+        SERIALIZE(a)
+        {
+            a & "fd" & allocationDone & prevSynchronized & detached & syncSent
+              & numThreadsAllocated & numPendingReads;
+        }
         };
 
     PSize        placeSize;      // Number of cores this family wanted to run on.
@@ -104,6 +112,16 @@ struct Family
 
     // Admin
     FamilyState  state;          // Family state
+
+    SERIALIZE(a)
+    {
+        a & "f" & placeSize & numCores & capability & pc & physBlockSize
+          & start & step & limit & dependencies & link & hasShareds & legacy
+          & prevCleanedUp & broken & sync.pid & sync.reg & sync.done & lastAllocated;
+        for (auto& r : regs)
+            a & r;
+        a & state;
+    }
 };
 
 class FamilyTable : public Object, public Inspect::Interface<Inspect::Read>
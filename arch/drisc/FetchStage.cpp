@@ -175,6 +175,10 @@ Pipeline::FetchStage::FetchStage(Pipeline& parent, FetchDecodeLatch& output)
     }
 
     m_buffer = new char[m_icache.GetLineSize()];
+
+    RegisterStateArray(m_buffer, m_icache.GetLineSize(), "buffer");
+    RegisterStateVariable(m_switched, "switched");
+    RegisterStateVariable(m_pc, "pc");
 }
 
 Pipeline::FetchStage::~FetchStage()
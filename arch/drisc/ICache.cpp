@@ -26,6 +26,7 @@ ICache::ICache(const std::string& name, DRISC& parent, Clock& clock)
     InitBuffer(m_incoming, clock, "IncomingBufferSize"),
     m_lineSize(GetTopConf("CacheLineSize", size_t)),
     m_assoc   (GetConf("Associativity", size_t)),
+    m_array   (*this, m_selector->GetNumBanks(), m_assoc, GetConfOpt("ReplacementPolicy", string, "LRU")),
 
     InitSampleVariable(numHits, SVC_CUMULATIVE),
     InitSampleVariable(numDelayedReads, SVC_CUMULATIVE),
@@ -74,6 +75,7 @@ ICache::ICache(const std::string& name, DRISC& parent, Clock& clock)
     m_data.resize(m_lineSize * m_lines.size());
 
     RegisterStateVariable(m_data, "data");
+    m_array.RegisterState(*this);
 
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
@@ -103,6 +105,22 @@ ICache::~ICache()
     delete m_selector;
 }
 
+bool ICache::HasPendingRequests() const
+{
+    if (!m_outgoing.Empty())
+    {
+        return true;
+    }
+    for (auto& line : m_lines)
+    {
+        if (line.state == LINE_LOADING)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool ICache::IsEmpty() const
 {
     for (size_t i = 0; i < m_lines.size(); ++i)
@@ -129,33 +147,37 @@ Result ICache::FindLine(MemAddr address, Line* &line, bool check_only)
     const size_t  set  = setindex * m_assoc;
 
     // Find the line
-    Line* empty   = NULL;
-    Line* replace = NULL;
-    for (size_t i = 0; i < m_assoc; ++i)
+    for (CacheArray::WayMask m = m_array.Match(setindex, tag); m != 0; m &= m - 1)
     {
-        line = &m_lines[set + i];
-
-        if (line->state == LINE_EMPTY)
-        {
-            // Empty line, remember this one
-            empty = line;
-        }
-        else if (line->tag == tag)
+        line = &m_lines[set + CacheArray::LowestWay(m)];
+        if (line->state != LINE_EMPTY)
         {
             // The wanted line was in the cache
             return SUCCESS;
         }
-        else if (line->references == 0 && (replace == NULL || line->access < replace->access))
-        {
-            // The line is available to be replaced and has a lower LRU rating,
-            // remember it for replacing
-            replace = line;
-        }
     }
 
-    // The line could not be found, allocate the empty line or replace an existing line
-    line = (empty != NULL) ? empty : replace;
-    if (line == NULL)
+    // The line could not be found, allocate the last empty line or
+    // replace a line that is not referenced
+    CacheArray::WayMask empty = 0, replace = 0;
+    for (size_t i = 0; i < m_assoc; ++i)
+    {
+        const Line& l = m_lines[set + i];
+        if (l.state == LINE_EMPTY)
+            empty |= (CacheArray::WayMask)1 << i;
+        else if (l.references == 0)
+            replace |= (CacheArray::WayMask)1 << i;
+    }
+
+    if (empty != 0)
+    {
+        line = &m_lines[set + CacheArray::HighestWay(empty)];
+    }
+    else if (replace != 0)
+    {
+        line = &m_lines[set + m_array.Victim(setindex, replace)];
+    }
+    else
     {
         // No available line
         DeadlockWrite("Unable to allocate a cache-line for the request to %#016llx (set %u)",
@@ -168,7 +190,7 @@ Result ICache::FindLine(MemAddr address, Line* &line, bool check_only)
         COMMIT
         {
             // Reset the line
-            line->tag = tag;
+            m_array.Tag(line - &m_lines[0]) = tag;
         }
     }
     return DELAYED;
@@ -213,7 +235,7 @@ bool ICache::Read(CID cid, MemAddr address, void* data, MemSize size) const
     }
 #endif
 
-    if (m_lines[cid].state == LINE_EMPTY || m_lines[cid].tag != tag)
+    if (m_lines[cid].state == LINE_EMPTY || m_array.Tag(cid) != tag)
     {
         throw exceptf<InvalidArgumentException>(*this, "Read (%#016llx, %zd): Attempting to read from an invalid cache line",
                                                 (unsigned long long)address, (size_t)size);
@@ -271,6 +293,13 @@ Result ICache::Fetch(MemAddr address, MemSize size, TID* tid, CID* cid)
         return FAILED;
     }
 
+    if (cpu.IsFastForward() && cpu.IsFastForwardHeld())
+    {
+        DeadlockWrite("Holding I-Cache fetch (%#016llx, %zd) until memory requests have completed",
+                      (unsigned long long)address, (size_t)size);
+        return FAILED;
+    }
+
     // Align the address
     address = address - offset;
 
@@ -286,7 +315,7 @@ Result ICache::Fetch(MemAddr address, MemSize size, TID* tid, CID* cid)
     }
 
     // Update access time
-    COMMIT{ line->access = cpu.GetCycleNo(); }
+    COMMIT{ m_array.Touch(line - &m_lines[0], cpu.GetCycleNo()); }
 
     // If the caller wants the line index, give it
     if (cid != NULL)
@@ -341,6 +370,20 @@ Result ICache::Fetch(MemAddr address, MemSize size, TID* tid, CID* cid)
             ++m_numLoadingMisses;
         }
     }
+    else if (cpu.IsFastForward())
+    {
+        // Fast-forward: fill the line directly from memory
+        COMMIT
+        {
+            cpu.ReadMemory(address, line->data, m_lineSize);
+            line->creation     = false;
+            line->references   = 1;
+            line->state        = LINE_FULL;
+            line->waiting.head = INVALID_TID;
+            line->waiting.tail = INVALID_TID;
+        }
+        return SUCCESS;
+    }
     else
     {
         // Cache miss; a line has been allocated, fetch the data
@@ -417,7 +460,7 @@ bool ICache::OnMemoryWriteCompleted(TID /*tid*/)
     UNREACHABLE;
 }
 
-bool ICache::OnMemorySnooped(MemAddr address, const char * data, const bool * mask)
+bool ICache::OnMemorySnooped(MemAddr address, const char * data, LineMask mask)
 {
     Line* line;
     // Cache coherency: check if we have the same address
@@ -651,7 +694,7 @@ void ICache::Cmd_Read(std::ostream& out, const std::vector<std::string>& argumen
             }
 
             out << " | "
-                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(line.tag, set) * m_lineSize
+                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(m_array.Tag(i), set) * m_lineSize
                 << state << " |";
 
             if (line.state == LINE_FULL)
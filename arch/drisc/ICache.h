@@ -6,6 +6,7 @@
 #include "sim/inspect.h"
 #include "sim/buffer.h"
 #include "arch/Memory.h"
+#include "arch/CacheArray.h"
 #include "forward.h"
 
 namespace Simulator
@@ -25,18 +26,16 @@ class ICache : public Object, public IMemoryCallback, public Inspect::Interface<
         LINE_FULL,       ///< Line has data and can be reused
     };
 
-    /// A Cache-line
+    /// A Cache-line; its tag is in m_array.
     struct Line
     {
-        MemAddr       tag;          ///< Address tag
         char*         data;         ///< The line data
-        CycleNo       access;       ///< Last access time (for LRU replacement)
         ThreadQueue   waiting;      ///< Threads waiting on this line
         unsigned long references;   ///< Number of references to this line
         LineState     state;        ///< The state of the line
         bool          creation;             ///< Is the family creation process waiting on this line?
 
-        SERIALIZE(arch) { arch & "l" & tag & access & waiting & references & state & creation; }
+        SERIALIZE(arch) { arch & "l" & waiting & references & state & creation; }
     };
 
     Result Fetch(MemAddr address, MemSize size, TID* tid, CID* cid);
@@ -56,6 +55,7 @@ class ICache : public Object, public IMemoryCallback, public Inspect::Interface<
 
     size_t            m_lineSize;
     size_t            m_assoc;
+    CacheArray        m_array;
 
     // Statistics:
     DefineSampleVariable(uint64_t, numHits);
@@ -87,11 +87,12 @@ public:
     bool   Read(CID cid, MemAddr address, void* data, MemSize size) const;
     bool   ReleaseCacheLine(CID bid);
     bool   IsEmpty() const;
+    bool   HasPendingRequests() const;
 
     // IMemoryCallback
     bool   OnMemoryReadCompleted(MemAddr addr, const char* data) override;
     bool   OnMemoryWriteCompleted(TID tid) override;
-    bool   OnMemorySnooped(MemAddr addr, const char* data, const bool* mask) override;
+    bool   OnMemorySnooped(MemAddr addr, const char* data, LineMask mask) override;
     bool   OnMemoryInvalidated(MemAddr addr) override ;
     Object& GetMemoryPeer() override;
 
@@ -31,6 +31,13 @@ namespace drisc
         m_requests.Sensitive(p_MemoryOutgoing);
 
         p_BusOutgoing.SetStorageTraces(opt(m_busif.m_outgoing_reqs));
+
+        RegisterStateVariable(m_pending_writes, "pending_writes");
+        RegisterStateVariable(m_outstanding_address, "outstanding_address");
+        RegisterStateVariable(m_outstanding_size, "outstanding_size");
+        RegisterStateVariable(m_outstanding_client, "outstanding_client");
+        RegisterStateVariable(m_has_outstanding_request, "has_outstanding_request");
+        RegisterStateVariable(m_flushing, "flushing");
     }
 
     void IODirectCacheAccess::ConnectMemory(IMemory* memory)
@@ -115,7 +122,7 @@ namespace drisc
         return true;
     }
 
-    bool IODirectCacheAccess::OnMemorySnooped(MemAddr /*unused*/, const char* /*data*/, const bool* /*mask*/)
+    bool IODirectCacheAccess::OnMemorySnooped(MemAddr /*unused*/, const char* /*data*/, LineMask /*mask*/)
     {
         return true;
     }
@@ -330,9 +337,7 @@ namespace drisc
             MemData mdata;
             COMMIT{
                 std::copy(req.data, req.data + req.size, mdata.data + offset);
-                std::fill(mdata.mask, mdata.mask + offset, false);
-                std::fill(mdata.mask + offset, mdata.mask + offset + req.size, true);
-                std::fill(mdata.mask + offset + req.size, mdata.mask + m_lineSize, false);
+                mdata.mask = line::range(offset, req.size);
             }
 
             if (!m_memory->Write(m_mcid, line_address, mdata, INVALID_WCLIENTID))
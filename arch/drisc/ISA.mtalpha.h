@@ -712,6 +712,7 @@ struct ArchDecodeReadLatch
 
     ArchDecodeReadLatch() : format(IFORMAT_INVALID), displacement(0), function(0), opcode(0) {}
     virtual ~ArchDecodeReadLatch() {}
+    SERIALIZE(a) { a & format & displacement & function & opcode; }
 };
 
 typedef ArchDecodeReadLatch ArchReadExecuteLatch;
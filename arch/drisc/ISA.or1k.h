@@ -22,6 +22,7 @@ struct ArchDecodeReadLatch
         function(0),
         displacement(0)
     {}
+    SERIALIZE(a) { a & function & displacement; }
 };
 
 struct ArchReadExecuteLatch : public ArchDecodeReadLatch
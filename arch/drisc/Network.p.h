@@ -262,7 +262,7 @@ class Network : public Object, public Inspect::Interface<Inspect::Read>
                 assert(remote == NULL);
                 remote = &dest.in;
                 dest.in.AddProcess(p_Transfer);
-                p_Transfer.SetStorageTraces(dest.in);
+                p_Transfer.SetStorageTraces(dest.in * out);
             }
 
             RegisterPair(const std::string& name, Object& parent, Clock& clock)
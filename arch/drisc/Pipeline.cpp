@@ -103,6 +103,27 @@ Pipeline::Pipeline(const std::string&  name,
     bypasses.push_back(BypassInfo(m_mwBypass.empty, m_mwBypass.Rc, m_mwBypass.Rcv));
 
     m_stages[2].stage = new ReadStage(*this, m_drLatch, m_reLatch, bypasses);
+
+    RegisterStateObject(*this, "latches");
+}
+
+void Pipeline::RestoreSymbols()
+{
+    // Look up the symbolic PC of the latches again, like the fetch stage
+    for (auto& p : m_stages)
+    {
+        if (p.output != NULL)
+        {
+            if (GetKernel()->GetDebugMode() & Kernel::DEBUG_CPU_MASK)
+            {
+                p.output->pc_sym = GetDRISC().GetSymbolTable()[p.output->pc_dbg].c_str();
+            }
+            else
+            {
+                p.output->pc_sym = "(untranslated)";
+            }
+        }
+    }
 }
 
 void Pipeline::ConnectFPU(FPU* fpu)
@@ -38,6 +38,17 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
         };
         PipeValue() : m_state(RST_INVALID), m_size(0) {}
         std::string str(RegType type) const;
+
+        SERIALIZE(a)
+        {
+            a & "pv" & m_state & m_size;
+            switch (m_state)
+            {
+            case RST_INVALID: break;
+            case RST_FULL:    a & m_integer._64; break;
+            default:          a & m_waiting & m_memory; break;
+            }
+        }
     };
 
 #if defined(TARGET_MTALPHA)
@@ -95,6 +106,12 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
             Family::RegInfo family;
             Thread::RegInfo thread;
         } types[NUM_REG_TYPES];
+
+        SERIALIZE(a)
+        {
+            for (auto& t : types)
+                a & t.family & t.thread;
+        }
     };
 
     //
@@ -127,6 +144,9 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
         CommonData(const CommonData&) = default;
         CommonData& operator=(const CommonData&) = default;
         virtual ~CommonData() {}
+
+        // The symbolic PC is not serialized, see Pipeline::RestoreSymbols.
+        SERIALIZE(a) { a & "cd" & pc & tid & fid & swch & kill & pc_dbg & logical_index; }
     };
 
     struct Latch : public CommonData
@@ -134,6 +154,7 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
         bool empty;
 
         Latch() : empty(true) {}
+        SERIALIZE(a) { CommonData::serialize(a); a & empty; }
     };
 
     struct FetchDecodeLatch : public Latch
@@ -144,6 +165,7 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
         bool        legacy;
 
         FetchDecodeLatch() : instr(0), regs(), placeSize(0), legacy(false) {}
+        SERIALIZE(a) { Latch::serialize(a); a & instr & regs & placeSize & legacy; }
     };
 
     struct DecodeReadLatch : public Latch, public ArchDecodeReadLatch
@@ -174,6 +196,14 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
             RaNotPending(false),
             regofs(0),
             legacy(false) {}
+
+        SERIALIZE(a)
+        {
+            Latch::serialize(a);
+            ArchDecodeReadLatch::serialize(a);
+            a & literal & regs & placeSize & Ra & Rb & Rc & RaSize & RbSize & RcSize
+              & RaIsLocal & RbIsLocal & RaNotPending & regofs & legacy;
+        }
     };
 
     struct ReadExecuteLatch : public Latch, public ArchReadExecuteLatch
@@ -203,6 +233,13 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
             legacy(false),
             Ra(), Rb()
         {}
+
+        SERIALIZE(a)
+        {
+            Latch::serialize(a);
+            ArchReadExecuteLatch::serialize(a);
+            a & placeSize & regs & Rc & Rav & Rbv & RcSize & regofs & legacy & Ra & Rb;
+        }
     };
 
     struct ExecuteMemoryLatch : public Latch
@@ -231,6 +268,12 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
             Rcv(), Rc(),
             placeSize(0),
             Rrc(), Ra() {}
+
+        SERIALIZE(a)
+        {
+            Latch::serialize(a);
+            a & suspend & address & size & sign_extend & Rcv & Rc & placeSize & Rrc & Ra;
+        }
     };
 
     struct MemoryWritebackLatch : public Latch
@@ -242,6 +285,7 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
         RemoteMessage Rrc;
 
         MemoryWritebackLatch() : suspend(SUSPEND_NONE), Rc(), Rcv(), Rrc() {}
+        SERIALIZE(a) { Latch::serialize(a); a & suspend & Rc & Rcv & Rrc; }
     };
 
     //
@@ -282,9 +326,47 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
 
     class DecodeStage : public Stage
     {
+        /// Entry in the cache of decoded instructions.
+        /// Holds the fields that DecodeInstruction() produces for an
+        /// instruction word, before register translation.
+        struct DecodedInstruction
+        {
+            bool                valid;
+            Instruction         instr;
+            ArchDecodeReadLatch arch;
+            uint32_t            literal;
+            RegAddr             Ra, Rb, Rc;
+            unsigned int        RaSize, RbSize, RcSize;
+            bool                RaNotPending;
+            unsigned char       regofs;
+
+            void Save(Instruction i, const DecodeReadLatch& latch);
+            void Restore(DecodeReadLatch& latch) const;
+
+            DecodedInstruction() : valid(false), instr(0), arch(), literal(0), Ra(), Rb(), Rc(),
+                                   RaSize(0), RbSize(0), RcSize(0), RaNotPending(false), regofs(0) {}
+
+            SERIALIZE(a)
+            {
+                a & "di" & valid;
+                if (valid)
+                    a & instr & arch & literal & Ra & Rb & Rc & RaSize & RbSize & RcSize & RaNotPending & regofs;
+            }
+        };
+
         const FetchDecodeLatch& m_input;
         DecodeReadLatch&        m_output;
 
+        // Decoded instructions, indexed by a hash of the instruction word.
+        // Decoding only depends on the instruction word, so entries never
+        // need to be invalidated when the code changes.
+        std::vector<DecodedInstruction> m_cache;
+        unsigned                        m_cacheShift;   ///< Shift to get a cache index from a hash
+
+        // Statistics
+        DefineSampleVariable(uint64_t, numCacheHits);
+        DefineSampleVariable(uint64_t, numCacheMisses);
+
         PipeAction OnCycle();
         RegAddr TranslateRegister(uint8_t reg, RegType type, unsigned int size, bool *islocal) const;
         void    DecodeInstruction(const Instruction& instr);
@@ -313,6 +395,7 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
             PipeValue          value_reg; ///< Value as read from the register file
 
             OperandInfo() : port(0), addr(), value(), offset(0), islocal(false), addr_reg(), value_reg() {}
+            SERIALIZE(a) { a & "op" & addr & value & offset & islocal & addr_reg & value_reg; }
         };
 
         bool ReadRegister(OperandInfo& operand, uint32_t literal);
@@ -456,6 +539,7 @@ class Pipeline : public Object, public Inspect::Interface<Inspect::Read>
     };
 
     void PrintLatchCommon(std::ostream& out, const CommonData& latch) const;
+    void RestoreSymbols();
     static std::string MakePipeValue(const RegType& type, const PipeValue& value);
 
 public:
@@ -496,6 +580,16 @@ public:
 
     bool IsPipelineProcessActive() const { return m_running; }
 
+    // Serializes the latches, for checkpoints
+    SERIALIZE(a)
+    {
+        a & m_fdLatch & m_drLatch & m_reLatch & m_emLatch & m_mwLatch;
+        for (auto& latch : m_dummyLatches)
+            a & latch;
+        if (!a.reading())
+            RestoreSymbols();
+    }
+
     // Processes
     Process p_Pipeline;
 private:
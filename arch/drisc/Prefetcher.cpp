@@ -0,0 +1,275 @@
+#include <arch/drisc/Prefetcher.h>
+#include <sim/config.h>
+#include <sim/except.h>
+#include <sim/sampling.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace Simulator
+{
+namespace drisc
+{
+
+Prefetcher::Prefetcher(const string& name, Object& parent, size_t lineSize, size_t degree, size_t distance)
+    : Object(name, parent),
+      m_lineSize(lineSize),
+      m_degree(degree),
+      m_distance(distance)
+{
+}
+
+Prefetcher* Prefetcher::makePrefetcher(Object& parent, size_t lineSize)
+{
+    Config& config = *parent.GetKernel()->GetConfig();
+    const string name = config.getValueOrDefault<string>(parent, "Prefetcher", "NONE");
+    if (name == "NONE")
+    {
+        return NULL;
+    }
+
+    const size_t degree   = config.getValueOrDefault<size_t>(parent, "PrefetchDegree", 2);
+    const size_t distance = config.getValueOrDefault<size_t>(parent, "PrefetchDistance", 1);
+    if (degree == 0 || distance == 0)
+    {
+        throw exceptf<InvalidArgumentException>(parent, "PrefetchDegree and PrefetchDistance must be at least 1");
+    }
+
+    if (name == "NEXTLINE")
+    {
+        return new NextLinePrefetcher("prefetcher", parent, lineSize, degree, distance);
+    }
+
+    const size_t entries = config.getValueOrDefault<size_t>(parent, "PrefetchTableSize", 16);
+    if (entries == 0)
+    {
+        throw exceptf<InvalidArgumentException>(parent, "PrefetchTableSize must be at least 1");
+    }
+
+    if (name == "STRIDE") { return new StridePrefetcher("prefetcher", parent, lineSize, degree, distance, entries); }
+    if (name == "STREAM") { return new StreamPrefetcher("prefetcher", parent, lineSize, degree, distance, entries); }
+
+    throw exceptf<InvalidArgumentException>(parent, "Unknown prefetcher: %s", name.c_str());
+}
+
+//
+// NextLinePrefetcher
+//
+NextLinePrefetcher::NextLinePrefetcher(const string& name, Object& parent, size_t lineSize, size_t degree, size_t distance)
+    : Prefetcher(name, parent, lineSize, degree, distance)
+{
+}
+
+bool NextLinePrefetcher::OnRead(MemAddr /*pc*/, MemAddr address, bool miss, bool prefetched, PrefetchRun& run)
+{
+    if (!miss && !prefetched)
+    {
+        return false;
+    }
+
+    run.address = address - address % m_lineSize + m_distance * m_lineSize;
+    run.stride  = m_lineSize;
+    run.count   = m_degree;
+    return true;
+}
+
+//
+// StridePrefetcher
+//
+StridePrefetcher::StridePrefetcher(const string& name, Object& parent, size_t lineSize, size_t degree, size_t distance, size_t entries)
+    : Prefetcher(name, parent, lineSize, degree, distance),
+      m_pcs(entries, 0),
+      m_addresses(entries, 0),
+      m_strides(entries, 0),
+      m_confidence(entries, 0)
+{
+    RegisterStateObject(m_pcs, "pcs");
+    RegisterStateObject(m_addresses, "addresses");
+    RegisterStateObject(m_strides, "strides");
+    RegisterStateObject(m_confidence, "confidence");
+}
+
+bool StridePrefetcher::OnRead(MemAddr pc, MemAddr address, bool /*miss*/, bool /*prefetched*/, PrefetchRun& run)
+{
+    if (pc == 0)
+    {
+        // Not a load instruction
+        return false;
+    }
+
+    // Instructions are at least 4 bytes apart on all our ISAs
+    const size_t i = (pc / 4) % m_pcs.size();
+    if (m_pcs[i] != pc)
+    {
+        // New load, replace the entry
+        COMMIT
+        {
+            m_pcs[i]        = pc;
+            m_addresses[i]  = address;
+            m_strides[i]    = 0;
+            m_confidence[i] = 0;
+        }
+        return false;
+    }
+
+    const MemAddr prev   = m_addresses[i];
+    const int64_t stride = (int64_t)(address - prev);
+    COMMIT{ m_addresses[i] = address; }
+    if (stride == 0)
+    {
+        return false;
+    }
+
+    if (stride != m_strides[i])
+    {
+        // Lose confidence in the old stride before replacing it
+        COMMIT
+        {
+            if (m_confidence[i] > 0)
+                --m_confidence[i];
+            else
+                m_strides[i] = stride;
+        }
+        return false;
+    }
+
+    const uint8_t confidence = std::min<uint8_t>(m_confidence[i] + 1, 3);
+    COMMIT{ m_confidence[i] = confidence; }
+
+    // Prefetch once the stride is confirmed, and only when the load
+    // moves to another line; strides smaller than a line prefetch
+    // consecutive lines instead.
+    if (confidence < 2 || prev / m_lineSize == address / m_lineSize)
+    {
+        return false;
+    }
+
+    const int64_t lineSize = (int64_t)m_lineSize;
+    const int64_t step = (stride >= lineSize || stride <= -lineSize) ? stride : (stride < 0 ? -lineSize : lineSize);
+    run.address = address + step * (int64_t)m_distance;
+    run.stride  = step;
+    run.count   = m_degree;
+    return true;
+}
+
+//
+// StreamPrefetcher
+//
+StreamPrefetcher::StreamPrefetcher(const string& name, Object& parent, size_t lineSize, size_t degree, size_t distance, size_t streams)
+    : Prefetcher(name, parent, lineSize, degree, distance),
+      m_last(streams, 0),
+      m_next(streams, 0),
+      m_direction(streams, 0),
+      m_access(streams, 0),
+      m_accesses(0)
+{
+    RegisterStateObject(m_last, "last");
+    RegisterStateObject(m_next, "next");
+    RegisterStateObject(m_direction, "direction");
+    RegisterStateObject(m_access, "access");
+    RegisterStateVariable(m_accesses, "accesses");
+}
+
+// Extends the prefetched window of stream i, going in direction dir
+// with next as the next line to prefetch, after a demand read to line
+bool StreamPrefetcher::Advance(size_t i, int64_t dir, MemAddr next, MemAddr line, PrefetchRun& run)
+{
+    const MemAddr first = line + dir * (int64_t)m_distance;
+    const MemAddr last  = line + dir * (int64_t)(m_distance + m_degree - 1);
+
+    // Start after the lines that were already prefetched, unless the
+    // stream has overtaken them.
+    MemAddr start = next;
+    if ((int64_t)(first - start) * dir > 0)
+    {
+        start = first;
+    }
+
+    const int64_t count = (int64_t)(last - start) * dir + 1;
+    if (count <= 0)
+    {
+        return false;
+    }
+
+    run.address = start * m_lineSize;
+    run.stride  = dir * (int64_t)m_lineSize;
+    run.count   = count;
+    COMMIT{ m_next[i] = last + dir; }
+    return true;
+}
+
+bool StreamPrefetcher::OnRead(MemAddr /*pc*/, MemAddr address, bool miss, bool prefetched, PrefetchRun& run)
+{
+    const MemAddr  line   = address / m_lineSize;
+    const uint64_t access = m_accesses + 1;
+
+    // Reads ahead of a trained stream, within its window, move it forward
+    const int64_t window = m_distance + m_degree;
+    for (size_t i = 0; i < m_access.size(); ++i)
+    {
+        if (m_access[i] != 0 && m_direction[i] != 0)
+        {
+            const int64_t ahead = (int64_t)(line - m_last[i]) * m_direction[i];
+            if (ahead == 0)
+            {
+                return false;
+            }
+
+            if (ahead > 0 && ahead <= window)
+            {
+                COMMIT
+                {
+                    m_last[i]   = line;
+                    m_access[i] = m_accesses = access;
+                }
+                return Advance(i, m_direction[i], m_next[i], line, run);
+            }
+        }
+    }
+
+    if (!miss && !prefetched)
+    {
+        return false;
+    }
+
+    // A miss next to the last miss of a training tracker sets the
+    // direction of the stream
+    for (size_t i = 0; i < m_access.size(); ++i)
+    {
+        if (m_access[i] != 0 && m_direction[i] == 0)
+        {
+            if (line == m_last[i])
+            {
+                COMMIT{ m_access[i] = m_accesses = access; }
+                return false;
+            }
+
+            if (line == m_last[i] + 1 || line == m_last[i] - 1)
+            {
+                const int8_t dir = (line == m_last[i] + 1) ? 1 : -1;
+                COMMIT
+                {
+                    m_direction[i] = dir;
+                    m_last[i]      = line;
+                    m_access[i]    = m_accesses = access;
+                }
+                return Advance(i, dir, line + dir, line, run);
+            }
+        }
+    }
+
+    // Start training a new tracker, replacing the least recently used one
+    const size_t i = min_element(m_access.begin(), m_access.end()) - m_access.begin();
+    COMMIT
+    {
+        m_last[i]      = line;
+        m_next[i]      = line;
+        m_direction[i] = 0;
+        m_access[i]    = m_accesses = access;
+    }
+    return false;
+}
+
+}
+}
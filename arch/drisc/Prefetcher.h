@@ -0,0 +1,117 @@
+// -*- c++ -*-
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <sim/kernel.h>
+#include <arch/simtypes.h>
+
+#include <vector>
+
+namespace Simulator
+{
+namespace drisc
+{
+
+/*
+  Hardware prefetchers for the D-Cache.
+
+  A prefetcher observes the demand reads of the pipeline and
+  suggests lines to load ahead of time. The suggestion is a run of
+  'count' lines, starting at 'address' and 'stride' bytes apart. The
+  D-Cache queues the runs and issues them through its outgoing
+  buffer when the memory port is idle.
+
+  The prefetchers are configured from the D-Cache section:
+  - Prefetcher: NONE, NEXTLINE, STRIDE or STREAM;
+  - PrefetchDegree: number of lines per run;
+  - PrefetchDistance: how many lines (or strides) ahead of the
+    demand read the run starts;
+  - PrefetchTableSize: number of entries in the reference prediction
+    table (STRIDE) or number of stream trackers (STREAM).
+*/
+
+struct PrefetchRun
+{
+    MemAddr address;    ///< First address to prefetch
+    int64_t stride;     ///< Distance between the lines, in bytes
+    size_t  count;      ///< Number of lines to prefetch
+};
+
+class Prefetcher : public Object
+{
+protected:
+    size_t m_lineSize;  ///< Size of a cache line, in bytes
+    size_t m_degree;    ///< Config: number of lines per run
+    size_t m_distance;  ///< Config: prefetch distance, in lines or strides
+
+public:
+    Prefetcher(const std::string& name, Object& parent, size_t lineSize, size_t degree, size_t distance);
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+    virtual ~Prefetcher() {}
+
+    // Trains the prefetcher with a demand read at address by the
+    // load instruction at pc. 'miss' is set if the data was not in the
+    // cache yet and 'prefetched' if the read is the first use of a
+    // prefetched line. Returns true and fills run if lines should be
+    // prefetched. The prefetcher state is updated in the commit phase.
+    virtual bool OnRead(MemAddr pc, MemAddr address, bool miss, bool prefetched, PrefetchRun& run) = 0;
+
+    virtual const char* GetTypeName() const = 0;
+
+    // Creates the prefetcher configured for the parent cache, or NULL
+    // for none.
+    static Prefetcher* makePrefetcher(Object& parent, size_t lineSize);
+};
+
+// Prefetches the lines following a miss, or following the first use
+// of a prefetched line.
+class NextLinePrefetcher : public Prefetcher
+{
+public:
+    NextLinePrefetcher(const std::string& name, Object& parent, size_t lineSize, size_t degree, size_t distance);
+
+    bool OnRead(MemAddr pc, MemAddr address, bool miss, bool prefetched, PrefetchRun& run) override;
+    const char* GetTypeName() const override { return "NEXTLINE"; }
+};
+
+// Reference prediction table, indexed by PC: detects loads that access
+// memory with a constant stride and prefetches along that stride.
+class StridePrefetcher : public Prefetcher
+{
+    std::vector<MemAddr> m_pcs;         ///< PC of the load in each entry
+    std::vector<MemAddr> m_addresses;   ///< Last address read by the load
+    std::vector<int64_t> m_strides;     ///< Last detected stride
+    std::vector<uint8_t> m_confidence;  ///< Saturating confidence counter for the stride
+
+public:
+    StridePrefetcher(const std::string& name, Object& parent, size_t lineSize, size_t degree, size_t distance, size_t entries);
+
+    bool OnRead(MemAddr pc, MemAddr address, bool miss, bool prefetched, PrefetchRun& run) override;
+    const char* GetTypeName() const override { return "STRIDE"; }
+};
+
+// Stream buffers: trackers that are allocated on misses, train on a
+// miss to an adjacent line and then stay ahead of the stream by
+// prefetching consecutive lines in its direction.
+class StreamPrefetcher : public Prefetcher
+{
+    std::vector<MemAddr>  m_last;       ///< Last line read in the stream
+    std::vector<MemAddr>  m_next;       ///< Next line to prefetch in the stream
+    std::vector<int8_t>   m_direction;  ///< 1 or -1 for a trained stream, 0 if training
+    std::vector<uint64_t> m_access;     ///< Last use of the tracker (for LRU), 0 if unused
+    uint64_t              m_accesses;   ///< Number of tracker updates so far
+
+    bool Advance(size_t i, int64_t dir, MemAddr next, MemAddr line, PrefetchRun& run);
+
+public:
+    StreamPrefetcher(const std::string& name, Object& parent, size_t lineSize, size_t degree, size_t distance, size_t streams);
+
+    bool OnRead(MemAddr pc, MemAddr address, bool miss, bool prefetched, PrefetchRun& run) override;
+    const char* GetTypeName() const override { return "STREAM"; }
+};
+
+}
+}
+
+#endif
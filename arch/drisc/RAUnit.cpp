@@ -59,6 +59,8 @@ RAUnit::RAUnit(const string& name, Object& parent, const array<RegSize, NUM_REG_
         type.free[CONTEXT_EXCLUSIVE] = 1;
 
         type.list.resize(free_blocks, List::value_type(0, INVALID_LFID));
+
+        RegisterStateObject(type, "type" + to_string(i));
     }
 }
 
@@ -67,6 +67,12 @@ private:
         BlockSize free[NUM_CONTEXT_TYPES];  ///< Number of free blocks
 
         TypeInfo() : list(), blockSize() {};
+        SERIALIZE(a)
+        {
+            a & "rti" & list;
+            for (auto& f : free)
+                a & f;
+        }
     };
     TypeInfo m_types[NUM_REG_TYPES];
 };
@@ -510,6 +510,14 @@ Pipeline::ReadStage::ReadStage(Pipeline& parent,
     m_operand1.port = &m_regFile.p_pipelineR1;
     m_operand2.port = &m_regFile.p_pipelineR2;
     Clear(input.tid);
+
+    RegisterStateObject(m_operand1, "operand1");
+    RegisterStateObject(m_operand2, "operand2");
+    RegisterStateVariable(m_RaNotPending, "RaNotPending");
+#if defined(TARGET_MTSPARC)
+    RegisterStateVariable(m_isMemoryOp, "isMemoryOp");
+    RegisterStateObject(m_rsv, "rsv");
+#endif
 }
 
 }
@@ -29,6 +29,7 @@ RegisterFile::RegisterFile(const std::string& name, DRISC& parent, Clock& clock)
     p_asyncW    (*this, GetName() + ".p_asyncW"),
     m_files     (),
     m_sizes     (),
+    m_subfiles  (),
     m_nUpdates(0),
     m_local_aliases()
 {
@@ -42,6 +43,10 @@ RegisterFile::RegisterFile(const std::string& name, DRISC& parent, Clock& clock)
         {
             m_files[i][j] = MAKE_EMPTY_REG();
         }
+
+        static constexpr std::array<const char*, NUM_REG_TYPES> state_names = { {"intregs", "fltregs"} };
+        m_subfiles[i] = { (RegType)i, m_files[i], m_sizes[i] };
+        RegisterStateObject(m_subfiles[i], state_names[i]);
     }
     // Set write port priorities (from ReadWriteStructure); first port has highest priority
     AddPort(p_pipelineW);
@@ -112,8 +112,26 @@ private:
     // Applies the queued updates
     void Update() override;
 
+    // Serializes the registers of one type, for checkpoints
+    struct SubFile
+    {
+        RegType   type;
+        RegValue* regs;
+        RegSize   size;
+
+        SERIALIZE(a)
+        {
+            for (RegIndex i = 0; i < size; ++i)
+            {
+                RegAddr addr = MAKE_REGADDR(type, i);
+                a & Serialization::reg(addr, regs[i]);
+            }
+        }
+    };
+
     std::array<RegValue*, NUM_REG_TYPES> m_files; ///< Sub-files of registers, indexed by RegType
     std::array<RegSize, NUM_REG_TYPES> m_sizes;
+    std::array<SubFile, NUM_REG_TYPES> m_subfiles; ///< The sub-files, as registered for checkpoints
 
     // We can have at most this many number of updates per cycle.
     // This should be equal to the number of write ports.
@@ -34,6 +34,10 @@ ThreadTable::ThreadTable(const std::string& name, DRISC& parent)
     m_free[CONTEXT_NORMAL]    = m_threads.size() - 1;
     m_free[CONTEXT_RESERVED]  = 0;
     m_free[CONTEXT_EXCLUSIVE] = 1;
+
+    RegisterStateVariable(m_empty, "empty");
+    RegisterStateObject(m_threads, "threads");
+    RegisterStateArray(&m_free[0], NUM_CONTEXT_TYPES, "free");
 }
 
 bool ThreadTable::IsEmpty() const
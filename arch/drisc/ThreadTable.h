@@ -23,6 +23,8 @@ struct Thread
         RegIndex locals;
         RegIndex dependents;
         RegIndex shareds;
+
+        SERIALIZE(a) { a & "tri" & locals & dependents & shareds; }
     };
 
     // The dependencies that must be resolved before a thread can be cleaned up
@@ -56,6 +58,8 @@ struct Thread
          confirmed by the memory system.
         */
         unsigned int numPendingWrites;
+
+        SERIALIZE(a) { a & "td" & killed & prevCleanedUp & numPendingWrites; }
     };
 
     MemAddr      pc;
@@ -85,6 +89,22 @@ struct Thread
     // Admin
     uint64_t    index;
     ThreadState state;
+
+    SERIALIZE(a)
+    {
+        a & "t" & pc;
+        for (auto& r : regs)
+            a & r;
+        a & dependencies & nextInBlock & cid & family & next;
+#if defined(TARGET_MTALPHA)
+        a & fpcr;
+#elif defined(TARGET_MTSPARC)
+        a & psr & fsr & Y;
+#elif defined(TARGET_MIPS32) || defined(TARGET_MIPS32EL)
+        a & LO & HI;
+#endif
+        a & waitingForWrites & index & state;
+    }
 };
 
 class ThreadTable : public Object, public Inspect::Interface<Inspect::Read>
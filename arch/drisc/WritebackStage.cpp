@@ -321,6 +321,8 @@ Pipeline::WritebackStage::WritebackStage(Pipeline& parent,
     m_network(GetDRISC().GetNetwork()),
     m_writebackOffset(-1)
 {
+    RegisterStateVariable(m_stall, "stall");
+    RegisterStateVariable(m_writebackOffset, "writebackOffset");
 }
 
 }
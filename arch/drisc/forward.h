@@ -21,6 +21,7 @@ namespace Simulator
         class RAUnit;
         class ICache;
         class DCache;
+        class Prefetcher;
         class Network;
         class Pipeline;
         class Allocator;
@@ -27,7 +27,7 @@ namespace Simulator
                 ReceiverKey dst;
                 MessageType *msg;
 
-                SERIALIZE(a) { (void)a; }
+                SERIALIZE(a) { a & "[om" & type & dst & msg & "]"; }
             };
 
             struct EndPoint
@@ -125,7 +125,7 @@ class BankedMemory::Bank : public Object
         {
             // This bank is done serving the request
             if (m_request.write) {
-                static_cast<VirtualMemory&>(m_memory).Write(m_request.address, m_request.data.data, m_request.data.mask, m_request.size);
+                static_cast<VirtualMemory&>(m_memory).WriteLine(m_request.address, m_request.data.data, m_request.data.mask, m_request.size);
             } else {
                 static_cast<VirtualMemory&>(m_memory).Read(m_request.address, m_request.data.data, m_request.size);
             }
@@ -163,7 +163,7 @@ class BankedMemory::Bank : public Object
             for (size_t x = 0; x < request.size; ++x)
             {
                 out << " ";
-                if (request.data.mask[x])
+                if (line::test(request.data.mask, x))
                     out << setw(2) << (unsigned)(unsigned char)request.data.data[x];
                 else
                     out << "--";
@@ -250,7 +250,7 @@ public:
         RegisterStateVariable(m_request.address, "request.address");
         RegisterStateVariable(m_request.size, "request.size");
         RegisterStateArray(m_request.data.data, sizeof(m_request.data.data)/sizeof(m_request.data.data[0]), "request.data");
-        RegisterStateArray(m_request.data.mask, sizeof(m_request.data.mask)/sizeof(m_request.data.mask[0]), "request.mask");
+        RegisterStateVariable(m_request.data.mask, "request.mask");
         RegisterStateVariable(m_request.wid, "request.wid");
         RegisterStateVariable(m_request.done, "request.done");
 
@@ -282,6 +282,11 @@ CycleNo BankedMemory::GetMemoryDelay(size_t data_size) const
 
 MCID BankedMemory::RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool /*ignored*/)
 {
+    // The client's process calls into the memory, and the memory's
+    // processes call back into the client.
+    GetKernel()->DeclareAccess(process, GetName());
+    GetKernel()->DeclareAccess(GetName(), process.GetName());
+
 #ifndef NDEBUG
     for (size_t i = 0; i < m_clients.size(); ++i) {
         assert(m_clients[i].callback != &callback);
@@ -360,7 +365,7 @@ bool BankedMemory::Write(MCID id, MemAddr address, const MemData& data, WClientI
     request.write     = true;
     COMMIT{
     std::copy(data.data, data.data+m_lineSize, request.data.data);
-    std::copy(data.mask, data.mask+m_lineSize, request.data.mask);
+    request.data.mask = data.mask;
     }
 
     // Broadcast the snoop data
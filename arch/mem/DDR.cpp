@@ -15,27 +15,49 @@ static T GET_BITS(const T& value, unsigned int offset, unsigned int size)
     return (value >> offset) & ((T(1) << size) - 1);
 }
 
-static const unsigned long INVALID_ROW = std::numeric_limits<unsigned long>::max();
+static const unsigned INVALID_ROW = std::numeric_limits<unsigned>::max();
 
-bool DDRChannel::Read(MemAddr address, MemSize size)
+// The state of a single bank, shared by all devices of a rank
+class DDRChannel::Bank : public Object
 {
-    if (m_busy.IsSet())
+public:
+    DefineStateVariable(unsigned, row);             ///< Currently open row, or INVALID_ROW
+    DefineStateVariable(bool,     opened);          ///< The row was opened and not yet accessed
+    DefineStateVariable(CycleNo,  next_activate);   ///< Minimum time for next Activate (tRP)
+    DefineStateVariable(CycleNo,  next_column);     ///< Minimum time for next Read or Write (tRCD)
+    DefineStateVariable(CycleNo,  next_precharge);  ///< Minimum time for next Precharge (tRAS, tWR)
+
+    // Statistics
+    DefineSampleVariable(uint64_t, rowhits);        ///< Bursts to a row that was already open
+    DefineSampleVariable(uint64_t, conflicts);      ///< Rows closed to open another one
+    DefineSampleVariable(CycleNo,  busyCycles);     ///< Cycles occupied by commands to this bank
+
+    Bank(const std::string& name, DDRChannel& parent)
+        : Object(name, parent),
+          InitStateVariable(row, INVALID_ROW),
+          InitStateVariable(opened, false),
+          InitStateVariable(next_activate, 0),
+          InitStateVariable(next_column, 0),
+          InitStateVariable(next_precharge, 0),
+          InitSampleVariable(rowhits, SVC_CUMULATIVE),
+          InitSampleVariable(conflicts, SVC_CUMULATIVE),
+          InitSampleVariable(busyCycles, SVC_CUMULATIVE)
     {
-        // We're still busy
-        return false;
     }
+};
 
-    // Accept request
-    COMMIT
-    {
-        m_request.address = address;
-        m_request.offset  = 0;
-        m_request.size    = size;
-        m_request.write   = false;
-    }
-
-    if (!m_busy.Set())
+bool DDRChannel::Read(MemAddr address, MemSize size)
+{
+    Request request;
+    request.address = address;
+    request.offset  = 0;
+    request.size    = size;
+    request.write   = false;
+    request.done    = 0;
+
+    if (!m_incoming.Push(std::move(request)))
     {
+        // We're still busy
         return false;
     }
     return true;
@@ -43,130 +65,302 @@ bool DDRChannel::Read(MemAddr address, MemSize size)
 
 bool DDRChannel::Write(MemAddr address, MemSize size)
 {
-    if (m_busy.IsSet())
+    Request request;
+    request.address = address;
+    request.offset  = 0;
+    request.size    = size;
+    request.write   = true;
+    request.done    = 0;
+
+    if (!m_incoming.Push(std::move(request)))
     {
         // We're still busy
         return false;
     }
+    return true;
+}
 
-    // Accept request
-    COMMIT
+// Decode the bank array, row and offset-within-burst of the next burst of a request
+void DDRChannel::DecodeAddress(const Request& req, unsigned& array, unsigned& row, unsigned& offset) const
+{
+    // We read from m_nDevicesPerRank devices, each providing m_nBurstLength bytes in the burst.
+    const MemAddr      address = (req.address + req.offset) / m_ddrconfig.m_nDevicesPerRank;
+    const unsigned int bank    = GET_BITS(address, m_ddrconfig.m_nBankStart, m_ddrconfig.m_nBankBits),
+                       rank    = GET_BITS(address, m_ddrconfig.m_nRankStart, m_ddrconfig.m_nRankBits);
+
+    offset = (req.address + req.offset) % m_ddrconfig.m_nDevicesPerRank;
+    row    = GET_BITS(address, m_ddrconfig.m_nRowStart,  m_ddrconfig.m_nRowBits);
+
+    // Ranks and banks are analogous in this concept; each bank can be invidually pre-charged and activated,
+    // providing an array of rows * columns cells.
+    array  = rank * (1 << m_ddrconfig.m_nBankBits) + bank;
+}
+
+// Determine the next command for the request, and whether it can be issued now
+DDRChannel::Command DDRChannel::GetCommand(const Request& req, CycleNo now, bool& ready) const
+{
+    unsigned array, row, offset;
+    DecodeAddress(req, array, row, offset);
+    const Bank& bank = *m_banks[array];
+
+    if (bank.m_row == row)
     {
-        m_request.address = address;
-        m_request.offset  = 0;
-        m_request.size    = size;
-        m_request.write   = true;
+        ready = (now >= bank.m_next_column && now >= m_next_column);
+        return req.write ? CMD_WRITE : CMD_READ;
     }
 
-    if (!m_busy.Set())
+    if (bank.m_row != INVALID_ROW)
     {
-        return false;
+        ready = (now >= bank.m_next_precharge);
+        return CMD_PRECHARGE;
     }
-    return true;
+
+    const Rank& rank = m_ranks[array >> m_ddrconfig.m_nBankBits];
+    ready = (now >= bank.m_next_activate && now >= rank.next_activate);
+    return CMD_ACTIVATE;
 }
 
-// Main process for timing the current active request
-Result DDRChannel::DoRequest()
+// Select the queued request to issue the next command for, or
+// m_queue.size() if no command can be issued this cycle.
+// Also returns the new write drain state in draining.
+size_t DDRChannel::SelectRequest(CycleNo now, bool& draining) const
 {
-    assert(m_busy.IsSet());
+    assert(!m_queue.empty());
 
-    const CycleNo now = GetKernel()->GetActiveClock()->GetCycleNo();
-    if (now < m_next_command)
+    bool ready;
+    draining = m_draining;
+    if (m_scheduler == SCHED_FCFS)
     {
-        // Can't continue yet
-        return SUCCESS;
+        GetCommand(m_queue.front(), now, ready);
+        return ready ? 0 : m_queue.size();
     }
 
-    // We read from m_nDevicesPerRank devices, each providing m_nBurstLength bytes in the burst.
-    const unsigned burst_size = m_ddrconfig.m_nBurstSize;
+    size_t nwrites = 0;
+    for (auto& req : m_queue)
+    {
+        nwrites += req.write;
+    }
 
-    // Decode the burst address and offset-within-burst
-    const MemAddr      address = (m_request.address + m_request.offset) / m_ddrconfig.m_nDevicesPerRank;
-    const unsigned int offset  = (m_request.address + m_request.offset) % m_ddrconfig.m_nDevicesPerRank;
-    const unsigned int bank    = GET_BITS(address, m_ddrconfig.m_nBankStart, m_ddrconfig.m_nBankBits),
-                       rank    = GET_BITS(address, m_ddrconfig.m_nRankStart, m_ddrconfig.m_nRankBits),
-                       row     = GET_BITS(address, m_ddrconfig.m_nRowStart,  m_ddrconfig.m_nRowBits);
+    if (nwrites >= m_writeHigh) {
+        draining = true;
+    } else if (nwrites <= m_writeLow) {
+        draining = false;
+    }
 
-    // Ranks and banks are analogous in this concept; each bank can be invidually pre-charged and activated,
-    // providing an array of rows * columns cells.
-    const unsigned int array  = rank * (1 << m_ddrconfig.m_nBankBits) + bank;
+    // Serve the preferred request type, unless there are none of it
+    bool write = draining;
+    if (nwrites == (write ? 0 : m_queue.size()))
+    {
+        write = !write;
+    }
 
-    if (m_currentRow[array] != row)
+    // The oldest ready row hit of the preferred type, otherwise the
+    // oldest request of that type whose next command is ready
+    size_t oldest = m_queue.size();
+    for (size_t i = 0; i < m_queue.size(); ++i)
     {
-        if (m_currentRow[array] != INVALID_ROW)
+        const Request& req = m_queue[i];
+        if (req.write != write)
         {
-            // Precharge (close) the currently active row
-            COMMIT
-            {
-                m_next_command = std::max(m_next_precharge, now) + m_ddrconfig.m_tRP;
-                m_currentRow[array] = INVALID_ROW;
-            }
-            return SUCCESS;
+            continue;
         }
 
-        // Activate (open) the desired row
-        COMMIT
+        const Command cmd = GetCommand(req, now, ready);
+        if (!ready)
         {
-            m_next_command   = now + m_ddrconfig.m_tRCD;
-            m_next_precharge = now + m_ddrconfig.m_tRAS;
-
-            m_currentRow[array] = row;
+            continue;
         }
-        return SUCCESS;
-    }
-
-    // Process a single burst
-    unsigned int remainder = m_request.size - m_request.offset;
-    unsigned int size      = std::min(burst_size - offset, remainder);
 
-    if (m_request.write)
-    {
-        COMMIT
+        if (cmd == CMD_READ || cmd == CMD_WRITE)
         {
-            // Update address to reflect written portion
-            m_request.offset += size;
+            return i;
+        }
 
-            m_next_command   = now + m_ddrconfig.m_tCWL;
-            m_next_precharge = now + m_ddrconfig.m_tWR;
+        if (oldest == m_queue.size() && (cmd != CMD_PRECHARGE || !HasRowHits(req, write)))
+        {
+            oldest = i;
         }
+    }
+    return oldest;
+}
 
-        if (size < remainder)
+// Whether queued requests of the given type still hit the row
+// that is open in the bank of the specified request
+bool DDRChannel::HasRowHits(const Request& req, bool write) const
+{
+    unsigned array, row, offset;
+    DecodeAddress(req, array, row, offset);
+    for (auto& other : m_queue)
+    {
+        unsigned a, r;
+        DecodeAddress(other, a, r, offset);
+        if (other.write == write && a == array && r == m_banks[array]->m_row)
         {
-            // We're not done yet
-            return SUCCESS;
+            return true;
         }
     }
-    else
+    return false;
+}
+
+// Main process for accepting requests and issuing DDR commands
+Result DDRChannel::DoRequest()
+{
+    const CycleNo now = GetKernel()->GetActiveClock()->GetCycleNo();
+
+    // Whether a queued request completes this cycle, and which one
+    bool   completed = false;
+    size_t index     = m_queue.size();
+
+    if (!m_queue.empty())
+    {
+        bool draining;
+        index = SelectRequest(now, draining);
+
+        COMMIT{ m_draining = draining; }
+    }
+
+    if (index < m_queue.size())
     {
-        COMMIT
+        Request& request = m_queue[index];
+
+        unsigned array, row, offset;
+        DecodeAddress(request, array, row, offset);
+        Bank& bank = *m_banks[array];
+        Rank& rank = m_ranks[array >> m_ddrconfig.m_nBankBits];
+
+        bool ready;
+        switch (GetCommand(request, now, ready))
         {
-            // Update address to reflect read portion
-            m_request.offset += size;
-            m_request.done    = now + m_ddrconfig.m_tCL;
+        case CMD_PRECHARGE:
+            // Precharge (close) the currently active row
+            COMMIT
+            {
+                bank.m_next_activate = now + m_ddrconfig.m_tRP;
+                bank.m_row = INVALID_ROW;
 
-            // Schedule next read
-            m_next_command = now + m_ddrconfig.m_tCCD;
-        }
+                ++bank.m_conflicts;
+                bank.m_busyCycles += m_ddrconfig.m_tRP;
+            }
+            break;
 
-        if (size < remainder)
+        case CMD_ACTIVATE:
+            // Activate (open) the desired row
+            COMMIT
+            {
+                bank.m_next_column    = now + m_ddrconfig.m_tRCD;
+                bank.m_next_precharge = now + m_ddrconfig.m_tRAS;
+                bank.m_row            = row;
+                bank.m_opened         = true;
+                bank.m_busyCycles    += m_ddrconfig.m_tRCD;
+
+                // Record the activation in the rank's activation window
+                if (rank.nactivations == 4)
+                {
+                    std::copy(rank.activations + 1, rank.activations + 4, rank.activations);
+                    --rank.nactivations;
+                }
+                rank.activations[rank.nactivations++] = now;
+
+                rank.next_activate = now + m_ddrconfig.m_tRRD;
+                if (rank.nactivations == 4)
+                {
+                    rank.next_activate = std::max<CycleNo>(rank.next_activate, rank.activations[0] + m_ddrconfig.m_tFAW);
+                }
+            }
+            break;
+
+        case CMD_READ:
+        case CMD_WRITE:
         {
-            // We're not done yet
-            return SUCCESS;
+            // Process a single burst
+            const unsigned int burst_size = m_ddrconfig.m_nBurstSize;
+            const unsigned int remainder  = request.size - request.offset;
+            const unsigned int size       = std::min(burst_size - offset, remainder);
+
+            COMMIT
+            {
+                if (!bank.m_opened)
+                {
+                    ++bank.m_rowhits;
+                }
+                bank.m_opened = false;
+            }
+
+            if (request.write)
+            {
+                COMMIT
+                {
+                    // Update address to reflect written portion
+                    request.offset += size;
+
+                    m_next_column         = now + m_ddrconfig.m_tCWL;
+                    bank.m_next_precharge = std::max<CycleNo>(bank.m_next_precharge, now + m_ddrconfig.m_tWR);
+                    bank.m_busyCycles    += m_ddrconfig.m_tCWL;
+                }
+            }
+            else
+            {
+                COMMIT
+                {
+                    // Update address to reflect read portion
+                    request.offset += size;
+                    request.done    = now + m_ddrconfig.m_tCL;
+
+                    // Schedule next read
+                    m_next_column      = now + m_ddrconfig.m_tCCD;
+                    bank.m_busyCycles += m_ddrconfig.m_tCCD;
+                }
+
+                if (size >= remainder)
+                {
+                    // We're done with this read; queue it into the pipeline
+                    if (!m_pipeline.Push(request))
+                    {
+                        // The read pipeline should be big enough
+                        DeadlockWrite("DDR read pipeline full");
+                        return FAILED;
+                    }
+                }
+            }
+
+            if (size >= remainder)
+            {
+                // We've completed this request
+                completed = true;
+            }
+            break;
+        }
         }
+    }
+
+    // Accept a new request if there is room in the queue
+    const bool accept = !m_incoming.Empty() && m_queue.size() < m_queueSize;
 
-        // We're done with this read; queue it into the pipeline
-        if (!m_pipeline.Push(std::move(m_request)))
+    const size_t size = m_queue.size() - completed + accept;
+    if (size == 0 && m_busy.IsSet())
+    {
+        if (!m_busy.Clear())
+        {
+            return FAILED;
+        }
+    }
+    else if (size > 0 && !m_busy.IsSet())
+    {
+        if (!m_busy.Set())
         {
-            // The read pipeline should be big enough
-            DeadlockWrite("DDR read pipeline full");
             return FAILED;
         }
     }
 
-    // We've completed this request
-    if (!m_busy.Clear())
+    if (accept)
     {
-        return FAILED;
+        COMMIT{ m_queue.push_back(m_incoming.Front()); }
+        m_incoming.Pop();
+    }
+
+    if (completed)
+    {
+        COMMIT{ m_queue.erase(m_queue.begin() + index); }
     }
     return SUCCESS;
 }
@@ -180,7 +374,7 @@ Result DDRChannel::DoPipeline()
     {
         // The last burst has completed, send the assembled data back
         assert(!request.write);
-        if (!m_callback->OnReadCompleted())
+        if (!m_callback->OnReadCompleted(request.address))
         {
             return FAILED;
         }
@@ -204,6 +398,8 @@ DDRChannel::DDRConfig::DDRConfig(const std::string& name, Object& parent, Clock&
       m_tCCD (GetConf("tCCD", unsigned)),
       m_tCWL (GetConf("tCWL", unsigned)),
       m_tRAS (GetConf("tRAS", unsigned)),
+      m_tRRD (GetConf("tRRD", unsigned)),
+      m_tFAW (GetConf("tFAW", unsigned)),
 
       // Address bit mapping.
       m_nDevicesPerRank (GetConf("DevicesPerRank", size_t)),
@@ -230,14 +426,19 @@ DDRChannel::DDRConfig::DDRConfig(const std::string& name, Object& parent, Clock&
 DDRChannel::DDRChannel(const std::string& name, Object& parent, Clock& clock)
     : Object(name, parent),
       m_ddrconfig("config", *this, clock),
-      // Initialize each rank at 'no row selected'
-      m_currentRow(1 << (m_ddrconfig.m_nRankBits + m_ddrconfig.m_nBankBits), INVALID_ROW),
+      m_scheduler(SCHED_FRFCFS),
+      m_queueSize(GetConfOpt("QueueSize", size_t, 16)),
+      m_writeHigh(GetConfOpt("WriteHighWatermark", size_t, m_queueSize * 3 / 4)),
+      m_writeLow (GetConfOpt("WriteLowWatermark", size_t, m_queueSize / 4)),
+      m_banks(1 << (m_ddrconfig.m_nRankBits + m_ddrconfig.m_nBankBits)),
+      m_ranks(1 << m_ddrconfig.m_nRankBits),
       m_callback(0),
-      m_request(),
+      InitStorage(m_incoming, clock, 1),
+      m_queue(),
       InitStorage(m_pipeline, clock, m_ddrconfig.m_tCL),
       InitStorage(m_busy, clock, false),
-      InitStateVariable(next_command, 0),
-      InitStateVariable(next_precharge, 0),
+      InitStateVariable(draining, false),
+      InitStateVariable(next_column, 0),
       m_traces(),
 
       InitProcess(p_Request, DoRequest),
@@ -245,15 +446,33 @@ DDRChannel::DDRChannel(const std::string& name, Object& parent, Clock& clock)
 
       InitSampleVariable(busyCycles, SVC_CUMULATIVE)
 {
-    RegisterStateVariable(m_currentRow, "currentRow");
-    RegisterStateVariable(m_request.address, "request.address");
-    RegisterStateVariable(m_request.write, "request.write");
-    RegisterStateVariable(m_request.size, "request.size");
-    RegisterStateVariable(m_request.offset, "request.offset");
-    RegisterStateArray(m_request.data.data, sizeof(m_request.data.data)/sizeof(m_request.data.data[0]), "request.data");
-    RegisterStateArray(m_request.data.mask, sizeof(m_request.data.mask)/sizeof(m_request.data.mask[0]), "request.mask");
-    RegisterStateVariable(m_request.done, "request.done");
+    const std::string scheduler = GetConfOpt("Scheduler", std::string, "FRFCFS");
+    if (scheduler == "FCFS") {
+        m_scheduler = SCHED_FCFS;
+    } else if (scheduler != "FRFCFS") {
+        throw exceptf<InvalidArgumentException>(*this, "Unknown DDR scheduler: %s", scheduler.c_str());
+    }
 
+    if (m_queueSize == 0)
+    {
+        throw InvalidArgumentException(*this, "QueueSize must be at least 1");
+    }
+
+    if (m_writeLow > m_writeHigh)
+    {
+        throw InvalidArgumentException(*this, "WriteLowWatermark cannot exceed WriteHighWatermark");
+    }
+
+    // Initialize each bank at 'no row selected'
+    for (size_t i = 0; i < m_banks.size(); ++i)
+    {
+        m_banks[i] = new Bank("bank" + std::to_string(i), *this);
+    }
+
+    RegisterStateObject(m_ranks, "ranks");
+    RegisterStateObject(m_queue, "queue");
+
+    m_incoming.Sensitive(p_Request);
     m_busy.Sensitive(p_Request);
     m_pipeline.Sensitive(p_Pipeline);
 
@@ -265,8 +484,12 @@ DDRChannel::DDRChannel(const std::string& name, Object& parent, Clock& clock)
     RegisterModelProperty(*this, "CWL", (uint32_t)m_ddrconfig.m_tCWL);
     RegisterModelProperty(*this, "CCD", (uint32_t)m_ddrconfig.m_tCCD);
     RegisterModelProperty(*this, "WR", (uint32_t)m_ddrconfig.m_tWR);
+    RegisterModelProperty(*this, "RRD", (uint32_t)m_ddrconfig.m_tRRD);
+    RegisterModelProperty(*this, "FAW", (uint32_t)m_ddrconfig.m_tFAW);
+    RegisterModelProperty(*this, "queue", (uint32_t)m_queueSize);
     RegisterModelProperty(*this, "chips/rank", (uint32_t)m_ddrconfig.m_nDevicesPerRank);
     RegisterModelProperty(*this, "ranks", (uint32_t)(1UL<<m_ddrconfig.m_nRankBits));
+    RegisterModelProperty(*this, "banks", (uint32_t)(1UL<<m_ddrconfig.m_nBankBits));
     RegisterModelProperty(*this, "rows", (uint32_t)(1UL<<m_ddrconfig.m_nRowBits));
     RegisterModelProperty(*this, "columns", (uint32_t)(1UL<<m_ddrconfig.m_nColumnBits));
     RegisterModelProperty(*this, "freq", (uint32_t)clock.GetFrequency());
@@ -281,8 +504,8 @@ void DDRChannel::SetClient(ICallback& cb, StorageTraceSet& sts, const StorageTra
     }
     m_callback = &cb;
 
-    sts = m_busy;
-    p_Request.SetStorageTraces(opt(opt(m_pipeline) * m_busy));
+    sts = m_incoming;
+    p_Request.SetStorageTraces(opt(m_pipeline) * opt(m_busy) * opt(m_incoming));
     p_Pipeline.SetStorageTraces(opt(storages));
 
     RegisterModelBidiRelation(cb, *this, "ddr");
@@ -290,6 +513,8 @@ void DDRChannel::SetClient(ICallback& cb, StorageTraceSet& sts, const StorageTra
 
 DDRChannel::~DDRChannel()
 {
+    for (auto p : m_banks)
+        delete p;
 }
 
 DDRChannelRegistry::DDRChannelRegistry(const std::string& name, Object& parent, size_t defaultNumChannels)
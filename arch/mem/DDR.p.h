@@ -43,6 +43,14 @@ Note that a row cannot be precharged (closed) until at least tWR (Write
 Recovery) cycles after the last write and at least tRAS (Row Active to
 Precharge Delay) cycles after opening the row.
 
+Each bank has its own row buffer, so commands to different banks can
+overlap: a bank can be precharged or activated while another bank
+transfers data. Only the data bus is shared by all banks of a channel.
+To limit the power drawn by the devices, two activations in the same
+rank must be at least tRRD (Row to Row Delay) cycles apart, and at most
+four activations can occur in the same rank in any window of tFAW (Four
+Activation Window) cycles.
+
 Each generation of DDR increases the maximum size of the memory device and
 doubled the I/O bus frequency multiplier (and, consequently, the prefetch
 buffer size). Below is an overview of some common DDR modules:
@@ -83,32 +91,82 @@ namespace Simulator
 {
 
 /// Double-Data Rate Memory
+///
+/// Requests are accepted into a per-channel request queue and are
+/// serviced one DDR command (precharge, activate or burst) at a
+/// time. The order in which queued requests are serviced depends on
+/// the configured scheduler:
+///
+/// - FCFS: requests are serviced in arrival order;
+///
+/// - FRFCFS (first-ready, first-come first-served): among the
+///   requests whose next command can be issued this cycle, those that
+///   hit the open row of their bank are serviced before other
+///   requests, oldest first. A row is not closed while queued requests
+///   still hit it. Reads are preferred over writes, except when the
+///   number of queued writes reaches the high watermark; the writes
+///   are then drained until their number drops to the low watermark.
+///
+/// Every bank keeps its own open row and timing state, so that
+/// commands to different banks overlap, subject to the tRRD and tFAW
+/// constraints of each rank. Only the data bus is shared by all banks.
+///
+/// Reads may thus complete in a different order than they were
+/// issued; the client is notified of the address of every completed
+/// read.
 class DDRChannel : public Object
 {
 public:
     class ICallback
     {
     public:
-        virtual bool OnReadCompleted() = 0;
+        // Called when the read for the given address, as passed to
+        // Read(), has completed.
+        virtual bool OnReadCompleted(MemAddr address) = 0;
         virtual ~ICallback() {}
     };
 
 private:
     typedef std::set<MemAddr> TraceMap;
 
+    enum SchedulerType
+    {
+        SCHED_FCFS,     ///< Service requests in arrival order
+        SCHED_FRFCFS,   ///< Service row hits first, then oldest first
+    };
+
     // {% from "sim/macros.p.h" import gen_struct %}
     // {% call gen_struct() %}
     ((name Request)
      (state
       (MemAddr   address)   ///< We want something with this address
       (MemSize   size)      ///< With this size
-      (MemData   data)      ///< With this data
       (unsigned  offset)    ///< Current offset that we're handling
       (bool      write)     ///< A write or read
       (CycleNo   done)      ///< When this request is done
          ))
     // {% endcall %}
 
+    // {% call gen_struct() %}
+    ((name Rank)
+     (state
+      (CycleNo   next_activate)         ///< Minimum time for next Activate (tRRD, tFAW)
+      (array     activations CycleNo 4) ///< Times of the last Activates, oldest first
+      (unsigned  nactivations)          ///< Number of valid entries in activations
+         ))
+    // {% endcall %}
+
+    class Bank;
+
+    /// The DDR command that a request needs next
+    enum Command
+    {
+        CMD_PRECHARGE,  ///< Close the open row of the bank
+        CMD_ACTIVATE,   ///< Open the request's row
+        CMD_READ,       ///< Read a burst from the open row
+        CMD_WRITE,      ///< Write a burst to the open row
+    };
+
     class DDRConfig : public Object {
     public:
         unsigned int m_nBurstLength;    ///< Size of a single burst
@@ -121,6 +179,8 @@ private:
         unsigned int m_tCCD;    ///< CAS to CAS Delay (time between read commands)
         unsigned int m_tCWL;    ///< CAS Write Latency (time for a write command)
         unsigned int m_tRAS;    ///< Row Active Time (min time after row open before row close)
+        unsigned int m_tRRD;    ///< Row to Row Delay (min time between row opens in a rank)
+        unsigned int m_tFAW;    ///< Four Activation Window (max four row opens in a rank)
 
         // Address configuration
         unsigned int m_nDevicesPerRank; ///< Number of devices per rank
@@ -141,13 +201,19 @@ private:
 
     // Runtime parameters
     DDRConfig                  m_ddrconfig;      ///< DDR virtual chip parameters
-    std::vector<unsigned long> m_currentRow;     ///< Currently selected row, for each rank
+    SchedulerType              m_scheduler;      ///< Command scheduling policy
+    size_t                     m_queueSize;      ///< Maximum number of queued requests
+    size_t                     m_writeHigh;      ///< Number of queued writes that starts a write drain
+    size_t                     m_writeLow;       ///< Number of queued writes that ends a write drain
+    std::vector<Bank*>         m_banks;          ///< Bank state, indexed by rank * banks + bank
+    std::vector<Rank>          m_ranks;          ///< Rank state
     ICallback*                 m_callback;       ///< The callback to notify for completion
-    DefineStateVariable(Request, request);       ///< The current request
+    Buffer<Request>            m_incoming;       ///< Requests from the client
+    std::vector<Request>       m_queue;          ///< Queued requests, in arrival order
     Buffer<Request>            m_pipeline;       ///< Pipelined reads
-    Flag                       m_busy;           ///< Trigger for process
-    DefineStateVariable(CycleNo, next_command);  ///< Minimum time for next command
-    DefineStateVariable(CycleNo, next_precharge);///< Minimum time for next Row Precharge
+    Flag                       m_busy;           ///< Set when m_queue is not empty
+    DefineStateVariable(bool, draining);         ///< Writes are being drained
+    DefineStateVariable(CycleNo, next_column);   ///< Minimum time for next Read or Write (data bus)
     TraceMap                   m_traces;         ///< Active traces
 
     // Processes
@@ -157,6 +223,11 @@ private:
     // Statistics
     DefineSampleVariable(CycleNo, busyCycles);
 
+    void    DecodeAddress(const Request& req, unsigned& array, unsigned& row, unsigned& offset) const;
+    Command GetCommand(const Request& req, CycleNo now, bool& ready) const;
+    bool    HasRowHits(const Request& req, bool write) const;
+    size_t  SelectRequest(CycleNo now, bool& draining) const;
+
     Result DoRequest();
     Result DoPipeline();
 
@@ -27,7 +27,7 @@ class DDRMemory::Interface : public Object, public DDRChannel::ICallback
     Buffer<Request>     m_requests;  //< incoming from system, outgoing to memory
     Buffer<Request>     m_responses; //< incoming from memory, outgoing to system
 
-    std::queue<Request> m_activeRequests; //< Requests currently active in DDR
+    std::deque<Request> m_activeRequests; //< Requests currently active in DDR, in issue order
 
     // Processes
     Process             p_Requests;
@@ -43,11 +43,17 @@ class DDRMemory::Interface : public Object, public DDRChannel::ICallback
 public:
 
     // IMemory
-    bool OnReadCompleted()
+    bool OnReadCompleted(MemAddr address)
     {
-        assert(!m_activeRequests.empty());
+        // The DDR channel may reorder reads; find the oldest one for this address
+        auto p = m_activeRequests.begin();
+        while (p != m_activeRequests.end() && p->address != address)
+        {
+            ++p;
+        }
+        assert(p != m_activeRequests.end());
 
-        Request& request = m_activeRequests.front();
+        Request& request = *p;
 
         COMMIT {
             m_memory.Read(request.address, request.data.data, m_lineSize);
@@ -60,7 +66,7 @@ public:
         }
 
         COMMIT {
-            m_activeRequests.pop();
+            m_activeRequests.erase(p);
         }
 
         return true;
@@ -102,7 +108,7 @@ public:
 
             COMMIT{
                 ++m_nreads;
-                m_activeRequests.push(req);
+                m_activeRequests.push_back(req);
             }
         }
         else
@@ -117,7 +123,7 @@ public:
             }
 
             COMMIT {
-                m_memory.Write(req.address, req.data.data, req.data.mask, m_lineSize);
+                m_memory.WriteLine(req.address, req.data.data, req.data.mask, m_lineSize);
 
                 ++m_nwrites;
             }
@@ -168,7 +174,7 @@ public:
             out << hex << setfill('0');
             for (size_t x = 0; x < lineSize; ++x)
             {
-                if (request.data.mask[x])
+                if (line::test(request.data.mask, x))
                     out << " " << setw(2) << (unsigned)(unsigned char)request.data.data[x];
                 else
                     out << " --";
@@ -242,6 +248,8 @@ public:
           InitSampleVariable(nwrites, SVC_CUMULATIVE)
     {
 
+        RegisterStateObject(m_activeRequests, "active");
+
         RegisterModelObject(*this, "extif");
         RegisterModelProperty(*this, "freq", (uint32_t)clock.GetFrequency());
 
@@ -264,6 +272,11 @@ public:
 
 MCID DDRMemory::RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool /*ignored*/)
 {
+    // The client's process calls into the memory, and the memory's
+    // processes call back into the client.
+    GetKernel()->DeclareAccess(process, GetName());
+    GetKernel()->DeclareAccess(GetName(), process.GetName());
+
 #ifndef NDEBUG
     for (size_t i = 0; i < m_clients.size(); ++i) {
         assert(m_clients[i].callback != &callback);
@@ -339,7 +352,7 @@ bool DDRMemory::Write(MCID id, MemAddr address, const MemData& data, WClientID w
     request.write     = true;
     COMMIT{
     std::copy(data.data, data.data + m_lineSize, request.data.data);
-    std::copy(data.mask, data.mask + m_lineSize, request.data.mask);
+    request.data.mask = data.mask;
     }
 
     // Broadcast the snoop data
@@ -9,7 +9,7 @@
 #include <arch/VirtualMemory.h>
 #include <sim/inspect.h>
 
-#include <queue>
+#include <deque>
 #include <set>
 
 class Config;
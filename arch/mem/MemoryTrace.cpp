@@ -0,0 +1,238 @@
+#include "MemoryTrace.h"
+#include <sim/except.h>
+
+#include <cstring>
+
+using namespace std;
+
+namespace Simulator
+{
+
+static const char     TraceMagic[4] = { 'M', 'G', 'M', 'T' };
+static const unsigned TraceVersion  = 1;
+
+static const uint64_t FullMask = (MAX_MEMORY_OPERATION_SIZE == 64)
+    ? ~(uint64_t)0
+    : ((uint64_t)1 << (MAX_MEMORY_OPERATION_SIZE % 64)) - 1;
+
+//
+// MemoryTraceRecorder
+//
+MemoryTraceRecorder::MemoryTraceRecorder(const string& name, Object& parent, IMemory& memory, const string& filename)
+    : Object(name, parent),
+      m_memory(memory),
+      m_file(filename.c_str(), ios::out | ios::binary | ios::trunc),
+      m_timebase(false),
+      m_lastCycle(0),
+      m_lastAddress(0),
+      InitSampleVariable(nreads, SVC_CUMULATIVE),
+      InitSampleVariable(nwrites, SVC_CUMULATIVE)
+{
+    if (!m_file)
+    {
+        throw exceptf<InvalidArgumentException>(*this, "Unable to open memory trace file: %s", filename.c_str());
+    }
+    m_file.write(TraceMagic, sizeof TraceMagic);
+    PutVarint(TraceVersion);
+}
+
+void MemoryTraceRecorder::PutVarint(uint64_t value)
+{
+    char   buf[10];
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        buf[n++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (char)value;
+    m_file.write(buf, n);
+}
+
+void MemoryTraceRecorder::PutRequest(MemoryTraceRecord::Kind kind, MCID id, MemAddr address)
+{
+    const Kernel& kernel = *GetKernel();
+    if (!m_timebase)
+    {
+        // The master frequency is only known once all clocks have
+        // been created, so it is written with the first request.
+        PutVarint(MemoryTraceRecord::TIMEBASE);
+        PutVarint(kernel.GetMasterFrequency());
+        m_timebase = true;
+    }
+
+    const CycleNo cycle = kernel.GetCycleNo();
+    const int64_t delta = (int64_t)(address - m_lastAddress);
+    PutVarint(((uint64_t)id << 2) | kind);
+    PutVarint(cycle - m_lastCycle);
+    PutVarint(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    m_lastCycle   = cycle;
+    m_lastAddress = address;
+}
+
+MCID MemoryTraceRecorder::RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool grouped)
+{
+    // Requests are recorded from the clients' processes, into a
+    // single file and against the previous request. Declaring the
+    // access orders the clients' processes with the parallel kernel,
+    // which keeps the records in the order of the serial kernel.
+    GetKernel()->DeclareAccess(process, GetName());
+
+    MCID id = m_memory.RegisterClient(callback, process, traces, storages, grouped);
+    PutVarint(((uint64_t)id << 2) | MemoryTraceRecord::CLIENT);
+    PutVarint(grouped ? 1 : 0);
+    return id;
+}
+
+void MemoryTraceRecorder::UnregisterClient(MCID id)
+{
+    m_memory.UnregisterClient(id);
+}
+
+bool MemoryTraceRecorder::Read(MCID id, MemAddr address)
+{
+    if (!m_memory.Read(id, address))
+    {
+        return false;
+    }
+
+    COMMIT
+    {
+        PutRequest(MemoryTraceRecord::READ, id, address);
+        ++m_nreads;
+    }
+    return true;
+}
+
+bool MemoryTraceRecorder::Write(MCID id, MemAddr address, const MemData& data, WClientID wid)
+{
+    if (!m_memory.Write(id, address, data, wid))
+    {
+        return false;
+    }
+
+    COMMIT
+    {
+        const uint64_t mask = data.mask;
+        PutRequest(MemoryTraceRecord::WRITE, id, address);
+        PutVarint(mask == FullMask ? 0 : mask + 1);
+        ++m_nwrites;
+    }
+    return true;
+}
+
+void MemoryTraceRecorder::OnFunctionalRead(MemAddr address, void* data, MemSize size) const
+{
+    m_memory.OnFunctionalRead(address, data, size);
+}
+
+void MemoryTraceRecorder::OnFunctionalWrite(MemAddr address, const void* data, MemSize size)
+{
+    m_memory.OnFunctionalWrite(address, data, size);
+}
+
+void MemoryTraceRecorder::GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites,
+                                              uint64_t& nread_bytes, uint64_t& nwrite_bytes,
+                                              uint64_t& nreads_ext, uint64_t& nwrites_ext) const
+{
+    m_memory.GetMemoryStatistics(nreads, nwrites, nread_bytes, nwrite_bytes, nreads_ext, nwrites_ext);
+}
+
+//
+// MemoryTraceReader
+//
+MemoryTraceReader::MemoryTraceReader(const string& filename)
+    : m_file(filename.c_str(), ios::in | ios::binary),
+      m_filename(filename),
+      m_frequency(0),
+      m_lastCycle(0),
+      m_lastAddress(0)
+{
+    if (!m_file)
+    {
+        throw FileNotFoundException(filename);
+    }
+
+    char     magic[sizeof TraceMagic];
+    uint64_t version;
+    if (!m_file.read(magic, sizeof magic) || memcmp(magic, TraceMagic, sizeof magic) != 0 ||
+        !GetVarint(version))
+    {
+        throw IOException("Not a memory trace: " + filename);
+    }
+
+    if (version != TraceVersion)
+    {
+        throw IOException("Unsupported memory trace version " + to_string(version) + ": " + filename);
+    }
+}
+
+bool MemoryTraceReader::GetVarint(uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        int c = m_file.get();
+        if (c == EOF)
+        {
+            return false;
+        }
+        value |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    throw IOException("Malformed memory trace: " + m_filename);
+}
+
+bool MemoryTraceReader::Next(MemoryTraceRecord& rec)
+{
+    uint64_t head, value;
+    while (GetVarint(head))
+    {
+        rec.kind    = (MemoryTraceRecord::Kind)(head & 3);
+        rec.client  = (MCID)(head >> 2);
+        rec.cycle   = m_lastCycle;
+        rec.address = m_lastAddress;
+        rec.mask    = FullMask;
+        rec.grouped = false;
+
+        switch (rec.kind)
+        {
+        case MemoryTraceRecord::TIMEBASE:
+            if (!GetVarint(value))
+                break;
+            m_frequency = (Clock::Frequency)value;
+            continue;
+
+        case MemoryTraceRecord::CLIENT:
+            if (!GetVarint(value))
+                break;
+            rec.grouped = (value != 0);
+            return true;
+
+        case MemoryTraceRecord::READ:
+        case MemoryTraceRecord::WRITE:
+        {
+            uint64_t delta;
+            if (!GetVarint(value) || !GetVarint(delta))
+                break;
+            rec.cycle   = m_lastCycle   += value;
+            rec.address = m_lastAddress += (MemAddr)((delta >> 1) ^ -(delta & 1));
+            if (rec.kind == MemoryTraceRecord::WRITE)
+            {
+                if (!GetVarint(value))
+                    break;
+                if (value != 0)
+                    rec.mask = value - 1;
+            }
+            return true;
+        }
+        }
+        throw IOException("Truncated memory trace: " + m_filename);
+    }
+    return false;
+}
+
+}
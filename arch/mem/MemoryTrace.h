@@ -0,0 +1,108 @@
+// -*- c++ -*-
+#ifndef MEMORYTRACE_H
+#define MEMORYTRACE_H
+
+#include <arch/Memory.h>
+#include <sim/kernel.h>
+
+#include <fstream>
+#include <string>
+
+namespace Simulator
+{
+    /*
+      Memory request traces.
+
+      A trace is a compact binary log of the requests issued to an
+      IMemory by its clients. It starts with a header (magic and
+      version) followed by records. Each record starts with a varint
+      holding the record kind in the lower two bits and the client ID
+      (MCID) above that:
+
+      - CLIENT: registration of a client; followed by a varint holding
+        the 'grouped' flag of IMemory::RegisterClient.
+      - TIMEBASE: followed by a varint holding the master frequency (MHz)
+        of the cycle counts in the following records.
+      - READ, WRITE: followed by a varint holding the master cycle
+        delta with the previous request and a zigzag-encoded varint
+        holding the address delta with the previous request. Writes are
+        then followed by their byte mask (bit i set for byte i) plus one,
+        or 0 for a full mask. The written data is not recorded.
+    */
+
+    struct MemoryTraceRecord
+    {
+        enum Kind
+        {
+            READ,
+            WRITE,
+            CLIENT,
+            TIMEBASE
+        };
+
+        Kind     kind;
+        MCID     client;
+        CycleNo  cycle;     ///< Master cycle, for READ and WRITE
+        MemAddr  address;   ///< For READ and WRITE
+        uint64_t mask;      ///< Byte mask, for WRITE
+        bool     grouped;   ///< For CLIENT
+    };
+
+    // Records the requests to a memory, sitting between the memory
+    // and its clients.
+    class MemoryTraceRecorder : public Object, public IMemory
+    {
+        IMemory&      m_memory;
+        std::ofstream m_file;
+        bool          m_timebase;       ///< Has the time base been written?
+        CycleNo       m_lastCycle;
+        MemAddr       m_lastAddress;
+
+        // Statistics
+        DefineSampleVariable(uint64_t, nreads);
+        DefineSampleVariable(uint64_t, nwrites);
+
+        void PutVarint(uint64_t value);
+        void PutRequest(MemoryTraceRecord::Kind kind, MCID id, MemAddr address);
+
+    public:
+        MemoryTraceRecorder(const std::string& name, Object& parent, IMemory& memory, const std::string& filename);
+        MemoryTraceRecorder(const MemoryTraceRecorder&) = delete;
+        MemoryTraceRecorder& operator=(const MemoryTraceRecorder&) = delete;
+
+        // IMemory
+        MCID RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool grouped) override;
+        void UnregisterClient(MCID id) override;
+        bool Read (MCID id, MemAddr address) override;
+        bool Write(MCID id, MemAddr address, const MemData& data, WClientID wid) override;
+
+        void OnFunctionalRead (MemAddr address, void* data, MemSize size) const override;
+        void OnFunctionalWrite(MemAddr address, const void* data, MemSize size) override;
+
+        void GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites,
+                                 uint64_t& nread_bytes, uint64_t& nwrite_bytes,
+                                 uint64_t& nreads_ext, uint64_t& nwrites_ext) const override;
+    };
+
+    // Reads back a trace written by MemoryTraceRecorder.
+    class MemoryTraceReader
+    {
+        std::ifstream    m_file;
+        std::string      m_filename;
+        Clock::Frequency m_frequency;   ///< Master frequency of the cycle counts, 0 if not known yet
+        CycleNo          m_lastCycle;
+        MemAddr          m_lastAddress;
+
+        bool GetVarint(uint64_t& value);
+
+    public:
+        MemoryTraceReader(const std::string& filename);
+
+        // Reads the next record into rec; returns false at the end of the trace.
+        bool Next(MemoryTraceRecord& rec);
+
+        Clock::Frequency GetFrequency() const { return m_frequency; }
+    };
+}
+
+#endif
@@ -11,6 +11,11 @@ namespace Simulator
 
 MCID SerialMemory::RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool /*ignored*/)
 {
+    // The client's process calls into the memory, and the memory's
+    // processes call back into the client.
+    GetKernel()->DeclareAccess(process, GetName());
+    GetKernel()->DeclareAccess(GetName(), process.GetName());
+
     assert(std::find(m_clients.begin(), m_clients.end(), &callback) == m_clients.end());
     m_clients.push_back(&callback);
 
@@ -75,7 +80,7 @@ bool SerialMemory::Write(MCID id, MemAddr address, const MemData& data, WClientI
     request.write     = true;
     COMMIT{
     std::copy(data.data, data.data + m_lineSize, request.data.data);
-    std::copy(data.mask, data.mask + m_lineSize, request.data.mask);
+    request.data.mask = data.mask;
     }
 
     if (!m_requests.Push(std::move(request)))
@@ -110,7 +115,7 @@ Result SerialMemory::DoRequests()
             // The current request has completed
             if (request.write) {
 
-                VirtualMemory::Write(request.address, request.data.data, request.data.mask, m_lineSize);
+                VirtualMemory::WriteLine(request.address, request.data.data, request.data.mask, m_lineSize);
 
                 if (!m_clients[request.client]->OnMemoryWriteCompleted(request.wid))
                 {
@@ -232,7 +237,7 @@ void SerialMemory::Cmd_Read(ostream& out, const vector<string>& arguments) const
             for (size_t i = 0; i < m_lineSize; ++i)
             {
                 out << ' ';
-                if (p->data.mask[i])
+                if (line::test(p->data.mask, i))
                     out << setw(2) << (unsigned)(unsigned char)p->data.data[i];
                 else
                     out << "--";
@@ -92,6 +92,8 @@ public:
     using VirtualMemory::Write;
     bool Read (MCID id, MemAddr address) override;
     bool Write(MCID id, MemAddr address, const MemData& data, WClientID wid) override;
+    void OnFunctionalRead (MemAddr address, void* data, MemSize size) const override;
+    void OnFunctionalWrite(MemAddr address, const void* data, MemSize size) override;
 
     void GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites,
                              uint64_t& nread_bytes, uint64_t& nwrite_bytes,
@@ -97,7 +97,7 @@ bool CDMA::Cache::Write(MCID id, MemAddr address, const MemData& data, WClientID
     req.wid     = wid;
     COMMIT{
     std::copy(data.data, data.data + m_lineSize, req.mdata.data);
-    std::copy(data.mask, data.mask + m_lineSize, req.mdata.mask);
+    req.mdata.mask = data.mask;
     }
 
     // Client should have been registered
@@ -136,10 +136,10 @@ CDMA::Cache::Line* CDMA::Cache::FindLine(MemAddr address)
     const size_t  set  = setindex * m_assoc;
 
     // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
+    for (CacheArray::WayMask m = m_array.Match(setindex, tag); m != 0; m &= m - 1)
     {
-        Line& line = m_lines[set + i];
-        if (line.state != LINE_EMPTY && line.tag == tag)
+        Line& line = m_lines[set + CacheArray::LowestWay(m)];
+        if (line.state != LINE_EMPTY)
         {
             // The wanted line was in the cache
             return &line;
@@ -148,6 +148,34 @@ CDMA::Cache::Line* CDMA::Cache::FindLine(MemAddr address)
     return NULL;
 }
 
+void CDMA::Cache::OnFunctionalRead(MemAddr address, char* data, size_t size)
+{
+    const Line* line = FindLine(address);
+    if (line != NULL)
+    {
+        // Merge the valid bytes of our copy into the data
+        const size_t offset = (size_t)(address % m_lineSize);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (line::test(line->valid, offset + i))
+            {
+                data[i] = line->data[offset + i];
+            }
+        }
+    }
+}
+
+void CDMA::Cache::OnFunctionalWrite(MemAddr address, const char* data, size_t size)
+{
+    Line* line = FindLine(address);
+    if (line != NULL)
+    {
+        const size_t offset = (size_t)(address % m_lineSize);
+        std::copy(data, data + size, line->data + offset);
+        line->valid |= line::range(offset, size);
+    }
+}
+
 // Attempts to allocate a line for the specified address.
 // If empty_only is true, only empty lines will be considered.
 CDMA::Cache::Line* CDMA::Cache::AllocateLine(MemAddr address, bool empty_only, MemAddr* ptag)
@@ -158,37 +186,45 @@ CDMA::Cache::Line* CDMA::Cache::AllocateLine(MemAddr address, bool empty_only, M
     const size_t  set  = setindex * m_assoc;
 
     // Find the line
-    Line* empty   = NULL;
-    Line* replace = NULL;
+    CacheArray::WayMask empty = 0, replace = 0;
     for (size_t i = 0; i < m_assoc; ++i)
     {
-        Line& line = m_lines[set + i];
+        const Line& line = m_lines[set + i];
         if (line.state == LINE_EMPTY)
         {
             // Empty, unused line, remember this one
             DeadlockWrite("New line, tag %#016llx: allocating empty line %zu from set %zu", (unsigned long long)tag, i, setindex);
-            empty = &line;
+            empty |= (CacheArray::WayMask)1 << i;
         }
         else if (!empty_only)
         {
-            // We're also considering non-empty lines; use LRU
-            assert(line.tag != tag);
+            // We're also considering non-empty lines
+            assert(m_array.Tag(set + i) != tag);
             DeadlockWrite("New line, tag %#016llx: considering busy line %zu from set %zu, tag %#016llx, state %u, updating %u, access %llu",
                           (unsigned long long)tag,
                           i, setindex,
-                          (unsigned long long)line.tag, (unsigned)line.state, (unsigned)line.updating, (unsigned long long)line.access);
-            if (line.state != LINE_LOADING && line.updating == 0 && (replace == NULL || line.access < replace->access))
+                          (unsigned long long)m_array.Tag(set + i), (unsigned)line.state, (unsigned)line.updating,
+                          (unsigned long long)m_array.LastAccess(set + i));
+            if (line.state != LINE_LOADING && line.updating == 0)
             {
-                // The line is available to be replaced and has a lower LRU rating,
-                // remember it for replacing
-                replace = &line;
+                // The line is available to be replaced
+                replace |= (CacheArray::WayMask)1 << i;
             }
         }
     }
 
-    // The line could not be found, allocate the empty line or replace an existing line
+    // The line could not be found, allocate the last empty line or let
+    // the replacement policy choose among the replaceable lines
     if (ptag) *ptag = tag;
-    return (empty != NULL) ? empty : replace;
+    if (empty != 0)
+    {
+        return &m_lines[set + CacheArray::HighestWay(empty)];
+    }
+    if (replace != 0)
+    {
+        return &m_lines[set + m_array.Victim(setindex, replace)];
+    }
+    return NULL;
 }
 
 bool CDMA::Cache::EvictLine(Line* line, const Request& req)
@@ -198,7 +234,7 @@ bool CDMA::Cache::EvictLine(Line* line, const Request& req)
     assert(line->updating == 0);
 
     size_t setindex = (line - &m_lines[0]) / m_assoc;
-    MemAddr address = m_selector->Unmap(line->tag, setindex) * m_lineSize;
+    MemAddr address = m_selector->Unmap(m_array.Tag(line - &m_lines[0]), setindex) * m_lineSize;
 
     TraceWrite(address, "Evicting with %u tokens due to miss for address %#016llx", line->tokens, (unsigned long long)req.address);
 
@@ -295,7 +331,7 @@ bool CDMA::Cache::OnMessageReceived(Message* msg)
                     line->tokens -= msg->tokens;
 
                     // Also update last access time.
-                    line->access = GetKernel()->GetCycleNo();
+                    m_array.Touch(line - &m_lines[0], GetKernel()->GetCycleNo());
                 }
             }
             else if (msg->type == Message::REQUEST)
@@ -346,7 +382,7 @@ bool CDMA::Cache::OnMessageReceived(Message* msg)
 
             // Store the data, masked by the already-valid bitmask
             line::blitnot(line->data, msg->data.data, line->valid, m_lineSize);
-            line::setifnot(line->valid, true, line->valid, m_lineSize);
+            line->valid = line::full(m_lineSize);
 
             line->state  = LINE_FULL;
             line->tokens = msg->tokens;
@@ -427,12 +463,12 @@ bool CDMA::Cache::OnMessageReceived(Message* msg)
                 COMMIT
                 {
                     line->state    = LINE_FULL;
-                    line->tag      = tag;
                     line->tokens   = msg->tokens;
                     line->dirty    = msg->dirty;
                     line->updating = 0;
-                    line->access   = GetKernel()->GetCycleNo();
-                    std::fill(line->valid, line->valid + m_lineSize, true);
+                    m_array.Tag(line - &m_lines[0]) = tag;
+                    m_array.Touch(line - &m_lines[0], GetKernel()->GetCycleNo());
+                    line->valid = line::full(m_lineSize);
                     std::copy(msg->data.data, msg->data.data + m_lineSize, line->data);
 
                     delete msg;
@@ -486,7 +522,7 @@ bool CDMA::Cache::OnMessageReceived(Message* msg)
                 COMMIT
                 {
                     line::blit(line->data, msg->data.data, msg->data.mask, m_lineSize);
-                    line::setif(line->valid, true, msg->data.mask, m_lineSize);
+                    line->valid |= msg->data.mask & line::full(m_lineSize);
 
                     // Statistics
                     ++m_numNetworkWHits;
@@ -576,7 +612,7 @@ Result CDMA::Cache::OnWriteRequest(const Request& req)
         {
             // We're overwriting another line, evict the old line
             TraceWrite(req.address, "Processing Bus Write Request: Miss; Evicting line with tag %#016llx",
-                       (unsigned long long)line->tag);
+                       (unsigned long long)m_array.Tag(line - &m_lines[0]));
 
             if (!EvictLine(line, req))
             {
@@ -595,11 +631,11 @@ Result CDMA::Cache::OnWriteRequest(const Request& req)
         COMMIT
         {
             line->state    = LINE_LOADING;
-            line->tag      = tag;
+            m_array.Tag(line - &m_lines[0]) = tag;
             line->tokens   = 0;
             line->dirty    = false;
             line->updating = 0;
-            std::fill(line->valid, line->valid + m_lineSize, false);
+            line->valid = 0;
         }
 
         // Send a request out for the cache-line
@@ -662,7 +698,7 @@ Result CDMA::Cache::OnWriteRequest(const Request& req)
             msg->client    = req.client;
             msg->wid       = req.wid;
             std::copy(req.mdata.data, req.mdata.data + m_lineSize, msg->data.data);
-            std::copy(req.mdata.mask, req.mdata.mask + m_lineSize, msg->data.mask);
+            msg->data.mask = req.mdata.mask;
 
             // Lock the line to prevent eviction
             line->updating++;
@@ -689,13 +725,13 @@ Result CDMA::Cache::OnWriteRequest(const Request& req)
     COMMIT
     {
         line::blit(line->data, req.mdata.data, req.mdata.mask, m_lineSize);
-        line::setif(line->valid, true, req.mdata.mask, m_lineSize);
+        line->valid |= req.mdata.mask & line::full(m_lineSize);
 
         // The line is now dirty
         line->dirty = true;
 
         // Also update last access time.
-        line->access = GetKernel()->GetCycleNo();
+        m_array.Touch(line - &m_lines[0], GetKernel()->GetCycleNo());
     }
     return SUCCESS;
 }
@@ -730,7 +766,7 @@ Result CDMA::Cache::OnReadRequest(const Request& req)
         {
             // We're overwriting another line, evict the old line
             TraceWrite(req.address, "Processing Bus Read Request: Miss; Evicting line with tag %#016llx",
-                       (unsigned long long)line->tag);
+                       (unsigned long long)m_array.Tag(line - &m_lines[0]));
 
             if (!EvictLine(line, req))
             {
@@ -749,12 +785,12 @@ Result CDMA::Cache::OnReadRequest(const Request& req)
         COMMIT
         {
             line->state    = LINE_LOADING;
-            line->tag      = tag;
             line->tokens   = 0;
             line->dirty    = false;
             line->updating = 0;
-            line->access   = GetKernel()->GetCycleNo();
-            std::fill(line->valid, line->valid + m_lineSize, false);
+            m_array.Tag(line - &m_lines[0]) = tag;
+            m_array.Touch(line - &m_lines[0], GetKernel()->GetCycleNo());
+            line->valid = 0;
         }
 
         // Send a request out
@@ -794,7 +830,7 @@ Result CDMA::Cache::OnReadRequest(const Request& req)
             std::copy(line->data, line->data + m_lineSize, data);
 
             // Update LRU information
-            line->access = GetKernel()->GetCycleNo();
+            m_array.Touch(line - &m_lines[0], GetKernel()->GetCycleNo());
 
             ++m_numRFullHits;
         }
@@ -871,6 +907,7 @@ CDMA::Cache::Cache(const std::string& name, CDMA& parent, Clock& clock, NodeID i
     m_selector (IBankSelector::makeSelector(*this,
                                             GetConfOpt("BankSelector", string, "XORFOLD"),
                                             m_sets)),
+    m_array    (*this, m_sets, m_assoc, GetConfOpt("ReplacementPolicy", string, "LRU")),
     m_clients  (),
     m_storages (),
     p_lines    (clock, GetName() + ".p_lines"),
@@ -918,6 +955,7 @@ CDMA::Cache::Cache(const std::string& name, CDMA& parent, Clock& clock, NodeID i
 {
 
     RegisterStateVariable(m_data, "data");
+    m_array.RegisterState(*this);
     // Create the cache lines
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
@@ -926,12 +964,10 @@ CDMA::Cache::Cache(const std::string& name, CDMA& parent, Clock& clock, NodeID i
         line.data  = &m_data[i * m_lineSize];
         auto ln = "line" + to_string(i);
         RegisterStateVariable(line.state, ln + ".state");
-        RegisterStateVariable(line.tag, ln + ".tag");
-        RegisterStateVariable(line.access, ln + ".access");
         RegisterStateVariable(line.tokens, ln + ".tokens");
         RegisterStateVariable(line.dirty, ln + ".dirty");
         RegisterStateVariable(line.updating, ln + ".updating");
-        RegisterStateArray(line.valid, sizeof(line.valid)/sizeof(line.valid[0]), ln + ".valid");
+        RegisterStateVariable(line.valid, ln + ".valid");
     }
 
     m_requests.Sensitive(p_Requests);
@@ -1212,7 +1248,7 @@ void CDMA::Cache::Cmd_Read(std::ostream& out, const std::vector<std::string>& ar
         {
             const size_t set = i / m_assoc;
             const Line& line = m_lines[i];
-            MemAddr lineaddr = m_selector->Unmap(line.tag, set) * m_lineSize;
+            MemAddr lineaddr = m_selector->Unmap(m_array.Tag(i), set) * m_lineSize;
             if (specific && lineaddr != seladdr)
                 continue;
 
@@ -1238,7 +1274,7 @@ void CDMA::Cache::Cmd_Read(std::ostream& out, const std::vector<std::string>& ar
                         if ((fmt == fmt_bytes) || ((fmt == fmt_words) && (x % sizeof(Integer) == 0)))
                             out << " ";
 
-                        if (line.valid[x]) {
+                        if (line::test(line.valid, x)) {
                             char byte = line.data[x];
                             if (fmt == fmt_chars)
                                 out << (isprint(byte) ? byte : '.');
@@ -5,6 +5,7 @@
 #include <arch/mem/cdma/Node.h>
 #include <sim/inspect.h>
 #include <arch/BankSelector.h>
+#include <arch/CacheArray.h>
 
 #include <queue>
 #include <set>
@@ -24,16 +25,15 @@ public:
         LINE_FULL,      ///< Allocated and data present.
     };
 
+    /// A cache line; its tag and LRU state are in m_array.
     struct Line
     {
         LineState    state;     ///< State of the line
-        MemAddr      tag;       ///< Tag of the line
         char*        data;      ///< Data of the line
-        CycleNo      access;    ///< Last access time (for LRU replacement)
         unsigned int tokens;    ///< Number of tokens in this line
         bool         dirty;     ///< Dirty: line has been written to
         unsigned int updating;  ///< Number of REQUEST_UPDATEs pending on this line
-        bool         valid[MAX_MEMORY_OPERATION_SIZE]; ///< Validity bitmask
+        LineMask     valid;     ///< Validity bitmask
     };
 
 private:
@@ -54,6 +54,7 @@ private:
     size_t                        m_assoc;
     size_t                        m_sets;
     IBankSelector*                m_selector;
+    CacheArray                    m_array;
     std::vector<IMemoryCallback*> m_clients;
     StorageTraceSet               m_storages;
     ArbitratedService<>           p_lines;
@@ -146,6 +147,11 @@ public:
     void UnregisterClient(MCID id);
     bool Read (MCID id, MemAddr address);
     bool Write(MCID id, MemAddr address, const MemData& data, WClientID wid);
+
+    // Functional access to the line copy of the data, if any; the
+    // range must lie within a single line. See IMemory::OnFunctionalRead.
+    void OnFunctionalRead (MemAddr address, char* data, size_t size);
+    void OnFunctionalWrite(MemAddr address, const char* data, size_t size);
 };
 
 }
@@ -238,6 +238,7 @@ CDMA::Directory::Directory(const std::string& name, CDMA& parent, Clock& clock)
     InitProcess(p_InBottom, DoInBottom),
     InitProcess(p_InTop, DoInTop)
 {
+    RegisterStateObject(m_dir, "dir");
 
     m_bottom.m_incoming.Sensitive(p_InBottom);
     m_top.m_incoming.Sensitive(p_InTop);
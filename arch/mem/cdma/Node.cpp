@@ -10,6 +10,8 @@ using namespace std;
 namespace Simulator
 {
 
+static const TraceEventType EV_SEND("cdma.send", {"address", "type", "sender"});
+
 // Memory management data
 /*static*/ unsigned long                   CDMA::Node::g_References   = 0;
 /*static*/ CDMA::Node::Message*            CDMA::Node::g_FreeMessages = NULL;
@@ -138,6 +140,7 @@ Result CDMA::Node::DoForward()
         DeadlockWrite("Unable to send request to next node (%s)", m_next->GetName().c_str());
         return FAILED;
     }
+    TraceEvent(EV_SEND, m_outgoing.Front()->address, m_outgoing.Front()->type, m_outgoing.Front()->sender);
     m_outgoing.Pop();
     return SUCCESS;
 }
@@ -39,11 +39,16 @@ CDMA::RootDirectory::Line* CDMA::RootDirectory::AllocateLine(MemAddr address)
     return line;
 }
 
-bool CDMA::RootDirectory::OnReadCompleted()
+bool CDMA::RootDirectory::OnReadCompleted(MemAddr address)
 {
-    assert (!m_active.empty());
-
-    Message* msg = m_active.front();
+    // The DDR channel may reorder reads; find the oldest one for this address
+    auto p = m_active.begin();
+    while (p != m_active.end() && ((*p)->address / m_lineSize) / m_numRoots * m_lineSize != address)
+    {
+        ++p;
+    }
+    assert(p != m_active.end());
+    Message* msg = *p;
     COMMIT
     {
         msg->type = Message::REQUEST_DATA_TOKEN;
@@ -51,7 +56,7 @@ bool CDMA::RootDirectory::OnReadCompleted()
 
         static_cast<VirtualMemory&>(m_parent).Read(msg->address, msg->data.data, m_lineSize);
 
-        m_active.pop();
+        m_active.erase(p);
     }
 
     if (!m_responses.Push(msg))
@@ -280,7 +285,7 @@ Result CDMA::RootDirectory::DoRequests()
 
             COMMIT{
                 ++m_nreads;
-                m_active.push(msg);
+                m_active.push_back(msg);
             }
 #else
             COMMIT
@@ -409,6 +414,9 @@ CDMA::RootDirectory::RootDirectory(const std::string& name, CDMA& parent, Clock&
 {
     assert(m_lineSize <= MAX_MEMORY_OPERATION_SIZE);
 
+    RegisterStateObject(m_dir, "dir");
+    RegisterStateObject(m_active, "active");
+
     RegisterModelObject(*this, "rootdir");
     RegisterModelProperty(*this, "freq", (uint32_t)clock.GetFrequency());
 
@@ -5,7 +5,7 @@
 #include "Directory.h"
 #include <arch/mem/DDR.h>
 
-#include <queue>
+#include <deque>
 #include <set>
 
 class Config;
@@ -31,6 +31,8 @@ public:
         LineState    state;    ///< State of the line
         unsigned int tokens;   ///< Full: tokens stored here by evictions
         NodeID       sender;   ///< Loading: ID of the cache that requested the loading line
+
+        SERIALIZE(a) { a & "rdl" & state & tokens & sender; }
     };
 
 private:
@@ -45,7 +47,7 @@ private:
     DDRChannel*       m_memory;    ///< DDR memory channel
     Buffer<Message*>  m_requests;  ///< Requests to memory
     Buffer<Message*>  m_responses; ///< Responses from memory
-    std::queue<Message*> m_active;  ///< Messages active in DDR
+    std::deque<Message*> m_active;  ///< Messages active in DDR, in issue order
 
     // Processes
     Process p_Incoming;
@@ -56,7 +58,7 @@ private:
     Line* FindLine(MemAddr address);
     Line* AllocateLine(MemAddr address);
     bool  OnMessageReceived(Message* msg);
-    bool  OnReadCompleted();
+    bool  OnReadCompleted(MemAddr address);
 
     // Processes
     Result DoIncoming();
@@ -13,6 +13,11 @@ namespace Simulator
 
 MCID ZLCDMA::RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, const StorageTraceSet& storages, bool grouped)
 {
+    // The client's process calls into the memory, and the memory's
+    // processes call back into the client.
+    GetKernel()->DeclareAccess(process, GetName());
+    GetKernel()->DeclareAccess(GetName(), process.GetName());
+
     MCID id = m_clientMap.size();
     m_clientMap.resize(id + 1);
 
@@ -205,6 +210,40 @@ ZLCDMA::~ZLCDMA()
     delete m_selector;
 }
 
+// The caches may hold data that is newer than the memory contents
+// (dirty lines), and keep copies that must be updated on a write.
+void ZLCDMA::OnFunctionalRead(MemAddr address, void* data, MemSize size) const
+{
+    char* p = static_cast<char*>(data);
+    while (size > 0)
+    {
+        size_t count = std::min((size_t)size, m_lineSize - (size_t)(address % m_lineSize));
+        for (auto c : m_caches)
+        {
+            c->OnFunctionalRead(address, p, count);
+        }
+        address += count;
+        p       += count;
+        size    -= count;
+    }
+}
+
+void ZLCDMA::OnFunctionalWrite(MemAddr address, const void* data, MemSize size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        size_t count = std::min((size_t)size, m_lineSize - (size_t)(address % m_lineSize));
+        for (auto c : m_caches)
+        {
+            c->OnFunctionalWrite(address, p, count);
+        }
+        address += count;
+        p       += count;
+        size    -= count;
+    }
+}
+
 void ZLCDMA::GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites, uint64_t& nread_bytes, uint64_t& nwrite_bytes, uint64_t& nreads_ext, uint64_t& nwrites_ext) const
 {
     nreads = m_nreads;
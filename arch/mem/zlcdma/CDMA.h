@@ -44,14 +44,6 @@ private:
     typedef size_t            CacheID;
     typedef std::pair<size_t, WClientID> WriteAck;
 
-    // Helper function for checking if a value is contained in a range
-    template<class InputIterator, class EqualityComparable>
-    static inline bool contains(InputIterator first, InputIterator last, const EqualityComparable& value)
-    {
-        return std::find(first, last, value) != last;
-    }
-
-
     Clock&                      m_clock;
     size_t                      m_numClientsPerCache;
     size_t                      m_numCachesPerDir;
@@ -99,6 +91,8 @@ public:
     using VirtualMemory::Write;
     bool Read (MCID id, MemAddr address) override;
     bool Write(MCID id, MemAddr address, const MemData& data, WClientID wid) override;
+    void OnFunctionalRead (MemAddr address, void* data, MemSize size) const override;
+    void OnFunctionalWrite(MemAddr address, const void* data, MemSize size) override;
 
     void GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites,
                              uint64_t& nread_bytes, uint64_t& nwrite_bytes,
@@ -93,7 +93,7 @@ bool ZLCDMA::Cache::Write(MCID id, MemAddr address, const MemData& data, WClient
     req.wid     = wid;
     COMMIT{
     std::copy(data.data, data.data + m_lineSize, req.mdata.data);
-    std::copy(data.mask, data.mask + m_lineSize, req.mdata.mask);
+    req.mdata.mask = data.mask;
     }
 
     // Client should have been registered
@@ -131,10 +131,10 @@ ZLCDMA::Cache::Line* ZLCDMA::Cache::FindLine(MemAddr address)
     const size_t  set  = setindex * m_assoc;
 
     // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
+    for (CacheArray::WayMask m = m_array.Match(setindex, tag); m != 0; m &= m - 1)
     {
-        Line& line = m_lines[set + i];
-        if (line.valid && line.tag == tag)
+        Line& line = m_lines[set + CacheArray::LowestWay(m)];
+        if (line.valid)
         {
             // The wanted line was in the cache
             return &line;
@@ -151,10 +151,10 @@ const ZLCDMA::Cache::Line* ZLCDMA::Cache::FindLine(MemAddr address) const
     const size_t  set  = setindex * m_assoc;
 
     // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
+    for (CacheArray::WayMask m = m_array.Match(setindex, tag); m != 0; m &= m - 1)
     {
-        const Line& line = m_lines[set + i];
-        if (line.valid && line.tag == tag)
+        const Line& line = m_lines[set + CacheArray::LowestWay(m)];
+        if (line.valid)
         {
             // The wanted line was in the cache
             return &line;
@@ -163,6 +163,34 @@ const ZLCDMA::Cache::Line* ZLCDMA::Cache::FindLine(MemAddr address) const
     return NULL;
 }
 
+void ZLCDMA::Cache::OnFunctionalRead(MemAddr address, char* data, size_t size)
+{
+    const Line* line = FindLine(address);
+    if (line != NULL)
+    {
+        // Merge the valid bytes of our copy into the data
+        const size_t offset = (size_t)(address % m_lineSize);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (line::test(line->bitmask, offset + i))
+            {
+                data[i] = line->data[offset + i];
+            }
+        }
+    }
+}
+
+void ZLCDMA::Cache::OnFunctionalWrite(MemAddr address, const char* data, size_t size)
+{
+    Line* line = FindLine(address);
+    if (line != NULL)
+    {
+        const size_t offset = (size_t)(address % m_lineSize);
+        std::copy(data, data + size, line->data + offset);
+        line->bitmask |= line::range(offset, size);
+    }
+}
+
 ZLCDMA::Cache::Line* ZLCDMA::Cache::GetEmptyLine(MemAddr address, MemAddr& tag)
 {
     size_t setindex;
@@ -184,8 +212,8 @@ ZLCDMA::Cache::Line* ZLCDMA::Cache::GetEmptyLine(MemAddr address, MemAddr& tag)
 // function for find replacement line
 ZLCDMA::Cache::Line* ZLCDMA::Cache::GetReplacementLine(MemAddr address, MemAddr& tag)
 {
-    Line *linelruw = NULL; // replacement line for write-back request
-    Line *linelrue = NULL; // replacement line for eviction request
+    CacheArray::WayMask linelruw = 0; // replacement lines for write-back request
+    CacheArray::WayMask linelrue = 0; // replacement lines for eviction request
 
     size_t setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
@@ -203,20 +231,18 @@ ZLCDMA::Cache::Line* ZLCDMA::Cache::GetReplacementLine(MemAddr address, MemAddr&
         if (!line.pending_read && !line.pending_write)
         {
             if (!line.dirty)
-            {
-                if (linelrue == NULL || line.time < linelrue->time)
-                    linelrue = &line;
-            }
+                linelrue |= (CacheArray::WayMask)1 << i;
             else
-            {
-                if (linelruw == NULL || line.time < linelruw->time)
-                    linelruw = &line;
-            }
+                linelruw |= (CacheArray::WayMask)1 << i;
         }
     }
 
     // Prefer to to evict non-dirty lines since they don't require writeback to off-chip memory.
-    return (linelrue != NULL) ? linelrue : linelruw;
+    if (linelrue != 0)
+        return &m_lines[set + m_array.Victim(setindex, linelrue)];
+    if (linelruw != 0)
+        return &m_lines[set + m_array.Victim(setindex, linelruw)];
+    return NULL;
 }
 
 Result ZLCDMA::Cache::OnMessageReceived(Message* msg)
@@ -274,7 +300,7 @@ bool ZLCDMA::Cache::ClearLine(Line* line)
     }
 
     size_t  set     = (line - &m_lines[0]) / m_assoc;
-    MemAddr address = m_selector.Unmap(line->tag, set) * m_lineSize;
+    MemAddr address = m_selector.Unmap(m_array.Tag(line - &m_lines[0]), set) * m_lineSize;
 
     for (std::vector<IMemoryCallback*>::const_iterator p = m_clients.begin(); p != m_clients.end(); ++p)
     {
@@ -296,7 +322,7 @@ bool ZLCDMA::Cache::EvictLine(Line* line, const Request& req)
     assert(line->valid);
 
     size_t  set     = (line - &m_lines[0]) / m_assoc;
-    MemAddr address = m_selector.Unmap(line->tag, set) * m_lineSize;
+    MemAddr address = m_selector.Unmap(m_array.Tag(line - &m_lines[0]), set) * m_lineSize;
 
     Message* msg = new Message();
     COMMIT
@@ -310,7 +336,7 @@ bool ZLCDMA::Cache::EvictLine(Line* line, const Request& req)
         msg->dirty     = line->dirty;
         msg->tokens    = line->tokens;
         std::copy(line->data,    line->data    + m_lineSize, msg->data);
-        std::copy(line->bitmask, line->bitmask + m_lineSize, msg->bitmask);
+        msg->bitmask = line->bitmask;
     }
 
     TraceWrite(address, "Evicting with %u tokens due to miss for 0x%llx", line->tokens, (unsigned long long)req.address);
@@ -355,7 +381,7 @@ Result ZLCDMA::Cache::OnReadRequest(const Request& req)
         {
             // Line is already in use; evict it
             TraceWrite(req.address, "Processing Bus Read Request: Miss; Evicting line with tag %#016llx",
-                       (unsigned long long)line->tag);
+                       (unsigned long long)m_array.Tag(line - &m_lines[0]));
 
             if (!EvictLine(line, req))
             {
@@ -373,8 +399,8 @@ Result ZLCDMA::Cache::OnReadRequest(const Request& req)
         // Reset the cache-line
         COMMIT
         {
-            line->tag           = tag;
-            line->time          = GetKernel()->GetActiveClock()->GetCycleNo();
+            m_array.Tag(line - &m_lines[0]) = tag;
+            m_array.Touch(line - &m_lines[0], GetKernel()->GetActiveClock()->GetCycleNo());
             line->valid         = true;
             line->dirty         = false;
             line->tokens        = 0;
@@ -382,10 +408,10 @@ Result ZLCDMA::Cache::OnReadRequest(const Request& req)
             line->priority      = false;
             line->pending_read  = false;
             line->pending_write = false;
-            std::fill(line->bitmask, line->bitmask + m_lineSize, false);
+            line->bitmask = 0;
         }
     }
-    else if (!contains(line->bitmask, line->bitmask + m_lineSize, false))
+    else if (line->bitmask == line::full(m_lineSize))
     {
         // We have all data in the line; return it to the memory clients
         // Note that this can happen before a read or write request has
@@ -399,7 +425,7 @@ Result ZLCDMA::Cache::OnReadRequest(const Request& req)
             std::copy(line->data, line->data + m_lineSize, data);
 
             // Update LRU time of the line
-            line->time = GetKernel()->GetActiveClock()->GetCycleNo();
+            m_array.Touch(line - &m_lines[0], GetKernel()->GetActiveClock()->GetCycleNo());
 
             m_numHits++;
         }
@@ -439,7 +465,7 @@ Result ZLCDMA::Cache::OnReadRequest(const Request& req)
         msg->tokens    = 0;
         msg->priority  = false;
         msg->transient = false;
-        std::fill(msg->bitmask, msg->bitmask + m_lineSize, false);
+        msg->bitmask = 0;
 
         line->pending_read = true;
 
@@ -496,7 +522,7 @@ Result ZLCDMA::Cache::OnWriteRequest(const Request& req)
         // Reset the line
         COMMIT
         {
-            line->tag           = tag;
+            m_array.Tag(line - &m_lines[0]) = tag;
             line->valid         = true;
             line->dirty         = false;
             line->tokens        = 0;
@@ -504,7 +530,7 @@ Result ZLCDMA::Cache::OnWriteRequest(const Request& req)
             line->priority      = false;
             line->pending_read  = false;
             line->pending_write = false;
-            std::fill(line->bitmask, line->bitmask + m_lineSize, false);
+            line->bitmask = 0;
         }
 
         newline = true;
@@ -513,11 +539,11 @@ Result ZLCDMA::Cache::OnWriteRequest(const Request& req)
     // Update line; write data
     COMMIT
     {
-        line->time = GetKernel()->GetActiveClock()->GetCycleNo();
+        m_array.Touch(line - &m_lines[0], GetKernel()->GetActiveClock()->GetCycleNo());
         line->dirty = true;
 
         line::blit(line->data, req.mdata.data, req.mdata.mask, m_lineSize);
-        line::setif(line->bitmask, true, req.mdata.mask, m_lineSize);
+        line->bitmask |= req.mdata.mask & line::full(m_lineSize);
     }
 
     if (!newline && !line->transient && line->tokens == m_parent.GetTotalTokens())
@@ -567,7 +593,7 @@ Result ZLCDMA::Cache::OnWriteRequest(const Request& req)
 
         // Send our current (updated) data with the message
         std::copy(line->data,    line->data    + m_lineSize, msg->data);
-        std::copy(line->bitmask, line->bitmask + m_lineSize, msg->bitmask);
+        msg->bitmask = line->bitmask;
 
         if (line->priority)
         {
@@ -615,19 +641,9 @@ Result ZLCDMA::Cache::OnAcquireTokensRem(Message* req)
     // See if the request has data that we don't, and vica versa
     COMMIT
     {
-        for (unsigned int i = 0; i < m_lineSize; i++)
-        {
-            if (!req->bitmask[i] && line->bitmask[i])
-            {
-                req->data[i] = line->data[i];
-                req->bitmask[i] = true;
-            }
-            else if (req->bitmask[i] && !line->bitmask[i])
-            {
-                line->data[i] = req->data[i];
-                line->bitmask[i] = true;
-            }
-        }
+        line::blit(req->data, line->data, line->bitmask & ~req->bitmask, m_lineSize);
+        line::blit(line->data, req->data, req->bitmask & ~line->bitmask, m_lineSize);
+        req->bitmask = line->bitmask = req->bitmask | line->bitmask;
     }
 
     if (line->pending_read)
@@ -763,14 +779,8 @@ Result ZLCDMA::Cache::OnAcquireTokensRet(Message* req)
     // Update the cache-line with data from the request
     COMMIT
     {
-        for (unsigned int i = 0 ; i < m_lineSize; ++i)
-        {
-            if (req->bitmask[i] && !line->bitmask[i])
-            {
-                line->bitmask[i] = true;
-                line->data[i] = req->data[i];
-            }
-        }
+        line::blit(line->data, req->data, req->bitmask & ~line->bitmask, m_lineSize);
+        line->bitmask |= req->bitmask;
     }
 
     unsigned int tokens = line->tokens;
@@ -877,19 +887,9 @@ Result ZLCDMA::Cache::OnReadRem(Message* req)
     }
 
     // Exchange data between line and request
-    for (unsigned int i = 0; i < m_lineSize; i++)
-    {
-        if (line->bitmask[i])
-        {
-            req->data[i] = line->data[i];
-            req->bitmask[i] = true;
-        }
-        else if (req->bitmask[i])
-        {
-            line->data[i] = req->data[i];
-            line->bitmask[i] = true;
-        }
-    }
+    line::blit(req->data, line->data, line->bitmask, m_lineSize);
+    line::blit(line->data, req->data, req->bitmask & ~line->bitmask, m_lineSize);
+    req->bitmask = line->bitmask = req->bitmask | line->bitmask;
 
     if (line->pending_write)
     {
@@ -949,14 +949,7 @@ Result ZLCDMA::Cache::OnReadRet(Message* req)
     assert(line->pending_read);
 
     // See if the line will be full
-    unsigned int missing_bytes = 0;
-    for (unsigned int i = 0; i < m_lineSize; i++)
-    {
-        if (!line->bitmask[i] && !req->bitmask[i])
-        {
-            missing_bytes++;
-        }
-    }
+    unsigned int missing_bytes = __builtin_popcountll(~(line->bitmask | req->bitmask) & line::full(m_lineSize));
 
     if (missing_bytes > 0)
         TraceWrite(req->address, "Received Read Response with %u tokens; Sending request for remaining %u bytes", req->tokens, missing_bytes);
@@ -966,14 +959,8 @@ Result ZLCDMA::Cache::OnReadRet(Message* req)
     COMMIT
     {
         // Update the line with the request's data
-        for (unsigned int i = 0; i < m_lineSize; i++)
-        {
-            if (!line->bitmask[i] && req->bitmask[i])
-            {
-                line->data[i] = req->data[i];
-                line->bitmask[i] = true;
-            }
-        }
+        line::blit(line->data, req->data, req->bitmask & ~line->bitmask, m_lineSize);
+        line->bitmask |= req->bitmask;
 
         // Give tokens to the line
         line->tokens += req->tokens;
@@ -1054,8 +1041,8 @@ Result ZLCDMA::Cache::OnEviction(Message* req)
         // Store evicted line in the allocated line
         COMMIT
         {
-            line->tag           = tag;
-            line->time          = GetKernel()->GetActiveClock()->GetCycleNo();
+            m_array.Tag(line - &m_lines[0]) = tag;
+            m_array.Touch(line - &m_lines[0], GetKernel()->GetActiveClock()->GetCycleNo());
             line->dirty         = req->dirty;
             line->tokens        = req->tokens;
             line->pending_read  = false;
@@ -1064,7 +1051,7 @@ Result ZLCDMA::Cache::OnEviction(Message* req)
             line->priority      = req->priority;
 
             std::copy(req->data, req->data + m_lineSize, line->data);
-            std::fill(line->bitmask, line->bitmask + m_lineSize, true);
+            line->bitmask = line::full(m_lineSize);
 
             delete req;
         }
@@ -1084,7 +1071,7 @@ Result ZLCDMA::Cache::OnEviction(Message* req)
         COMMIT
         {
             line::blitnot(line->data, req->data, line->bitmask, m_lineSize);
-            line::blitnot(line->bitmask, req->bitmask, line->bitmask, m_lineSize);
+            line->bitmask |= req->bitmask;
 
             line->tokens += req->tokens;
             line->priority = line->priority || req->priority;
@@ -1162,6 +1149,7 @@ ZLCDMA::Cache::Cache(const std::string& name, ZLCDMA& parent, Clock& clock, Cach
     m_lineSize (GetTopConf("CacheLineSize", size_t)),
     m_assoc    (assoc),
     m_sets     (m_selector.GetNumBanks()),
+    m_array    (*this, m_sets, m_assoc, GetConfOpt("ReplacementPolicy", string, "LRU")),
     m_inject   (enableInjection),
     m_id       (id),
     m_clients  (),
@@ -1179,10 +1167,12 @@ ZLCDMA::Cache::Cache(const std::string& name, ZLCDMA& parent, Clock& clock, Cach
     InitBuffer(m_responses, clock, "ResponseBufferSize")
 {
 
+    m_array.RegisterState(*this);
     // Create the cache lines
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
         m_lines[i].valid = false;
+        RegisterStateObject(m_lines[i], "line" + to_string(i));
     }
 
     m_requests.Sensitive(p_Requests);
@@ -1280,7 +1270,7 @@ void ZLCDMA::Cache::Cmd_Read(std::ostream& out, const std::vector<std::string>&
             out << " |                        |        |                                                 |";
         } else {
             out << " | "
-                << hex << "0x" << setw(16) << setfill('0') << m_selector.Unmap(line.tag, set) * m_lineSize
+                << hex << "0x" << setw(16) << setfill('0') << m_selector.Unmap(m_array.Tag(i), set) * m_lineSize
                 << ' '
                 << (line.pending_read  ? 'R' : ' ')
                 << (line.pending_write ? 'W' : ' ')
@@ -1296,7 +1286,7 @@ void ZLCDMA::Cache::Cmd_Read(std::ostream& out, const std::vector<std::string>&
             {
                 for (size_t x = y; x < y + BYTES_PER_LINE; ++x) {
                     out << " ";
-                    if (line.bitmask[x]) {
+                    if (line::test(line.bitmask, x)) {
                         out << setw(2) << (unsigned)(unsigned char)line.data[x];
                     } else {
                         out << "  ";
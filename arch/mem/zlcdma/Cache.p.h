@@ -5,6 +5,7 @@
 #include <arch/mem/zlcdma/Node.h>
 #include <sim/inspect.h>
 #include <arch/BankSelector.h>
+#include <arch/CacheArray.h>
 
 #include <queue>
 #include <set>
@@ -15,11 +16,10 @@ namespace Simulator
 class ZLCDMA::Cache : public ZLCDMA::Node, public Inspect::Interface<Inspect::Read>
 {
 public:
+    // A cache line; its tag and LRU state are in m_array.
     struct Line
     {
         bool    valid;  // Line in use?
-        MemAddr tag;    // Tag of address for this line
-        CycleNo time;   // Last access time for LRU eviction
 
         // The data stored in this line
         char data[MAX_MEMORY_OPERATION_SIZE];
@@ -27,7 +27,7 @@ public:
         // The bitmask indicates the valid sections of the line,
         // when writes are stored by replies come back with the
         // whole cache line.
-        bool bitmask[MAX_MEMORY_OPERATION_SIZE];
+        LineMask bitmask;
 
         // Tokens held by this line
         unsigned int tokens;
@@ -49,10 +49,15 @@ public:
         std::vector<WriteAck> ack_queue;
 
         Line()
-        : valid(false), tag(0), time(0), tokens(0), priority(false),
+        : valid(false), bitmask(0), tokens(0), priority(false),
             pending_read(false), pending_write(false), dirty(false),
             transient(false), ack_queue()
         {}
+
+        SERIALIZE(a) {
+            a & "zl" & valid & Serialization::binary(data, MAX_MEMORY_OPERATION_SIZE) & bitmask
+              & tokens & priority & pending_read & pending_write & dirty & transient & ack_queue;
+        }
     };
 
 private:
@@ -72,6 +77,7 @@ private:
     size_t                        m_lineSize;
     size_t                        m_assoc;
     size_t                        m_sets;
+    CacheArray                    m_array;
     bool                          m_inject;
     CacheID                       m_id;
     std::vector<IMemoryCallback*> m_clients;
@@ -130,6 +136,11 @@ public:
     void UnregisterClient(MCID id);
     bool Read (MCID id, MemAddr address);
     bool Write(MCID id, MemAddr address, const MemData& data, WClientID wid);
+
+    // Functional access to the line copy of the data, if any; the
+    // range must lie within a single line. See IMemory::OnFunctionalRead.
+    void OnFunctionalRead (MemAddr address, char* data, size_t size);
+    void OnFunctionalWrite(MemAddr address, const char* data, size_t size);
 };
 
 }
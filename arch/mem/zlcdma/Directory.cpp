@@ -277,6 +277,8 @@ Result ZLCDMA::Directory::DoInTop()
     InitProcess(p_InBottom, DoInBottom),
     InitProcess(p_InTop, DoInTop)
 {
+    RegisterStateObject(m_lines, "lines");
+
     m_bottom.m_incoming.Sensitive(p_InBottom);
     m_top.m_incoming.Sensitive(p_InTop);
 
@@ -38,6 +38,8 @@ public:
         MemAddr      tag;
         unsigned int tokens;     ///< Tokens in the caches in the group
         Line() : valid(false), tag(0), tokens(0) {}
+
+        SERIALIZE(a) { a & "dl" & valid & tag & tokens; }
     };
 
 protected:
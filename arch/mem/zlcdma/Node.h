@@ -59,7 +59,7 @@ protected:
 
             // Message data and validity bitmask
             char            data   [MAX_MEMORY_OPERATION_SIZE];
-            bool            bitmask[MAX_MEMORY_OPERATION_SIZE];
+            LineMask        bitmask;
 
             // To avoid deadlock, messages sometimes have to be routed the long way.
             // This flag, when set, causes all relevant clients to ignore the message in such a case.
@@ -160,9 +160,9 @@ namespace Serialization
                 & p->priority
                 & p->transient
                 & p->tokens
-                & Serialization::binary(p->data, MAX_MEMORY_OPERATION_SIZE);
-            for (auto &b : p->bitmask) arch & b;
-            arch & "]";
+                & Serialization::binary(p->data, MAX_MEMORY_OPERATION_SIZE)
+                & p->bitmask
+                & "]";
         }
     };
 }
@@ -70,10 +70,16 @@ ZLCDMA::RootDirectory::Line* ZLCDMA::RootDirectory::GetEmptyLine(MemAddr address
     return NULL;
 }
 
-bool ZLCDMA::RootDirectory::OnReadCompleted()
+bool ZLCDMA::RootDirectory::OnReadCompleted(MemAddr address)
 {
-    assert(!m_active.empty());
-    Message* msg = m_active.front();
+    // The DDR channel may reorder reads; find the oldest one for this address
+    auto p = m_active.begin();
+    while (p != m_active.end() && (unsigned int)((*p)->address / m_lineSize / m_numRoots * m_lineSize) != address)
+    {
+        ++p;
+    }
+    assert(p != m_active.end());
+    Message* msg = *p;
 
     // Attach data to message, give all tokens and send
     COMMIT
@@ -82,11 +88,11 @@ bool ZLCDMA::RootDirectory::OnReadCompleted()
         static_cast<VirtualMemory&>(m_parent).Read(msg->address, data, m_lineSize);
 
         line::blitnot(msg->data, data, msg->bitmask, m_lineSize);
-        std::fill(msg->bitmask, msg->bitmask + m_lineSize, true);
+        msg->bitmask = line::full(m_lineSize);
 
         msg->dirty = false;
 
-        m_active.pop();
+        m_active.erase(p);
     }
 
     if (!m_responses.Push(msg))
@@ -160,7 +166,7 @@ bool ZLCDMA::RootDirectory::OnMessageReceived(Message* req)
                 break;
             }
 
-            if (!contains(req->bitmask, req->bitmask + m_lineSize, false))
+            if (req->bitmask == line::full(m_lineSize))
             {
                 // The message itself contains all data, which means it already exists in the system
                 // without going through the root directory (i.e., writes).
@@ -369,7 +375,7 @@ Result ZLCDMA::RootDirectory::DoRequests()
 
             COMMIT{
                 ++m_nreads;
-                m_active.push(msg);
+                m_active.push_back(msg);
             }
         }
         else
@@ -382,7 +388,7 @@ Result ZLCDMA::RootDirectory::DoRequests()
             }
 
             COMMIT{
-                static_cast<VirtualMemory&>(m_parent).Write(msg->address, msg->data, 0, m_lineSize);
+                static_cast<VirtualMemory&>(m_parent).WriteLine(msg->address, msg->data, msg->bitmask, m_lineSize);
 
                 ++m_nwrites;
                 delete msg;
@@ -471,6 +477,9 @@ ZLCDMA::RootDirectory::RootDirectory(const std::string& name, ZLCDMA& parent, Cl
 {
     assert(m_lineSize <= MAX_MEMORY_OPERATION_SIZE);
 
+    RegisterStateObject(m_lines, "lines");
+    RegisterStateObject(m_active, "active");
+
     RegisterModelObject(*this, "rootdir");
     RegisterModelProperty(*this, "freq", (uint32_t)clock.GetFrequency());
 
@@ -5,6 +5,7 @@
 #include "Directory.h"
 #include <arch/mem/DDR.h>
 
+#include <deque>
 #include <queue>
 #include <set>
 
@@ -29,6 +30,8 @@ public:
         Line()
         : valid(false), tag(0), loading(false), data(false), tokens(0), priority(false), requests()
         {}
+
+        SERIALIZE(a) { a & "rdl" & valid & tag & loading & data & tokens & priority & requests; }
     };
 
 private:
@@ -47,7 +50,7 @@ private:
     Buffer<Message*>  m_requests;  ///< Requests to memory
     Buffer<Message*>  m_responses; ///< Responses from memory
 
-    std::queue<Message*> m_active;  ///< Active messages in memory
+    std::deque<Message*> m_active;  ///< Active messages in memory, in issue order
 
 	std::queue<Line*>    m_activelines;
 
@@ -59,7 +62,7 @@ private:
     Line* FindLine(MemAddr address);
     Line* GetEmptyLine(MemAddr address, MemAddr& tag);
     bool  OnMessageReceived(Message* msg);
-    bool  OnReadCompleted();
+    bool  OnReadCompleted(MemAddr address);
 
     // Processes
     Result DoIncoming();
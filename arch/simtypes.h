@@ -461,7 +461,7 @@ namespace Serialization
         switch(r.value->m_state)
         {
         case RST_INVALID: break;
-        case RST_EMPTY: break;
+        case RST_EMPTY:
         case RST_WAITING:
         case RST_PENDING:
             a & r.value->m_waiting
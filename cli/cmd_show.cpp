@@ -49,6 +49,15 @@ bool cmd_show_processes(const vector<string>& /*command*/, vector<string>& args,
     return false;
 }
 
+bool cmd_show_profile(const vector<string>& /*command*/, vector<string>& args, cli_context& ctx)
+{
+    string pat = "*";
+    if (!args.empty())
+        pat = args[0];
+    ctx.sys.GetKernel()->PrintProfile(cout, pat);
+    return false;
+}
+
 
 bool cmd_show_devdb(const vector<string>& /*command*/, vector<string>& /*args*/, cli_context& /*ctx*/)
 {
@@ -1,5 +1,6 @@
 #include "commands.h"
 #include <cerrno>
+#include <fstream>
 
 using namespace Simulator;
 using namespace std;
@@ -81,3 +82,50 @@ bool cmd_stats(const vector<string>& /*command*/, vector<string>& /*args*/, cli_
     ctx.sys.PrintAllStatistics(cout);
     return false;
 }
+
+void SaveCheckpoint(MGSystem& sys, const string& filename)
+{
+    ofstream os(filename.c_str(), ios::out | ios::trunc);
+    if (!os)
+        throw runtime_error("Unable to open checkpoint file for writing: " + filename);
+    sys.GetKernel()->SaveCheckpoint(os);
+    os.close();
+    if (!os)
+        throw runtime_error("Error while writing checkpoint file: " + filename);
+}
+
+void LoadCheckpoint(MGSystem& sys, const string& filename)
+{
+    ifstream is(filename.c_str(), ios::in);
+    if (!is)
+        throw runtime_error("Unable to open checkpoint file: " + filename);
+    sys.GetKernel()->LoadCheckpoint(is);
+}
+
+bool cmd_save(const vector<string>& /*command*/, vector<string>& args, cli_context& ctx)
+{
+    try
+    {
+        SaveCheckpoint(ctx.sys, args[0]);
+        cout << "Saved checkpoint at cycle " << ctx.sys.GetKernel()->GetCycleNo() << endl;
+    }
+    catch (const exception& e)
+    {
+        PrintException(&ctx.sys, cerr, e);
+    }
+    return false;
+}
+
+bool cmd_load(const vector<string>& /*command*/, vector<string>& args, cli_context& ctx)
+{
+    try
+    {
+        LoadCheckpoint(ctx.sys, args[0]);
+        cout << "Restored checkpoint at cycle " << ctx.sys.GetKernel()->GetCycleNo() << endl;
+    }
+    catch (const exception& e)
+    {
+        PrintException(&ctx.sys, cerr, e);
+    }
+    return false;
+}
@@ -42,11 +42,14 @@ extern command_handler
     cmd_quit,
     cmd_inspect,
     cmd_run,
+    cmd_load,
+    cmd_save,
     cmd_set,
     cmd_show_vars,
     cmd_show_syms,
     cmd_show_components,
     cmd_show_processes,
+    cmd_show_profile,
     cmd_show_devdb,
     cmd_state,
     cmd_stats,
@@ -87,6 +90,8 @@ bool HandleCommandLine(cli_context& ctx);
 
 void PrintException(Simulator::MGSystem* sys, std::ostream& out, const std::exception& e);
 void StepSystem(Simulator::MGSystem& system, Simulator::CycleNo cycles);
+void SaveCheckpoint(Simulator::MGSystem& system, const std::string& filename);
+void LoadCheckpoint(Simulator::MGSystem& system, const std::string& filename);
 
 template<unsigned Type>
 void DoObjectCommand(std::ostream& out, Simulator::MGSystem& sys, const std::string& pat, std::vector<std::string>& args)
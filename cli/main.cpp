@@ -17,9 +17,12 @@
 #include <fstream>
 #include <limits>
 #include <memory>
+#include <map>
+#include <cstdio>
 #include <cstdlib>
 
 #include <sys/param.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <argp.h>
 
@@ -47,6 +50,11 @@ struct ProgramConfig
     bool                             m_dumpnodeprops;
     bool                             m_dumpedgeprops;
     vector<string>                   m_argv;
+    CycleNo                          m_checkpointAt;
+    string                           m_checkpointFile;
+    string                           m_restoreFile;
+    string                           m_batchFile;
+    size_t                           m_batchJobs;
     ProgramConfig()
         : m_areaTech(0),
           m_configFile(MGSIM_CONFIG_PATH),
@@ -66,7 +74,12 @@ struct ProgramConfig
           m_topofile(),
           m_dumpnodeprops(true),
           m_dumpedgeprops(true),
-          m_argv()
+          m_argv(),
+          m_checkpointAt(0),
+          m_checkpointFile("mgsim.ckpt"),
+          m_restoreFile(),
+          m_batchFile(),
+          m_batchJobs(1)
     {
         const char *v = getenv("MGSIM_BASE_CONFIG");
         if (v != nullptr)
@@ -122,6 +135,13 @@ static const struct argp_option mgsim_options[] =
     { "do-nothing", 'n', 0, 0, "Exit before the program starts, but after the system is configured.", 3 },
     { "quiet", 'q', 0, 0, "Do not print simulation statistics after execution.", 3 },
     { "terminate", 't', 0, 0, "Terminate the simulator upon an exception, instead of dropping to the interactive prompt.", 3 },
+    { "checkpoint-at", 13, "CYCLE", 0, "Save a checkpoint when the simulation reaches master cycle CYCLE, then continue.", 3 },
+    { "checkpoint-file", 14, "FILE", 0, "Save the checkpoint requested with --checkpoint-at to FILE (default mgsim.ckpt).", 3 },
+    { "restore", 15, "FILE", 0, "Restore the simulation state from checkpoint FILE before starting. "
+      "The configuration and program must be the same as when the checkpoint was saved.", 3 },
+    { "batch", 16, "FILE", 0, "Instantiate the system once, then run the program once per line of FILE, "
+      "each in a forked copy of the system. Each line holds -R and -F options for that run.", 3 },
+    { "batch-jobs", 17, "NUM", 0, "Run up to NUM runs of the batch at the same time (default 1).", 3 },
 
 #ifdef ENABLE_CACTI
     { "area", 'a', "VAL", 0, "Dump area information prior to program startup using CACTI. Assume technology is VAL nanometers.", 4 },
@@ -174,6 +194,27 @@ static error_t mgsim_parse_opt(int key, char *arg, struct argp_state *state)
     case 11 : config.m_dumpnodeprops = false; break;
     case 12 : config.m_dumpedgeprops = false; break;
     case 'n': config.m_earlyquit = true; break;
+    case 13 :
+    {
+        char* endptr;
+        config.m_checkpointAt = strtoull(arg, &endptr, 0);
+        if (*endptr != '\0' || config.m_checkpointAt == 0) {
+            throw runtime_error("Error: invalid checkpoint cycle: " + string(arg));
+        }
+    }
+    break;
+    case 14 : config.m_checkpointFile = arg; break;
+    case 15 : config.m_restoreFile = arg; break;
+    case 16 : config.m_batchFile = arg; break;
+    case 17 :
+    {
+        char* endptr;
+        config.m_batchJobs = strtoul(arg, &endptr, 0);
+        if (*endptr != '\0' || config.m_batchJobs == 0) {
+            throw runtime_error("Error: invalid number of batch jobs: " + string(arg));
+        }
+    }
+    break;
     case 'o':
     {
             string sarg = arg;
@@ -271,9 +312,150 @@ void AtEnd(const MGSystem& sys, const ProgramConfig& cfg)
         sys.PrintAllStatistics(clog);
         clog << "### end end-of-simulation statistics" << endl;
     }
+    if (sys.GetKernel()->IsProfiling())
+    {
+        clog << "### begin end-of-simulation profile" << endl;
+        sys.GetKernel()->PrintProfile(clog, "*", 20);
+        clog << "### end end-of-simulation profile" << endl;
+    }
     PrintFinalVariables(*sys.GetKernel(), cfg);
 }
 
+// Parses a line of a batch file into register initializers, in the
+// format of the InitRegs configuration key.
+static
+vector<string> ParseBatchLine(const string& line)
+{
+    vector<string> regs;
+    istringstream is(line);
+    string opt;
+    while (is >> opt)
+    {
+        if (opt.size() < 2 || opt[0] != '-' || (opt[1] != 'R' && opt[1] != 'F'))
+        {
+            // The other options select the components to instantiate.
+            throw runtime_error("Error: unsupported option in batch file, only -R and -F are allowed: " + opt);
+        }
+
+        string regnum = opt.substr(2);
+        if (regnum.empty() && !(is >> regnum)) {
+            throw runtime_error("Error: " + opt + ": expected register number");
+        }
+        string value;
+        if (!(is >> value)) {
+            throw runtime_error("Error: -" + string(1, opt[1]) + regnum + ": expected register value");
+        }
+        regs.push_back(opt[1] + regnum + "=" + value);
+    }
+    return regs;
+}
+
+// Runs the program once per line of the batch file, each in a child
+// process forked from the instantiated system. Returns true in the
+// children, which then proceed with their run, and false in the
+// parent once all runs have completed, with the exit status in
+// status: 1 if any run failed. The exit status of every run is
+// printed in its "### end batch run" line.
+static
+bool RunBatch(MGSystem& sys, const ProgramConfig& flags, int& status)
+{
+    vector<pair<string, vector<string> > > runs;
+    ifstream file(flags.m_batchFile.c_str());
+    if (!file.good())
+    {
+        throw runtime_error("Error: cannot read batch file: " + flags.m_batchFile);
+    }
+    for (string line; getline(file, line); )
+    {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos || line[start] == '#')
+            continue;
+        line = line.substr(start, line.find_last_not_of(" \t\r") + 1 - start);
+        runs.push_back(make_pair(line, ParseBatchLine(line)));
+    }
+
+    // The host threads of the kernel do not exist in the children;
+    // they start their own.
+    Kernel& kernel = *sys.GetKernel();
+    const size_t threads = kernel.GetNumThreads();
+    kernel.SetNumThreads(1);
+
+    // Do not duplicate pending output into the children
+    cout.flush();
+    clog.flush();
+    fflush(NULL);
+
+    vector<FILE*>     outputs(runs.size(), NULL);
+    vector<int>       statuses(runs.size(), -1);
+    map<pid_t,size_t> running;
+    size_t next = 0, printed = 0, failed = 0;
+    while (printed < runs.size())
+    {
+        if (next < runs.size() && running.size() < flags.m_batchJobs)
+        {
+            // Start the next run, with its output into a temporary file
+            FILE* output = tmpfile();
+            if (output == NULL)
+            {
+                throw runtime_error("Error: cannot create temporary file for batch run");
+            }
+
+            pid_t pid = fork();
+            if (pid < 0)
+            {
+                throw runtime_error("Error: cannot fork batch run");
+            }
+
+            if (pid == 0)
+            {
+                // The resource usage of the child starts from zero,
+                // so measure its host times from here.
+                static ResourceUsage start(true, true);
+
+                dup2(fileno(output), STDOUT_FILENO);
+                dup2(fileno(output), STDERR_FILENO);
+                sys.SetInitialRegisters(runs[next].second);
+                kernel.SetNumThreads(threads);
+                return true;
+            }
+            outputs[next] = output;
+            running[pid] = next++;
+            continue;
+        }
+
+        // Wait for a run to complete
+        int st;
+        pid_t pid = wait(&st);
+        if (pid < 0)
+        {
+            throw runtime_error("Error: lost track of batch runs");
+        }
+        auto r = running.find(pid);
+        if (r == running.end())
+            continue;
+        statuses[r->second] = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+        running.erase(r);
+
+        // Print the output of the completed runs, in order
+        for (; printed < runs.size() && statuses[printed] >= 0; ++printed)
+        {
+            cout << "### begin batch run " << printed + 1 << ": " << runs[printed].first << endl;
+            rewind(outputs[printed]);
+            char buf[4096];
+            for (size_t n; (n = fread(buf, 1, sizeof buf, outputs[printed])) > 0; )
+                cout.write(buf, n);
+            fclose(outputs[printed]);
+            cout << "### end batch run " << printed + 1 << ": exit status " << statuses[printed] << endl;
+            if (statuses[printed] != 0)
+                ++failed;
+        }
+    }
+
+    clog << "### batch: " << runs.size() << " runs, " << failed << " failed" << endl;
+    status = (failed == 0) ? 0 : 1;
+    return false;
+}
+
 static
 void MemoryExhausted()
 {
@@ -468,6 +650,46 @@ int main(int argc, char** argv)
         // we can just stop here.
         return 0;
 
+    if (!flags.m_batchFile.empty())
+    {
+        // Run the batch. The parent stops here once all runs have
+        // completed; each child continues as a non-interactive run.
+        try
+        {
+            if (flags.m_interactive || !flags.m_restoreFile.empty() || flags.m_checkpointAt != 0)
+            {
+                throw runtime_error("Error: --batch cannot be combined with -i, --restore or --checkpoint-at");
+            }
+
+            int status;
+            if (!RunBatch(*sys, flags, status))
+                return status;
+        }
+        catch (const exception& e)
+        {
+            PrintException(NULL, cerr, e);
+            return 1;
+        }
+        flags.m_terminate = true;
+    }
+
+    if (!flags.m_restoreFile.empty())
+    {
+        // Restore the state of a previous simulation, if requested.
+        try
+        {
+            LoadCheckpoint(*sys, flags.m_restoreFile);
+        }
+        catch (const exception& e)
+        {
+            PrintException(NULL, cerr, e);
+            return 1;
+        }
+        if (!flags.m_quiet)
+            clog << "### restored checkpoint " << flags.m_restoreFile
+                 << " at cycle " << sys->GetKernel()->GetCycleNo() << endl;
+    }
+
     // Otherwise, the simulation should start.
 
     ////
@@ -497,6 +719,25 @@ int main(int argc, char** argv)
             try
             {
                 mo->start();
+                if (flags.m_checkpointAt != 0)
+                {
+                    // Run up to the checkpoint first.
+                    CycleNo now = sys->GetKernel()->GetCycleNo();
+                    if (now < flags.m_checkpointAt)
+                        StepSystem(*sys, flags.m_checkpointAt - now);
+
+                    now = sys->GetKernel()->GetCycleNo();
+                    if (now == flags.m_checkpointAt)
+                    {
+                        SaveCheckpoint(*sys, flags.m_checkpointFile);
+                        if (!flags.m_quiet)
+                            clog << "### saved checkpoint " << flags.m_checkpointFile
+                                 << " at cycle " << now << endl;
+                    }
+                    else
+                        cerr << "# Warning: no checkpoint saved, the simulation is at cycle "
+                             << now << endl;
+                }
                 StepSystem(*sys, INFINITE_CYCLES);
                 mo->stop();
 
@@ -0,0 +1,536 @@
+#ifdef HAVE_CONFIG_H
+#include <sys_config.h>
+#endif
+
+#include "commands.h"
+#include <arch/MGSystem.h>
+#include <arch/Memory.h>
+#include <arch/mem/MemoryTrace.h>
+#include <sim/config.h>
+#include <sim/configparser.h>
+#include <sim/flag.h>
+#include <sim/readfile.h>
+#include <sim/rusage.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <argp.h>
+
+using namespace Simulator;
+using namespace std;
+
+/*
+  mgsim-replay: replays a memory request trace, recorded with
+  MemoryTraceFile, into a memory system. Only the memory system is
+  simulated, so that its configuration can be explored without
+  simulating the cores.
+
+  Every client of the memory in the trace is replaced by a replay
+  client, which issues the requests of that client in order. The
+  timing policy decides when a request may be issued:
+
+  - timed: at the cycle at which it was recorded;
+  - dependent: after the recorded distance to the previous request of
+    the client, measured from when that request was issued;
+  - asap: as soon as the memory accepts it.
+
+  In addition, a request is held while a read to the same address is
+  outstanding for its client, or while the client has the maximum
+  number of outstanding reads (the window; 1 by default for the
+  dependent policy, unlimited otherwise).
+*/
+
+enum ReplayPolicy
+{
+    POLICY_TIMED,
+    POLICY_DEPENDENT,
+    POLICY_ASAP,
+};
+
+struct ReplayRequest
+{
+    bool     write;
+    CycleNo  cycle;         ///< Recorded cycle, in replay master cycles
+    MemAddr  address;
+    uint64_t mask;
+};
+
+class ReplayClient : public Object, public IMemoryCallback
+{
+    IMemory*                  m_memory;
+    MCID                      m_mcid;
+    ReplayPolicy              m_policy;
+    size_t                    m_window;         ///< Max outstanding reads, 0 for no limit
+    std::vector<ReplayRequest> m_requests;
+    size_t                    m_next;           ///< Next request to issue
+    CycleNo                   m_lastIssue;      ///< Cycle at which the last request was issued
+    std::map<MemAddr, CycleNo> m_pending;       ///< Outstanding reads and their issue cycle
+    size_t                    m_pendingWrites;  ///< Outstanding writes
+
+    Flag                      m_active;         ///< Are there requests left to issue?
+
+    Result DoIssue();
+
+public:
+    Process p_Issue;
+
+    // Statistics
+    uint64_t m_nreads;
+    uint64_t m_nwrites;
+    CycleNo  m_totalLatency;    ///< Sum of the read latencies
+    CycleNo  m_maxLatency;      ///< Highest read latency
+
+    ReplayClient(const std::string& name, Object& parent, Clock& clock, ReplayPolicy policy, size_t window);
+    ReplayClient(const ReplayClient&) = delete;
+    ReplayClient& operator=(const ReplayClient&) = delete;
+
+    void ConnectMemory(IMemory* memory, bool grouped);
+    void AddRequest(const ReplayRequest& req) { m_requests.push_back(req); }
+    std::vector<ReplayRequest>& GetRequests() { return m_requests; }
+
+    bool IsDone() const { return m_next == m_requests.size() && m_pending.empty() && m_pendingWrites == 0; }
+
+    // IMemoryCallback
+    bool OnMemoryReadCompleted(MemAddr addr, const char* data) override;
+    bool OnMemoryWriteCompleted(WClientID wid) override;
+    bool OnMemoryInvalidated(MemAddr addr) override;
+    Object& GetMemoryPeer() override { return *this; }
+};
+
+ReplayClient::ReplayClient(const std::string& name, Object& parent, Clock& clock, ReplayPolicy policy, size_t window)
+    : Object(name, parent),
+      m_memory(NULL),
+      m_mcid(0),
+      m_policy(policy),
+      m_window(window),
+      m_requests(),
+      m_next(0),
+      m_lastIssue(0),
+      m_pending(),
+      m_pendingWrites(0),
+      m_active("b_active", *this, clock, true),
+      InitProcess(p_Issue, DoIssue),
+      m_nreads(0),
+      m_nwrites(0),
+      m_totalLatency(0),
+      m_maxLatency(0)
+{
+    m_active.Sensitive(p_Issue);
+    RegisterModelObject(*this, "replay client");
+}
+
+void ReplayClient::ConnectMemory(IMemory* memory, bool grouped)
+{
+    StorageTraceSet traces;
+    m_memory = memory;
+    m_mcid   = m_memory->RegisterClient(*this, p_Issue, traces, StorageTraceSet(), grouped);
+    p_Issue.SetStorageTraces(opt(m_active ^ traces));
+}
+
+Result ReplayClient::DoIssue()
+{
+    if (m_next == m_requests.size())
+    {
+        // All requests have been issued
+        m_active.Clear();
+        return SUCCESS;
+    }
+
+    const ReplayRequest& req = m_requests[m_next];
+    const CycleNo now = GetKernel()->GetCycleNo();
+
+    CycleNo ready = 0;
+    switch (m_policy)
+    {
+    case POLICY_TIMED:
+        ready = req.cycle;
+        break;
+    case POLICY_DEPENDENT:
+        ready = (m_next == 0) ? req.cycle : m_lastIssue + (req.cycle - m_requests[m_next - 1].cycle);
+        break;
+    case POLICY_ASAP:
+        break;
+    }
+
+    if (now < ready || m_pending.count(req.address) != 0 ||
+        (!req.write && m_window != 0 && m_pending.size() >= m_window))
+    {
+        // Not yet
+        return SUCCESS;
+    }
+
+    if (req.write)
+    {
+        MemData data;
+        std::fill(data.data, data.data + MAX_MEMORY_OPERATION_SIZE, 0);
+        data.mask = req.mask;
+
+        if (!m_memory->Write(m_mcid, req.address, data, (WClientID)m_mcid))
+        {
+            DeadlockWrite("Unable to send write to %#016llx to memory", (unsigned long long)req.address);
+            return FAILED;
+        }
+
+        COMMIT {
+            ++m_pendingWrites;
+            ++m_nwrites;
+        }
+    }
+    else
+    {
+        if (!m_memory->Read(m_mcid, req.address))
+        {
+            DeadlockWrite("Unable to send read from %#016llx to memory", (unsigned long long)req.address);
+            return FAILED;
+        }
+
+        COMMIT {
+            m_pending[req.address] = now;
+            ++m_nreads;
+        }
+    }
+
+    COMMIT {
+        m_lastIssue = now;
+        ++m_next;
+    }
+    return SUCCESS;
+}
+
+bool ReplayClient::OnMemoryReadCompleted(MemAddr addr, const char* /*data*/)
+{
+    // Completions may be broadcast to all clients of a cache;
+    // only handle our own reads.
+    auto p = m_pending.find(addr);
+    if (p != m_pending.end())
+    {
+        COMMIT {
+            CycleNo latency = GetKernel()->GetCycleNo() - p->second;
+            m_totalLatency += latency;
+            m_maxLatency    = std::max(m_maxLatency, latency);
+            m_pending.erase(p);
+        }
+    }
+    return true;
+}
+
+bool ReplayClient::OnMemoryWriteCompleted(WClientID wid)
+{
+    if (wid == (WClientID)m_mcid)
+    {
+        COMMIT { --m_pendingWrites; }
+    }
+    return true;
+}
+
+bool ReplayClient::OnMemoryInvalidated(MemAddr /*addr*/)
+{
+    return true;
+}
+
+//
+// Command line handling
+//
+struct ReplayConfig
+{
+    string       m_configFile;
+    ConfigMap    m_overrides;
+    string       m_traceFile;
+    ReplayPolicy m_policy;
+    size_t       m_window;
+    bool         m_windowSet;
+    bool         m_quiet;
+
+    ReplayConfig()
+        : m_configFile(MGSIM_CONFIG_PATH),
+          m_overrides(),
+          m_traceFile(),
+          m_policy(POLICY_DEPENDENT),
+          m_window(0),
+          m_windowSet(false),
+          m_quiet(false)
+    {
+        const char *v = getenv("MGSIM_BASE_CONFIG");
+        if (v != nullptr)
+        {
+            m_configFile = v;
+        }
+    }
+};
+
+extern "C"
+{
+const char *argp_program_version =
+    "mgsim-replay " PACKAGE_VERSION "\n"
+    "Copyright (C) 2008-2015 the MGSim project.";
+
+const char *argp_program_bug_address =
+    PACKAGE_BUGREPORT;
+}
+
+static const char *replay_doc =
+    "This program replays a memory request trace into a memory system."
+    "\v"
+    "The trace is recorded by mgsim with -o MemoryTraceFile=FILE. "
+    "The memory system is configured as for mgsim, e.g. with "
+    "-o MemoryType=DDR."
+    "\n\n"
+    "Timing policies: 'timed' issues every request at its recorded cycle; "
+    "'dependent' (default) keeps the recorded distance between the requests "
+    "of a client; 'asap' issues requests as soon as the memory accepts them.";
+
+static const struct argp_option replay_options[] =
+{
+    { "config", 'c', "FILE", 0, "Read default configuration from FILE.", 1 },
+    { "override", 'o', "NAME=VAL", 0, "Add override option NAME with value VAL. Can be specified multiple times.", 1 },
+    { "include", 'I', "FILE", 0, "Read extra override options from FILE. Can be specified multiple times.", 1 },
+
+    { "policy", 'P', "POLICY", 0, "Timing policy: timed, dependent or asap.", 2 },
+    { "window", 'w', "N", 0, "Maximum number of outstanding reads per client, 0 for no limit. "
+      "Defaults to 1 for the dependent policy, 0 otherwise.", 2 },
+
+    { "quiet", 'q', 0, 0, "Do not print the memory statistics.", 3 },
+
+    { 0, 0, 0, 0, 0, 0 }
+};
+
+static error_t replay_parse_opt(int key, char *arg, struct argp_state *state)
+{
+    struct ReplayConfig &config = *(struct ReplayConfig*)state->input;
+
+    switch (key)
+    {
+    case 'c': config.m_configFile = arg; break;
+    case 'q': config.m_quiet = true; break;
+    case 'P':
+    {
+        string policy = arg;
+        if      (policy == "timed")     config.m_policy = POLICY_TIMED;
+        else if (policy == "dependent") config.m_policy = POLICY_DEPENDENT;
+        else if (policy == "asap")      config.m_policy = POLICY_ASAP;
+        else throw runtime_error("Error: unknown timing policy: " + policy);
+    }
+    break;
+    case 'w':
+    {
+        char* endptr;
+        config.m_window = strtoul(arg, &endptr, 0);
+        if (*endptr != '\0') {
+            throw runtime_error("Error: invalid window: " + string(arg));
+        }
+        config.m_windowSet = true;
+    }
+    break;
+    case 'o':
+    {
+        string sarg = arg;
+        string::size_type eq = sarg.find_first_of("=");
+        if (eq == string::npos) {
+            throw runtime_error("Error: malformed configuration override syntax: " + sarg);
+        }
+        config.m_overrides.append(sarg.substr(0, eq), sarg.substr(eq + 1));
+    }
+    break;
+    case 'I':
+    {
+        ConfigParser parser(config.m_overrides);
+        try {
+            parser(read_file(arg));
+        } catch (runtime_error& e) {
+            throw runtime_error("Error reading include file: " + string(arg) + "\n" + e.what());
+        }
+    }
+    break;
+    case ARGP_KEY_ARG:
+        if (!config.m_traceFile.empty()) {
+            argp_usage(state);
+        }
+        config.m_traceFile = arg;
+        break;
+    case ARGP_KEY_NO_ARGS:
+        argp_usage(state);
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp argp = {
+    replay_options /* options */,
+    replay_parse_opt /* parser */,
+    "TRACE" /* args_doc */,
+    replay_doc /* doc */,
+    NULL /* children */,
+    NULL /* help filter */,
+    NULL /* argp domain */
+};
+
+// Converts a cycle count from one master frequency to another
+static CycleNo ScaleCycles(CycleNo cycles, Clock::Frequency from, Clock::Frequency to)
+{
+    return cycles / from * to + cycles % from * to / from;
+}
+
+int main(int argc, char** argv)
+{
+    ReplayConfig flags;
+    UNIQUE_PTR<Config> config;
+
+    try
+    {
+        argp_parse(&argp, argc, argv, 0, 0, &flags);
+
+        ConfigMap base_config;
+        ConfigParser parser(base_config);
+        try {
+            parser(read_file(flags.m_configFile));
+        } catch (runtime_error& e) {
+            throw runtime_error("Error reading configuration file: " + flags.m_configFile + "\n" + e.what());
+        }
+        config.reset(new Config(base_config, flags.m_overrides, vector<string>()));
+    }
+    catch (const exception& e)
+    {
+        PrintException(NULL, cerr, e);
+        return 1;
+    }
+
+    if (!flags.m_windowSet && flags.m_policy == POLICY_DEPENDENT)
+    {
+        flags.m_window = 1;
+    }
+
+    try
+    {
+#ifdef STATIC_KERNEL
+        Kernel::InitGlobalKernel();
+        Kernel& kernel = Kernel::GetGlobalKernel();
+#else
+        Kernel kernel;
+#endif
+        kernel.AttachConfig(*config);
+        srand(config->getValueOrDefault<unsigned>("RandomSeed", 0));
+
+        // Create the memory system and a client clock at the core frequency
+        Object* root = new Object("", kernel);
+        string memory_type = config->getValue<string>("MemoryType");
+        transform(memory_type.begin(), memory_type.end(), memory_type.begin(), ::toupper);
+
+        Clock& memclock = kernel.CreateClock(config->getValue<Clock::Frequency>("MemoryFreq"));
+        Clock& clock    = kernel.CreateClock(config->getValue<Clock::Frequency>("CoreFreq"));
+
+        IMemoryAdmin* memadmin;
+        UNIQUE_PTR<IMemory> memory(CreateMemory(memory_type, *root, memclock, memadmin));
+        SymbolTable symtable;
+        memadmin->SetSymbolTable(symtable);
+
+        // Read the trace and create a client for every client in the trace
+        vector<UNIQUE_PTR<ReplayClient> > clients;
+        vector<bool> grouped;
+        MemoryTraceReader reader(flags.m_traceFile);
+        MemoryTraceRecord rec;
+        uint64_t nrequests = 0;
+        while (reader.Next(rec))
+        {
+            if (rec.client >= clients.size())
+            {
+                clients.resize(rec.client + 1);
+                grouped.resize(rec.client + 1, false);
+            }
+            if (!clients[rec.client])
+            {
+                clients[rec.client].reset(new ReplayClient("client" + to_string(rec.client), *root, clock, flags.m_policy, flags.m_window));
+            }
+
+            if (rec.kind == MemoryTraceRecord::CLIENT)
+            {
+                grouped[rec.client] = rec.grouped;
+            }
+            else
+            {
+                ReplayRequest req;
+                req.write   = (rec.kind == MemoryTraceRecord::WRITE);
+                req.cycle   = rec.cycle;
+                req.address = rec.address;
+                req.mask    = rec.mask;
+                clients[rec.client]->AddRequest(req);
+                ++nrequests;
+            }
+        }
+
+        for (size_t i = 0; i < clients.size(); ++i)
+        {
+            if (!clients[i])
+            {
+                clients[i].reset(new ReplayClient("client" + to_string(i), *root, clock, flags.m_policy, flags.m_window));
+            }
+            clients[i]->ConnectMemory(memory.get(), grouped[i]);
+        }
+        memory->Initialize();
+
+        // Convert the recorded cycles to the master cycles of this simulation
+        if (reader.GetFrequency() != 0)
+        {
+            for (auto& c : clients)
+                for (auto& req : c->GetRequests())
+                    req.cycle = ScaleCycles(req.cycle, reader.GetFrequency(), kernel.GetMasterFrequency());
+        }
+
+        clog << "Replaying " << nrequests << " requests from " << clients.size()
+             << " clients into memory: " << memory_type << endl;
+
+        ResourceUsage ru(true);
+        RunState state = kernel.Step(INFINITE_CYCLES);
+        ResourceUsage ru1(true);
+
+        bool done = true;
+        for (auto& c : clients)
+            done = done && c->IsDone();
+        if (state != STATE_IDLE || !done)
+        {
+            throw DeadlockException("Replay did not complete (at master cycle " + to_string(kernel.GetCycleNo()) + ")");
+        }
+
+        if (!flags.m_quiet)
+        {
+            uint64_t nreads = 0, nwrites = 0;
+            CycleNo  total_latency = 0, max_latency = 0;
+            for (auto& c : clients)
+            {
+                nreads        += c->m_nreads;
+                nwrites       += c->m_nwrites;
+                total_latency += c->m_totalLatency;
+                max_latency    = max(max_latency, c->m_maxLatency);
+            }
+
+            ResourceUsage ru2 = ru1 - ru;
+            clog << "### begin replay statistics" << endl
+                 << kernel.GetCycleNo() << "\t# master cycle counter" << endl
+                 << clock.GetCycleNo() << "\t# client cycle counter" << endl
+                 << nreads << "\t# number of replayed reads" << endl
+                 << nwrites << "\t# number of replayed writes" << endl
+                 << (nreads ? (double)total_latency / nreads : 0.) << "\t# average read latency (master cycles)" << endl
+                 << max_latency << "\t# maximum read latency (master cycles)" << endl
+                 << ru2.GetUserTime() << "\t# total real time in user mode (us)" << endl
+                 << ru2.GetSystemTime() << "\t# total real time in system mode (us)" << endl
+                 << "## memory statistics:" << endl;
+            PrintMemoryStatistics(*memory, clog);
+            clog << "### end replay statistics" << endl;
+        }
+
+        clients.clear();
+        memory.reset();
+        delete root;
+    }
+    catch (const exception& e)
+    {
+        PrintException(NULL, cerr, e);
+        return 1;
+    }
+    return 0;
+}
@@ -18,15 +18,18 @@ command_descriptor command_table[] =
     { { "help", 0 },                  0, 1,  cmd_help,       "help [COMMAND]",    "Print the help text for COMMAND, or this text if no command is specified." },
     { { "info", 0 },                  1, -1, cmd_info,       "info COMPONENT [ARGS...]",    "Show help/configuration/layout for COMPONENT." },
     { { "line", 0 },                  2, 2,  cmd_line,       "line COMPONENT ADDR", "Lookup the memory line at address ADDR in the memory system COMPONENT." },
+    { { "load", 0 },                  1, 1,  cmd_load,       "load FILE",         "Restore the simulation state from checkpoint FILE." },
     { { "lookup", 0 },                1, 1,  cmd_lookup,     "lookup ADDR",       "Look up the program symbol closest to address ADDR." },
     { { "quit", 0 },                  0, 0,  cmd_quit,       "quit",              "Exit the simulation." },
     { { "inspect", 0 },               1, -1, cmd_inspect,    "inspect NAME [ARGS...]", "Inspect NAME. See 'info NAME' for details." },
     { { "run", 0 },                   0, 0,  cmd_run,        "run",               "Run the system until it is idle or deadlocks. Livelocks will not be reported." },
+    { { "save", 0 },                  1, 1,  cmd_save,       "save FILE",         "Save the simulation state to checkpoint FILE." },
     { { "set", 0 },                   2, -1, cmd_set,        "set PAT VAL...",    "Set the variables matching PAT to the value VAL..." },
     { { "show", "vars", 0 },          0, 1,  cmd_show_vars,  "show vars [PAT]",   "List monitoring variables matching PAT." },
     { { "show", "syms", 0 },          0, 1,  cmd_show_syms,  "show syms [PAT]",   "List program symbols matching PAT." },
     { { "show", "components", 0 },    0, 2,  cmd_show_components, "show components [PAT] [LEVEL]",   "List components matching PAT (at most LEVELs)." },
     { { "show", "processes", 0 },     0, 1,  cmd_show_processes, "show processes [PAT]",   "List processes matching PAT." },
+    { { "show", "profile", 0 },       0, 1,  cmd_show_profile, "show profile [PAT]", "Show the host time profile of processes, arbitrators and storages matching PAT." },
     { { "show", "devicedb", 0 },      0, 0,  cmd_show_devdb, "show devicedb",     "List the I/O device identifier database." },
     { { "state", 0 },                 0, 0,  cmd_state,       "state",            "Show the state of the system. Idle components are left out." },
     { { "statistics", 0 },            0, 0,  cmd_stats,       "statistics",       "Print the current simulation statistics." },
@@ -5,7 +5,8 @@ namespace Simulator
     Arbitrator::Arbitrator(Clock& clock)
         : m_next(0),
           m_clock(clock),
-          m_activated(false)
+          m_activated(false),
+          m_profile()
     {}
 
     Arbitrator::~Arbitrator()
@@ -11,6 +11,10 @@ namespace Simulator
     void Arbitrator::RequestArbitration()
     {
         if (!m_activated) {
+            if (Kernel::IsParallelPhase()) {
+                Kernel::DeferArbitration(*this);
+                return;
+            }
             m_next = m_clock.ActivateArbitrator(*this);
             m_activated = true;
         }
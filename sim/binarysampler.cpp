@@ -1,6 +1,5 @@
 #include <sys_config.h>
 #include <algorithm> // sort
-#include <fnmatch.h> // fnmatch
 #include <ctime>     // time, gmtime, asctime
 #include <unistd.h>  // gethostname
 #include <sim/binarysampler.h>
@@ -11,31 +10,27 @@ using namespace std;
 namespace Simulator
 {
     BinarySampler::BinarySampler(const VariableRegistry& registry)
-        : m_datasize(0), m_vars(), m_registry(registry)
+        : m_batch(), m_registry(registry)
     {}
 
     void BinarySampler::SelectVariables(ostream& os, const Config& config,
                                         const vector<string>& pats)
     {
-        typedef pair<const string*,
-                     const VariableRegistry::VarInfo*> varsel_t;
-        typedef vector<varsel_t> varvec_t;
-        varvec_t vars;
+        typedef VariableRegistry::VarID VarID;
+        vector<VarID> vars;
 
         //
         // Select variables to sample
         //
         for (auto& i : pats)
-            for (auto& j : m_registry.GetRegistry())
-            {
-                if (FNM_NOMATCH == fnmatch(i.c_str(), j.first.c_str(), 0))
-                    continue;
-
-                if (j.second.type == Serialization::SV_OTHER)
-                    throw exceptf<>("Cannot monitor the non-scalar variable %s (selected by %s)", j.first.c_str(), i.c_str());
-
-                vars.push_back(make_pair(&j.first, &j.second));
-            }
+        {
+            size_t first = vars.size();
+            m_registry.FindVariables(vars, i);
+            for (size_t j = first; j < vars.size(); ++j)
+                if (m_registry.m_vars[vars[j]].type == Serialization::SV_OTHER)
+                    throw exceptf<>("Cannot monitor the non-scalar variable %s (selected by %s)",
+                                    m_registry.GetName(vars[j]).c_str(), i.c_str());
+        }
 
         if (vars.size() >= 2)
             // Sort: to increase cache locality in SampleVariables.
@@ -45,8 +40,8 @@ namespace Simulator
             // must be sampled once before and after everything else,
             // to evaluate how imprecise the measurement is.
             sort(vars.begin()+1, vars.end()-1,
-                 [](const varsel_t& left, const varsel_t& right) -> bool
-                 { return left.second->var < right.second->var; });
+                 [this](VarID left, VarID right) -> bool
+                 { return m_registry.m_vars[left].var < m_registry.m_vars[right].var; });
 
         //
         // Generate header for output file
@@ -66,16 +61,12 @@ namespace Simulator
         for (auto& i : rawconf)
             os << i.first << " = " << i.second << endl;
 
-        m_datasize = 0;
-        m_vars.clear();
+        m_batch.Clear();
+        m_registry.AddToBatch(m_batch, vars);
         os << "# varinfo: " << vars.size() << endl;
-        for (auto& i : vars)
-        {
-            m_datasize += i.second->width;
-            m_vars.push_back(make_pair((const char*)i.second->var, i.second->width));
-            m_registry.ListVariables_onevar(os, *i.first, *i.second);
-        }
-        os << "# recwidth: " << m_datasize << endl;
+        for (auto i : vars)
+            m_registry.ListVariables_onevar(os, m_registry.GetName(i), m_registry.m_vars[i]);
+        os << "# recwidth: " << m_batch.GetSize() << endl;
     }
 
 }
@@ -7,22 +7,18 @@
 #include <vector>
 #include <utility>
 #include <cstddef>
+#include <sim/sampling.h>
 
 class Config;
 
 namespace Simulator
 {
-    class VariableRegistry;
-
     // BinarySampler: used by Monitor to quickly serialize scalar
     // variables to a binary format.
     class BinarySampler
     {
     private:
-        typedef std::vector<std::pair<const char*, size_t> > vars_t;
-
-        size_t   m_datasize;          ///< The record size in bytes
-        vars_t   m_vars;              ///< The variables to sample
+        SampleBatch m_batch;          ///< The variables to sample
 
         const VariableRegistry& m_registry; ///< The related registry
 
@@ -37,14 +33,9 @@ namespace Simulator
                              const std::vector<std::string>& pats);
 
         // Perform the sampling
-        void SampleToBuffer(char *buf) const
-        {
-            for (auto& i : m_vars)
-                for (size_t j = 0; j < i.second; ++j)
-                    *buf++ = i.first[j];
-        }
-
-        size_t GetBufferSize() const { return m_datasize; }
+        void SampleToBuffer(char *buf) const { m_batch.CopyTo(buf); }
+
+        size_t GetBufferSize() const { return m_batch.GetSize(); }
 
     };
 
@@ -219,6 +219,7 @@ void BreakPointManager::CheckMore(int type, MemAddr addr, Object& obj)
         else
         {
             ActiveBreak ab(addr, obj, i->second.type & type);
+            std::lock_guard<std::mutex> lock(m_activeLock);
             m_activebreaks.insert(ab);
             GetKernel()->Stop();
         }
@@ -7,6 +7,7 @@
 #include <sim/except.h>
 
 #include <map>
+#include <mutex>
 #include <string>
 #include <iostream>
 
@@ -55,6 +56,7 @@ private:
 
     breakpoints_t      m_breakpoints;
     active_breaks_t    m_activebreaks;
+    std::mutex         m_activeLock;  ///< Breaks are hit by processes that the parallel kernel runs concurrently.
 #ifndef STATIC_KERNEL
     Kernel*            m_kernel;
 #endif
@@ -74,7 +76,7 @@ private:
 
 public:
     BreakPointManager(SymbolTable* symtable = 0)
-        : m_breakpoints(), m_activebreaks(),
+        : m_breakpoints(), m_activebreaks(), m_activeLock(),
 #ifndef STATIC_KERNEL
         m_kernel(0), 
 #endif
@@ -82,7 +84,7 @@ public:
         m_counter(0), m_enabled(false) {}
 
     BreakPointManager(const BreakPointManager& other)
-        : m_breakpoints(other.m_breakpoints), m_activebreaks(other.m_activebreaks),
+        : m_breakpoints(other.m_breakpoints), m_activebreaks(other.m_activebreaks), m_activeLock(),
 #ifndef STATIC_KERNEL
         m_kernel(other.m_kernel), 
 #endif
@@ -6,13 +6,14 @@ namespace Simulator
 #ifndef STATIC_KERNEL
           kernel
 #endif
-          , Frequency frequency, Period period)
+          , Frequency frequency, Period period, size_t index)
         :
 #ifndef STATIC_KERNEL
         m_kernel(kernel),
 #endif
         m_frequency(frequency),
         m_period(period),
+        m_index(index),
         m_next(NULL),
         m_cycle(0),
         m_activeProcesses(NULL),
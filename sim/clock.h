@@ -7,6 +7,7 @@
 #endif
 
 #include <cstdint>
+#include <cstddef>
 
 namespace Simulator
 {
@@ -47,7 +48,8 @@ namespace Simulator
 #endif
         Frequency     m_frequency;   ///< Frequency of this clock, in MHz
         Period        m_period;      ///< No. master-cycles per tick of this clock.
-        Clock*        m_next;        ///< Next clock to run
+        size_t        m_index;       ///< Rank in creation order, orders clocks that tick in the same cycle
+        Clock*        m_next;        ///< Next active clock, see Kernel::GetActiveClocks()
         CycleNo       m_cycle;       ///< Next cycle this clock needs to run
 
         Process*      m_activeProcesses;   ///< List of processes that need to be run.
@@ -65,8 +67,9 @@ namespace Simulator
         // to compute the relative rate of different clocks. In practice,
         // some unit is assumed for concrete architecture models, eg. MHz.
         // The 3rd argument (period) is the number of master ticks per
-        // tick of this clock.
-        Clock(Kernel&, Frequency frequency, Period period);
+        // tick of this clock. The 4th argument (index) is the rank of
+        // this clock in creation order.
+        Clock(Kernel&, Frequency frequency, Period period, size_t index);
 
     public:
 #ifdef STATIC_KERNEL
@@ -85,6 +88,9 @@ namespace Simulator
 
         CycleNo GetNextTick() const { return m_cycle; }
 
+        /// Returns the rank of this clock in creation order
+        size_t GetIndex() const { return m_index; }
+
         /// Returns the cycle counter for this clock
         CycleNo GetCycleNo() const;
 
@@ -42,6 +42,12 @@ namespace Simulator
     inline
     void Clock::ActivateProcess(Process& process)
     {
+        if (Kernel::IsParallelPhase())
+        {
+            Kernel::DeferProcessActivation(this, process);
+            return;
+        }
+
         if (++process.m_activations == 1)
         {
             // First time this process has been activated, queue it
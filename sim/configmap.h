@@ -27,6 +27,10 @@ public:
     // canonicalize pattern matches.
     void append(const std::string& key, const std::string& value);
 
+    // Number of entries, and entry by position in order of appending
+    size_t size() const { return m_map.size(); }
+    const std::pair<std::string, std::string>& operator[](size_t i) const { return m_map[i]; }
+
     // Forward iterators
     map_t::const_iterator begin() const { return m_map.begin(); }
     map_t::const_iterator end() const { return m_map.end(); }
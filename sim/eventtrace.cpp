@@ -0,0 +1,217 @@
+#include "sim/eventtrace.h"
+#include "sim/kernel.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fnmatch.h>
+
+using namespace std;
+
+namespace Simulator
+{
+    static const char     EventTraceMagic[4] = { 'M', 'G', 'E', 'T' };
+    static const uint32_t EventTraceVersion  = 1;
+
+    // Identifies the buffers of the current opening of a trace, so
+    // that threads notice when their buffer is stale.
+    static atomic<uint64_t>     g_generation(0);
+    static thread_local void*   t_buffer     = NULL;
+    static thread_local uint64_t t_generation = 0;
+
+    //
+    // TraceEventType
+    //
+    vector<const TraceEventType*>& TraceEventType::GetTypes()
+    {
+        static vector<const TraceEventType*> types(1, NULL);
+        return types;
+    }
+
+    TraceEventType::TraceEventType(const char* name, initializer_list<const char*> fields)
+        : m_id(0), m_name(name), m_fields(fields.begin(), fields.end())
+    {
+        assert(m_fields.size() <= 3);
+        auto& types = GetTypes();
+        m_id = (uint16_t)types.size();
+        types.push_back(this);
+    }
+
+    //
+    // EventTrace
+    //
+    EventTrace::EventTrace()
+        : m_file(NULL),
+          m_enabled(),
+          m_bufferSize(0),
+          m_buffers(),
+          m_ids(),
+          m_generation(0),
+          m_numRecords(0),
+          m_lock()
+    {
+    }
+
+    EventTrace::~EventTrace()
+    {
+        Close();
+    }
+
+    static void PutString(FILE* f, const string& s)
+    {
+        uint8_t len = (uint8_t)min<size_t>(s.size(), 255);
+        fwrite(&len, 1, 1, f);
+        fwrite(s.data(), 1, len, f);
+    }
+
+    void EventTrace::Open(const string& filename, const vector<string>& patterns, size_t bufferSize)
+    {
+        Close();
+
+        m_file = fopen(filename.c_str(), "wb");
+        if (m_file == NULL)
+        {
+            throw InvalidArgumentException("Unable to open event trace file: " + filename + ": " + strerror(errno));
+        }
+
+        const auto& types = TraceEventType::GetTypes();
+        const uint32_t header[3] = { EventTraceVersion, (uint32_t)sizeof(EventRecord), (uint32_t)types.size() - 1 };
+        fwrite(EventTraceMagic, sizeof EventTraceMagic, 1, m_file);
+        fwrite(header, sizeof header, 1, m_file);
+
+        m_enabled.assign(types.size(), false);
+        for (size_t i = 1; i < types.size(); ++i)
+        {
+            const TraceEventType& type = *types[i];
+            const uint16_t id = type.GetId();
+            const uint8_t  nfields = (uint8_t)type.GetFields().size();
+            fwrite(&id, sizeof id, 1, m_file);
+            PutString(m_file, type.GetName());
+            fwrite(&nfields, 1, 1, m_file);
+            for (auto& f : type.GetFields())
+                PutString(m_file, f);
+
+            for (auto& pat : patterns)
+            {
+                if (fnmatch(pat.c_str(), type.GetName().c_str(), 0) == 0)
+                {
+                    m_enabled[i] = true;
+                    break;
+                }
+            }
+        }
+
+        m_bufferSize = max<size_t>(bufferSize, 1);
+        m_generation = ++g_generation;
+        m_numRecords = 0;
+    }
+
+    void EventTrace::Close()
+    {
+        if (m_file == NULL)
+        {
+            return;
+        }
+
+        for (auto buf : m_buffers)
+        {
+            Flush(*buf);
+            delete buf;
+        }
+        m_buffers.clear();
+        m_ids.clear();
+        m_enabled.clear();
+
+        fclose(m_file);
+        m_file = NULL;
+    }
+
+    EventTrace::ThreadBuffer& EventTrace::GetBuffer()
+    {
+        if (t_generation != m_generation)
+        {
+            // First event of this thread since the trace was opened
+            ThreadBuffer* buf = new ThreadBuffer(m_bufferSize);
+            {
+                lock_guard<mutex> guard(m_lock);
+                m_buffers.push_back(buf);
+            }
+            t_buffer     = buf;
+            t_generation = m_generation;
+        }
+        return *static_cast<ThreadBuffer*>(t_buffer);
+    }
+
+    void EventTrace::Flush(ThreadBuffer& buf)
+    {
+        lock_guard<mutex> guard(m_lock);
+        fwrite(&buf.records[0], sizeof(EventRecord), buf.count, m_file);
+        m_numRecords += buf.count;
+        buf.count = 0;
+    }
+
+    void EventTrace::Append(ThreadBuffer& buf, const EventRecord& rec)
+    {
+        buf.records[buf.count++] = rec;
+        if (buf.count == buf.records.size())
+        {
+            Flush(buf);
+        }
+    }
+
+    uint32_t EventTrace::GetComponentId(ThreadBuffer& buf, const Object& obj, uint64_t cycle)
+    {
+        auto p = buf.ids.find(&obj);
+        if (p != buf.ids.end())
+        {
+            return p->second;
+        }
+
+        uint32_t id;
+        bool     named;
+        {
+            lock_guard<mutex> guard(m_lock);
+            auto q = m_ids.find(&obj);
+            named = (q != m_ids.end());
+            id = named ? q->second : (uint32_t)m_ids.size();
+            if (!named)
+            {
+                m_ids[&obj] = id;
+            }
+        }
+
+        if (!named)
+        {
+            // Name the component before its first event
+            const string& name = obj.GetName();
+            EventRecord rec;
+            rec.cycle     = cycle;
+            rec.component = id;
+            rec.event     = TraceEventType::NAME;
+            for (size_t ofs = 0; ofs == 0 || ofs < name.size(); ofs += sizeof rec.payload)
+            {
+                memset(rec.payload, 0, sizeof rec.payload);
+                name.copy((char*)rec.payload, sizeof rec.payload, ofs);
+                rec.info = (uint16_t)ofs;
+                Append(buf, rec);
+            }
+        }
+        buf.ids[&obj] = id;
+        return id;
+    }
+
+    void EventTrace::Write(const Object& obj, const TraceEventType& type, uint64_t a, uint64_t b, uint64_t c)
+    {
+        ThreadBuffer& buf = GetBuffer();
+
+        EventRecord rec;
+        rec.cycle      = obj.GetKernel()->GetCycleNo();
+        rec.component  = GetComponentId(buf, obj, rec.cycle);
+        rec.event      = type.GetId();
+        rec.info       = 0;
+        rec.payload[0] = a;
+        rec.payload[1] = b;
+        rec.payload[2] = c;
+        Append(buf, rec);
+    }
+}
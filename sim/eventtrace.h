@@ -0,0 +1,140 @@
+// -*- c++ -*-
+#ifndef SIM_EVENTTRACE_H
+#define SIM_EVENTTRACE_H
+
+#include <sim/types.h>
+
+#include <cstdio>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Simulator
+{
+    class Object;
+
+    /*
+      Binary event traces.
+
+      Components record typed events with TraceEvent() instead of
+      formatting text. Each event is a fixed-size EventRecord with the
+      master cycle, the ID of the component, the event type and up to
+      three payload words. Records are collected in a buffer per host
+      thread and written to the trace file when the buffer is full,
+      so the order of the records in the file is only by cycle within
+      each buffer; the decoder (tools/readevents) sorts them.
+
+      The file starts with a header:
+      - magic "MGET", then the version, the record size and the number
+        of event types as 32-bit words;
+      - for each event type: its ID (16 bits), its name and the number
+        of payload fields (8 bits), then the name of each field. Names
+        are a length byte followed by the characters.
+
+      The records follow. Component IDs are assigned on the first event
+      of each component, which is preceded by NAME records
+      (event ID 0) holding the component name: 'component' is the ID
+      being named, 'info' the offset of the chunk in the name and the
+      payload holds up to 24 characters of it.
+
+      All values are in host byte order.
+    */
+
+    struct EventRecord
+    {
+        uint64_t cycle;         ///< Master cycle of the event
+        uint32_t component;     ///< ID of the component
+        uint16_t event;         ///< ID of the event type
+        uint16_t info;          ///< For NAME records: offset in the name
+        uint64_t payload[3];    ///< Event fields
+    };
+
+    // An event type. Types are defined as static objects by the
+    // components that record them.
+    class TraceEventType
+    {
+        uint16_t                 m_id;
+        std::string              m_name;
+        std::vector<std::string> m_fields;
+
+    public:
+        static const uint16_t NAME = 0;     ///< ID of the component name records
+
+        TraceEventType(const char* name, std::initializer_list<const char*> fields);
+        TraceEventType(const TraceEventType&) = delete;
+        TraceEventType& operator=(const TraceEventType&) = delete;
+
+        uint16_t GetId() const { return m_id; }
+        const std::string& GetName() const { return m_name; }
+        const std::vector<std::string>& GetFields() const { return m_fields; }
+
+        // All event types, by ID (the first entry is NULL)
+        static std::vector<const TraceEventType*>& GetTypes();
+    };
+
+    class EventTrace
+    {
+        // Records of a host thread, written out when full
+        struct ThreadBuffer
+        {
+            std::vector<EventRecord> records;
+            size_t                   count;
+            std::unordered_map<const Object*, uint32_t> ids; ///< Cache of the component IDs
+
+            explicit ThreadBuffer(size_t size) : records(size), count(0), ids() {}
+        };
+
+        FILE*                     m_file;
+        std::vector<char>         m_enabled;    ///< Per event type ID
+        size_t                    m_bufferSize; ///< Number of records per thread buffer
+        std::vector<ThreadBuffer*> m_buffers;
+        std::unordered_map<const Object*, uint32_t> m_ids;
+        uint64_t                  m_generation; ///< Identifies the buffers of this opening
+        uint64_t                  m_numRecords;
+        std::mutex                m_lock;       ///< Protects the file, the buffer list and the IDs
+
+        ThreadBuffer& GetBuffer();
+        uint32_t GetComponentId(ThreadBuffer& buf, const Object& obj, uint64_t cycle);
+        void Append(ThreadBuffer& buf, const EventRecord& rec);
+        void Flush(ThreadBuffer& buf);
+
+    public:
+        EventTrace();
+        ~EventTrace();
+        EventTrace(const EventTrace&) = delete;
+        EventTrace& operator=(const EventTrace&) = delete;
+
+        // Starts tracing the event types whose name matches one of the
+        // patterns into the given file. Throws if it cannot be created.
+        void Open(const std::string& filename, const std::vector<std::string>& patterns, size_t bufferSize);
+
+        // Writes out all buffered records and closes the file.
+        void Close();
+
+        bool IsOpen() const { return m_file != NULL; }
+        uint64_t GetNumRecords() const { return m_numRecords; }
+
+        bool IsEnabled(const TraceEventType& type) const
+        {
+            return type.GetId() < m_enabled.size() && m_enabled[type.GetId()];
+        }
+
+        void Write(const Object& obj, const TraceEventType& type, uint64_t a = 0, uint64_t b = 0, uint64_t c = 0);
+    };
+
+/**
+ * void TraceEvent(const TraceEventType& type, ...);
+ *
+ * For use in Object instances. Records an event with up to three
+ * payload words in the commit phase, if the event type is traced.
+ */
+#define TraceEvent(Type, ...) do {                                      \
+        COMMIT if (GetKernel()->GetEventTrace().IsEnabled(Type))        \
+            GetKernel()->GetEventTrace().Write(*this, (Type), ##__VA_ARGS__); \
+    } while (false)
+
+}
+
+#endif
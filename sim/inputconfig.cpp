@@ -1,7 +1,7 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
-#include <fnmatch.h>
+#include <chrono>
 #include "sim/inputconfig.h"
 
 using namespace std;
@@ -32,45 +32,50 @@ string InputConfigRegistry::lookupValue<string>(const string& name, const string
     return val;
 }
 
+void InputConfigRegistry::updateIndex()
+{
+    if (m_indexedData == m_data.size() && m_indexedOverrides == m_overrides.size())
+        return;
+
+    // The overrides have priority over the data, and later
+    // entries over earlier ones.
+    m_index.clear();
+    for (auto& c : m_data)
+        m_index.add(c.first);
+    for (auto& o : m_overrides)
+        m_index.add(o.first);
+    m_indexedData = m_data.size();
+    m_indexedOverrides = m_overrides.size();
+}
+
 bool InputConfigRegistry::lookup(const string& name_, string& result, const string &def, bool allow_default)
 {
     string name(name_);
     string pat;
     transform(name.begin(), name.end(), name.begin(), ::tolower);
 
+    ++m_numLookups;
     auto p = m_cache.find(name);
     if (p != m_cache.end())
     {
+        ++m_numCacheHits;
         result = p->second.first;
         return true;
     }
 
-    bool found = false;
-    for (auto& o : m_overrides.reverse())
-    {
-        pat = o.first;
-        if (FNM_NOMATCH != fnmatch(pat.c_str(), name.c_str(), 0))
-        {
-            // Return the overriden value
-            result = o.second;
-            found = true;
-            break;
-        }
-    }
+    auto start = chrono::steady_clock::now();
+    updateIndex();
+    size_t i = m_index.find(name);
+    m_lookupTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    if (!found)
+    bool found = false;
+    if (i != PatternIndex::npos)
     {
-        for (auto& c : m_data.reverse())
-        {
-            pat = c.first;
-            if (FNM_NOMATCH != fnmatch(pat.c_str(), name.c_str(), 0))
-            {
-                // Return the configuration value
-                result = c.second;
-                found = true;
-                break;
-            }
-        }
+        // Return the overriden or configuration value
+        auto& c = (i < m_data.size()) ? m_data[i] : m_overrides[i - m_data.size()];
+        pat = c.first;
+        result = c.second;
+        found = true;
     }
     if (!found && allow_default)
     {
@@ -119,6 +124,14 @@ void InputConfigRegistry::dumpConfigurationCache(ostream& os) const
     os << "### end simulator configuration (lookup matches)" << endl;
 }
 
+void InputConfigRegistry::dumpLookupStatistics(ostream& os) const
+{
+    os << m_numLookups << " configuration lookups, "
+       << m_numCacheHits << " cached, "
+       << m_data.size() + m_overrides.size() << " patterns, "
+       << (long long)(m_lookupTime * 1000000) << " us matching";
+}
+
 vector<string> InputConfigRegistry::getWordList(const string& name)
 {
     vector<string> vals;
@@ -142,6 +155,8 @@ vector<string> InputConfigRegistry::getWordList(const string& name)
 }
 
 InputConfigRegistry::InputConfigRegistry(const ConfigMap& defaults, const ConfigMap& overrides)
-    : m_data(defaults), m_overrides(overrides), m_cache()
+    : m_data(defaults), m_overrides(overrides), m_cache(),
+      m_index(), m_indexedData(0), m_indexedOverrides(0),
+      m_numLookups(0), m_numCacheHits(0), m_lookupTime(0)
 {
 }
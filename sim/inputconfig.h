@@ -6,6 +6,7 @@
 #include "sim/convertval.h"
 #include "sim/except.h"
 #include "sim/kernel.h"
+#include "sim/patternindex.h"
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -14,7 +15,7 @@
 class InputConfigRegistry
 {
     // Main configuration data, typically loaded from file(s).  This
-    // is matched from front to back: the first pattern that matches
+    // is matched from back to front: the last pattern that matches
     // determines the value.
     ConfigMap         m_data;
 
@@ -28,6 +29,19 @@ class InputConfigRegistry
     typedef std::unordered_map<std::string, std::pair<std::string, std::string> > ConfigCache;
     ConfigCache              m_cache;
 
+    // Index of the patterns of m_data then m_overrides, in order of
+    // priority. It is rebuilt when entries are appended to either.
+    PatternIndex             m_index;
+    size_t                   m_indexedData;
+    size_t                   m_indexedOverrides;
+
+    // Lookup statistics, for the startup report.
+    size_t                   m_numLookups;    ///< Lookups, including indirections
+    size_t                   m_numCacheHits;  ///< Lookups answered by the cache
+    double                   m_lookupTime;    ///< Seconds spent matching patterns
+
+    void updateIndex();
+
 public:
     /// Constructor, destructor etc.
     InputConfigRegistry(const ConfigMap& data, const ConfigMap& overrides);
@@ -45,6 +59,10 @@ public:
     /// Emit the configuration cache.
     void dumpConfigurationCache(std::ostream& os) const;
 
+    /// Emit the number of lookups and the time spent matching
+    // patterns.
+    void dumpLookupStatistics(std::ostream& os) const;
+
     /// getRawConfiguration: serialize the effective configuration.
     //
     // This emits a key-value vector that corresponds to the names and
@@ -1,13 +1,17 @@
 #include "kernel.h"
 #include "storage.h"
 #include "sampling.h"
+#include "workerpool.h"
 #include <arch/dev/Display.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <functional>
+#include <thread>
 
 using namespace std;
 
@@ -18,6 +22,13 @@ namespace Simulator
     Kernel* Kernel::g_kernel = 0;
 #endif
 
+    thread_local Clock*             Kernel::t_clock     = NULL;
+    thread_local Process*           Kernel::t_process   = NULL;
+    thread_local CyclePhase         Kernel::t_phase     = PHASE_COMMIT;
+    thread_local Kernel::Worker*    Kernel::t_worker    = NULL;
+
+    const size_t Kernel::NO_TASK;
+
     void Kernel::Abort()
     {
         m_aborted = true;
@@ -98,10 +109,60 @@ namespace Simulator
         }
         assert(m_master_freq % frequency == 0);
 
-        m_clocks.push_back(new Clock(*this, frequency, m_master_freq / frequency));
+        m_clocks.push_back(new Clock(*this, frequency, m_master_freq / frequency, m_clocks.size()));
         return *m_clocks.back();
     }
 
+    inline Result Kernel::InvokeProcess(Process& process)
+    {
+        if (!m_profiling)
+        {
+            return process.m_delegate();
+        }
+        const HostTicks start = ReadHostTicks();
+        const Result result = process.m_delegate();
+        process.m_profile.Add(ReadHostTicks() - start);
+        return result;
+    }
+
+    inline void Kernel::Arbitrate(Arbitrator& arbitrator)
+    {
+        if (!m_profiling)
+        {
+            arbitrator.OnArbitrate();
+        }
+        else
+        {
+            if (arbitrator.m_profile.calls == 0)
+            {
+                m_profiledArbitrators.push_back(&arbitrator);
+            }
+            const HostTicks start = ReadHostTicks();
+            arbitrator.OnArbitrate();
+            arbitrator.m_profile.Add(ReadHostTicks() - start);
+        }
+        arbitrator.Deactivate();
+    }
+
+    inline void Kernel::UpdateStorage(Storage& storage)
+    {
+        if (!m_profiling)
+        {
+            storage.Update();
+        }
+        else
+        {
+            if (storage.m_profile.calls == 0)
+            {
+                m_profiledStorages.push_back(&storage);
+            }
+            const HostTicks start = ReadHostTicks();
+            storage.Update();
+            storage.m_profile.Add(ReadHostTicks() - start);
+        }
+        storage.Deactivate();
+    }
+
     RunState Kernel::Step(CycleNo cycles)
     {
         try
@@ -118,10 +179,10 @@ namespace Simulator
             }
 
             // Advance time to the first clock to run.
-            if (m_activeClocks != NULL)
+            if (m_running.empty() && !m_schedule.empty())
             {
-                assert(m_activeClocks->m_cycle >= m_cycle);
-                m_cycle = m_activeClocks->m_cycle;
+                assert(m_schedule.front()->m_cycle >= m_cycle);
+                m_cycle = m_schedule.front()->m_cycle;
             }
 
             m_aborted = m_suspended = false;
@@ -131,88 +192,72 @@ namespace Simulator
                 // We start each cycle being idle, and see if we did something this cycle
                 idle = true;
 
-                //
-                // Acquire phase
-                //
-                m_phase = PHASE_ACQUIRE;
-                for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
+                StartCycle();
+
+                if (m_workers != NULL && m_parallel)
+                {
+                    idle = RunParallelCycle();
+                }
+                else
                 {
-                    m_clock = clock;
-                    for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
+                    //
+                    // Acquire phase
+                    //
+                    t_phase = PHASE_ACQUIRE;
+                    for (Clock* clock : m_running)
                     {
-                        m_process   = process;
-
-                        // This process begins the cycle
-                        // This is a purely administrative function and has no simulation effect.
-                        process->OnBeginCycle();
-
-                        // If we fail in the acquire stage, don't bother with the check and commit stages
-                        Result result = process->m_delegate();
-                        if (result == SUCCESS)
+                        t_clock = clock;
+                        for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
                         {
-                            process->m_state = STATE_RUNNING;
-                        }
-                        else
-                        {
-                            assert(result == FAILED);
-                            process->m_state = STATE_DEADLOCK;
-                            ++process->m_stalls;
+                            t_process = process;
+                            try
+                            {
+                                AcquireProcess(*process);
+                            }
+                            catch (ProgramTerminationException&)
+                            {
+                                RecordTermination(*process, std::current_exception());
+                            }
                         }
                     }
-                }
 
-                //
-                // Arbitrate phase
-                //
-                for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
-                {
-                    m_clock = clock;
-                    for (Arbitrator* arbitrator = clock->m_activeArbitrators; arbitrator != NULL; arbitrator = arbitrator->GetNext())
+                    //
+                    // Arbitrate phase
+                    //
+                    for (Clock* clock : m_running)
                     {
-                        arbitrator->OnArbitrate();
-                        arbitrator->Deactivate();
+                        t_clock = clock;
+                        for (Arbitrator* arbitrator = clock->m_activeArbitrators; arbitrator != NULL; arbitrator = arbitrator->GetNext())
+                        {
+                            Arbitrate(*arbitrator);
+                        }
+                        clock->m_activeArbitrators = NULL;
                     }
-                    clock->m_activeArbitrators = NULL;
-                }
 
-                //
-                // Commit phase
-                //
-                for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
-                {
-                    m_clock = clock;
-                    for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
+                    //
+                    // Commit phase
+                    //
+                    for (Clock* clock : m_running)
                     {
-                        if (process->m_state != STATE_DEADLOCK)
+                        t_clock = clock;
+                        for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
                         {
-                            m_process   = process;
-                            m_phase     = PHASE_CHECK;
-
-                            Result result = process->m_delegate();
-                            if (result == SUCCESS)
+                            if (process->m_state != STATE_DEADLOCK)
                             {
-                                // This process is done this cycle.
-                                // This is a purely administrative function and has no simulation effect.
-                                // We call this before the COMMIT phase, so that if this produces an error,
-                                // we can still inspect the state that caused it.
-                                process->OnEndCycle();
-
-                                m_phase = PHASE_COMMIT;
-                                result = process->m_delegate();
-
-                                // If the CHECK succeeded, the COMMIT cannot fail
-                                assert(result == SUCCESS);
-                                process->m_state = STATE_RUNNING;
-
-                                // We've done something -- we're not idle
-                                idle = false;
-                            }
-                            else
-                            {
-                                // If a process has nothing to do (DELAYED) it shouldn't have been
-                                // called in the first place.
-                                assert(result == FAILED);
-                                process->m_state = STATE_DEADLOCK;
+                                t_process = process;
+                                try
+                                {
+                                    if (CommitProcess(*process))
+                                    {
+                                        // We've done something -- we're not idle
+                                        idle = false;
+                                    }
+                                }
+                                catch (ProgramTerminationException&)
+                                {
+                                    RecordTermination(*process, std::current_exception());
+                                    idle = false;
+                                }
                             }
                         }
                     }
@@ -231,46 +276,41 @@ namespace Simulator
                 {
                     // We haven't done anything this cycle. Check if there are clocks scheduled
                     // for cycles in the future. If so, we want to still advance the simulation.
-                    for (Clock* clock = m_activeClocks; clock != NULL; clock = clock->m_next)
-                    {
-                        if (clock->m_cycle > m_cycle)
-                        {
-                            idle = false;
-                            break;
-                        }
-                    }
+                    // The clocks of this cycle are not on the schedule while they run.
+                    idle = m_schedule.empty();
                 }
 
                 auto dm = DisplayManager::GetManager();
                 if (dm) dm->OnCycle(m_cycle);
 
-                if (!idle)
+                if (m_observer != NULL && m_cycle >= m_nextObservation)
                 {
-                    // Advance the simulation
-
-                    // Update the clocks
-                    for (Clock *next, *clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = next)
-                    {
-                        next = clock->m_next;
-
-                        // We ran this clock, remove it from the queue
-                        m_activeClocks = clock->m_next;
-                        clock->m_activated = false;
+                    m_observer->OnCycle(m_cycle);
+                    m_nextObservation = (m_cycle / m_observerPeriod + 1) * m_observerPeriod;
+                }
 
-                        assert(clock->m_activeArbitrators == NULL);
+                if (m_termination)
+                {
+                    // The program requested to terminate during this
+                    // cycle, which has now completed. Report it from
+                    // the process that requested it.
+                    std::exception_ptr e = m_termination;
+                    m_termination = nullptr;
+                    EndCycle();
+                    t_process = m_terminator;
+                    std::rethrow_exception(e);
+                }
 
-                        if (clock->m_activeProcesses != NULL || clock->m_activeStorages != NULL)
-                        {
-                            // This clock still has active components, reschedule it
-                            ActivateClock(*clock);
-                        }
-                    }
+                if (!idle)
+                {
+                    // Advance the simulation
+                    EndCycle();
 
                     // Advance time to first clock to run
-                    if (m_activeClocks != NULL)
+                    if (!m_schedule.empty())
                     {
-                        assert(m_activeClocks->m_cycle > m_cycle);
-                        m_cycle = m_activeClocks->m_cycle;
+                        assert(m_schedule.front()->m_cycle > m_cycle);
+                        m_cycle = m_schedule.front()->m_cycle;
                     }
                 }
             }
@@ -289,15 +329,399 @@ namespace Simulator
         }
         catch (SimulationException& e)
         {
+            m_termination = nullptr;
+
             // Add information about what component/state we were executing
             stringstream details;
-            details << "While executing process " << m_process->GetName() << endl
+            details << "While executing process " << t_process->GetName() << endl
                     << "At master cycle " << m_cycle << endl;
             e.AddDetails(details.str());
             throw;
         }
     }
 
+    void Kernel::AcquireProcess(Process& process)
+    {
+        // This process begins the cycle
+        // This is a purely administrative function and has no simulation effect.
+        process.OnBeginCycle();
+
+        // If we fail in the acquire stage, don't bother with the check and commit stages
+        Result result = InvokeProcess(process);
+        if (result == SUCCESS)
+        {
+            process.m_state = STATE_RUNNING;
+        }
+        else
+        {
+            assert(result == FAILED);
+            process.m_state = STATE_DEADLOCK;
+            ++process.m_stalls;
+        }
+    }
+
+    bool Kernel::CommitProcess(Process& process)
+    {
+        t_phase = PHASE_CHECK;
+        Result result = InvokeProcess(process);
+        if (result == SUCCESS)
+        {
+            // This process is done this cycle.
+            // This is a purely administrative function and has no simulation effect.
+            // We call this before the COMMIT phase, so that if this produces an error,
+            // we can still inspect the state that caused it.
+            process.OnEndCycle();
+
+            t_phase = PHASE_COMMIT;
+            result = InvokeProcess(process);
+
+            // If the CHECK succeeded, the COMMIT cannot fail
+            assert(result == SUCCESS);
+            process.m_state = STATE_RUNNING;
+            return true;
+        }
+
+        // If a process has nothing to do (DELAYED) it shouldn't have been
+        // called in the first place.
+        assert(result == FAILED);
+        process.m_state = STATE_DEADLOCK;
+        return false;
+    }
+
+    void Kernel::RecordTermination(Process& process, std::exception_ptr e)
+    {
+        // The first request in the order of the serial kernel wins.
+        if (!m_termination)
+        {
+            m_termination = e;
+            m_terminator  = &process;
+        }
+    }
+
+    bool Kernel::RunParallelCycle()
+    {
+        if (m_domainsChanged)
+        {
+            ComputeDomains();
+        }
+
+        //
+        // Acquire phase
+        //
+        RunParallelPhase(PHASE_ACQUIRE);
+
+        //
+        // Arbitrate phase
+        //
+        // Arbitration remains serial, as arbitrators are shared
+        // between partitions.
+        t_phase = PHASE_ACQUIRE;
+        for (Clock* clock : m_running)
+        {
+            t_clock = clock;
+            for (Arbitrator* arbitrator = clock->m_activeArbitrators; arbitrator != NULL; arbitrator = arbitrator->GetNext())
+            {
+                Arbitrate(*arbitrator);
+            }
+            clock->m_activeArbitrators = NULL;
+        }
+
+        //
+        // Commit phase
+        //
+        bool idle = RunParallelPhase(PHASE_COMMIT);
+        if (!m_tasks.empty())
+        {
+            // Leave the phase of the last process, as the serial kernel does
+            t_phase = m_tasks.back().committed ? PHASE_COMMIT : PHASE_CHECK;
+        }
+        return idle;
+    }
+
+    bool Kernel::RunParallelPhase(CyclePhase phase)
+    {
+        // Number the processes to run in the order of the serial kernel.
+        // The acquire phase may have activated processes, so the tasks
+        // are listed again for each phase.
+        m_tasks.clear();
+        for (Clock* clock : m_running)
+        {
+            for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
+            {
+                if (phase == PHASE_ACQUIRE || process->m_state != STATE_DEADLOCK)
+                {
+                    m_tasks.push_back({clock, process, 0, NO_TASK, 0, 0, false, false, nullptr});
+                }
+            }
+        }
+
+        // Order the tasks, unless the same processes ran in the last such phase
+        TaskGraph& graph = m_taskGraphs[(phase == PHASE_ACQUIRE) ? 0 : 1];
+        if (graph.processes.size() != m_tasks.size() ||
+            !equal(m_tasks.begin(), m_tasks.end(), graph.processes.begin(),
+                   [](const Task& task, const Process* process) { return task.process == process; }))
+        {
+            BuildTaskGraph(graph);
+        }
+        m_taskGraph = &graph;
+
+        // The tasks that can run at once, in increasing order, form a heap
+        m_taskReady.clear();
+        for (size_t i = 0; i < m_tasks.size(); ++i)
+        {
+            m_tasks[i].waiting = graph.waiting[i];
+            if (graph.waiting[i] == 0)
+            {
+                m_taskReady.push_back(i);
+            }
+        }
+        m_tasksLeft  = m_tasks.size();
+        m_taskFailed = false;
+        m_taskPhase  = phase;
+
+        if (!m_tasks.empty())
+        {
+            m_workers->Run(&Kernel::WorkerJob, this, m_workerStates.size());
+        }
+        ApplyDeferredActions();
+
+        // Report the first error in the order of the serial kernel
+        bool idle = true;
+        for (auto& task : m_tasks)
+        {
+            if (task.error && !task.terminated)
+            {
+                t_clock   = task.clock;
+                t_process = task.process;
+                std::rethrow_exception(task.error);
+            }
+        }
+
+        for (auto& task : m_tasks)
+        {
+            if (task.terminated)
+            {
+                RecordTermination(*task.process, task.error);
+                idle = false;
+            }
+            else if (task.committed)
+            {
+                // We've done something -- we're not idle
+                idle = false;
+            }
+        }
+        return idle;
+    }
+
+    void Kernel::BuildTaskGraph(TaskGraph& graph)
+    {
+        const size_t count = m_tasks.size();
+        graph.processes.resize(count);
+        graph.waiting.assign(count, 0);
+        graph.firstNext.assign(count + 1, 0);
+
+        // Each task follows the last preceding task of each of its domains.
+        m_domainTasks.assign(m_partitions.size(), NO_TASK);
+        m_taskEdges.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            graph.processes[i] = m_tasks[i].process;
+
+            const size_t first = m_taskEdges.size();
+            for (size_t domain : m_tasks[i].process->m_domains)
+            {
+                const size_t prev = m_domainTasks[domain];
+                m_domainTasks[domain] = i;
+                if (prev != NO_TASK && find_if(m_taskEdges.begin() + first, m_taskEdges.end(),
+                        [prev](const std::pair<size_t, size_t>& e) { return e.first == prev; }) == m_taskEdges.end())
+                {
+                    m_taskEdges.push_back(make_pair(prev, i));
+                    graph.waiting[i]++;
+                    graph.firstNext[prev + 1]++;
+                }
+            }
+        }
+
+        // Store the following tasks of each task contiguously
+        for (size_t i = 0; i < count; ++i)
+        {
+            graph.firstNext[i + 1] += graph.firstNext[i];
+        }
+        std::vector<size_t> end(graph.firstNext.begin(), graph.firstNext.end() - 1);
+        graph.next.resize(m_taskEdges.size());
+        for (auto& e : m_taskEdges)
+        {
+            graph.next[end[e.first]++] = e.second;
+        }
+    }
+
+    void Kernel::WorkerJob(void* arg, size_t item)
+    {
+        Kernel& kernel = *static_cast<Kernel*>(arg);
+        Worker& worker = kernel.m_workerStates[item];
+        for (;;)
+        {
+            size_t index = NO_TASK;
+            {
+                std::lock_guard<SpinLock> lock(kernel.m_taskLock);
+                if (kernel.m_tasksLeft == 0 || kernel.m_taskFailed)
+                {
+                    break;
+                }
+
+                if (!kernel.m_taskReady.empty())
+                {
+                    pop_heap(kernel.m_taskReady.begin(), kernel.m_taskReady.end(), std::greater<size_t>());
+                    index = kernel.m_taskReady.back();
+                    kernel.m_taskReady.pop_back();
+                }
+            }
+
+            if (index == NO_TASK)
+            {
+                // Wait for the running tasks to release others
+                std::this_thread::yield();
+                continue;
+            }
+            kernel.RunTask(index, worker);
+        }
+    }
+
+    void Kernel::RunTask(size_t index, Worker& worker)
+    {
+        Task& task = m_tasks[index];
+        task.worker      = &worker - &m_workerStates[0];
+        task.firstAction = worker.actions.size();
+
+        t_worker  = &worker;
+        t_clock   = task.clock;
+        t_process = task.process;
+        try
+        {
+            if (m_taskPhase == PHASE_ACQUIRE)
+            {
+                t_phase = PHASE_ACQUIRE;
+                AcquireProcess(*task.process);
+            }
+            else
+            {
+                task.committed = CommitProcess(*task.process);
+            }
+        }
+        catch (ProgramTerminationException&)
+        {
+            task.error      = std::current_exception();
+            task.terminated = true;
+        }
+        catch (...)
+        {
+            task.error = std::current_exception();
+        }
+        t_worker = NULL;
+        task.endAction = worker.actions.size();
+
+        std::lock_guard<SpinLock> lock(m_taskLock);
+        if (task.error && !task.terminated)
+        {
+            // Run no more tasks; RunParallelPhase reports the error.
+            m_taskFailed = true;
+            return;
+        }
+
+        for (size_t i = m_taskGraph->firstNext[index]; i != m_taskGraph->firstNext[index + 1]; ++i)
+        {
+            const size_t next = m_taskGraph->next[i];
+            if (--m_tasks[next].waiting == 0)
+            {
+                m_taskReady.push_back(next);
+                push_heap(m_taskReady.begin(), m_taskReady.end(), std::greater<size_t>());
+            }
+        }
+        --m_tasksLeft;
+    }
+
+    void Kernel::ApplyDeferredActions()
+    {
+        // Apply in the order of the tasks, as the serial kernel makes
+        // these changes, so that the lists of active components and
+        // the output do not depend on the host threads.
+        for (auto& task : m_tasks)
+        {
+            if (task.worker == NO_TASK)
+            {
+                continue;
+            }
+
+            Worker& worker = m_workerStates[task.worker];
+            for (size_t i = task.firstAction; i != task.endAction; ++i)
+            {
+                const Worker::Action& action = worker.actions[i];
+                switch (action.kind)
+                {
+                case Worker::Action::ACTIVATE:   action.clock->ActivateProcess(*static_cast<Process*>(action.object)); break;
+                case Worker::Action::DEACTIVATE: static_cast<Process*>(action.object)->Deactivate(); break;
+                case Worker::Action::UPDATE:     static_cast<Storage*>(action.object)->RegisterUpdate(); break;
+                case Worker::Action::ARBITRATE:  static_cast<Arbitrator*>(action.object)->RequestArbitration(); break;
+                case Worker::Action::OUTPUT:
+                {
+                    const Worker::Output& output = worker.outputs[action.output];
+                    if (output.file != NULL)
+                    {
+                        fputs(output.text.c_str(), output.file);
+                    }
+                    else
+                    {
+                        *output.stream << output.text;
+                        output.stream->flags(output.flags);
+                        output.stream->precision(output.precision);
+                        output.stream->flush();
+                    }
+                    break;
+                }
+                }
+            }
+        }
+
+        for (auto& worker : m_workerStates)
+        {
+            worker.actions.clear();
+            worker.outputs.clear();
+        }
+    }
+
+    void Kernel::WriteOutput(FILE* file, const string& text)
+    {
+        if (IsParallelPhase())
+        {
+            t_worker->outputs.push_back({file, NULL, text, std::ios_base::fmtflags(), 0});
+            t_worker->actions.push_back({Worker::Action::OUTPUT, NULL, NULL, t_worker->outputs.size() - 1});
+            return;
+        }
+        fputs(text.c_str(), file);
+    }
+
+    void Kernel::WriteOutput(ostream& os, const ostringstream& text)
+    {
+        if (IsParallelPhase())
+        {
+            t_worker->outputs.push_back({NULL, &os, text.str(), text.flags(), text.precision()});
+            t_worker->actions.push_back({Worker::Action::OUTPUT, NULL, NULL, t_worker->outputs.size() - 1});
+            return;
+        }
+        os << text.str();
+        os.flags(text.flags());
+        os.precision(text.precision());
+        os.flush();
+    }
+
+    // Heap order of the schedule: returns true if clock a runs after
+    // clock b. Clocks that tick in the same cycle run in creation order.
+    static bool RunsAfter(const Clock* a, const Clock* b)
+    {
+        const CycleNo ta = a->GetNextTick(), tb = b->GetNextTick();
+        return ta > tb || (ta == tb && a->GetIndex() > b->GetIndex());
+    }
+
     void Kernel::ActivateClock(Clock& clock)
     {
         if (!clock.m_activated)
@@ -305,28 +729,70 @@ namespace Simulator
             // Calculate new activation time for clock
             clock.m_cycle = (m_cycle / clock.m_period) * clock.m_period + clock.m_period;
 
-            // Insert clock into list based on activation time (earliest in front)
-            Clock **before = &m_activeClocks, *after = m_activeClocks;
-            while (after != NULL && after->m_cycle < clock.m_cycle)
+            // Schedule the clock (earliest at the top)
+            m_schedule.push_back(&clock);
+            push_heap(m_schedule.begin(), m_schedule.end(), RunsAfter);
+            clock.m_activated = true;
+        }
+    }
+
+    void Kernel::StartCycle()
+    {
+        // The clocks stay activated while they run, so that they are
+        // not scheduled again until EndCycle. If the previous cycle
+        // did not complete, its clocks are still in m_running.
+        while (!m_schedule.empty() && m_schedule.front()->m_cycle == m_cycle)
+        {
+            pop_heap(m_schedule.begin(), m_schedule.end(), RunsAfter);
+            m_running.push_back(m_schedule.back());
+            m_schedule.pop_back();
+        }
+    }
+
+    void Kernel::EndCycle()
+    {
+        for (Clock* clock : m_running)
+        {
+            clock->m_activated = false;
+
+            assert(clock->m_activeArbitrators == NULL);
+
+            if (clock->m_activeProcesses != NULL || clock->m_activeStorages != NULL)
             {
-                before = &after->m_next;
-                after  = after->m_next;
+                // This clock still has active components, reschedule it
+                ActivateClock(*clock);
             }
-            *before = &clock;
-            clock.m_next = after;
-            clock.m_activated = true;
         }
+        m_running.clear();
+    }
+
+    const Clock* Kernel::GetActiveClocks()
+    {
+        // Link the running clocks and the scheduled clocks, in the
+        // order in which they will run.
+        vector<Clock*> clocks(m_schedule);
+        sort(clocks.begin(), clocks.end(), [](const Clock* a, const Clock* b) { return RunsAfter(b, a); });
+        clocks.insert(clocks.begin(), m_running.begin(), m_running.end());
+
+        Clock* first = NULL;
+        Clock** tail = &first;
+        for (Clock* c : clocks)
+        {
+            *tail = c;
+            tail = &c->m_next;
+        }
+        *tail = NULL;
+        return first;
     }
 
     bool Kernel::UpdateStorages()
     {
         bool updated = false;
-        for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
+        for (Clock* clock : m_running)
         {
             for (Storage *s = clock->m_activeStorages; s != NULL; s = s->GetNext())
             {
-                s->Update();
-                s->Deactivate();
+                UpdateStorage(*s);
                 updated = true;
             }
             clock->m_activeStorages = NULL;
@@ -335,6 +801,140 @@ namespace Simulator
     }
 
 
+    static const char* const CHECKPOINT_HEADER = "# MGSim checkpoint";
+
+    void Kernel::SaveCheckpoint(ostream& os) const
+    {
+        // Pending storage updates and arbitration requests are not
+        // part of the registered state, so they must not exist.
+        for (auto c : m_clocks)
+            if (c->m_activeStorages != NULL || c->m_activeArbitrators != NULL)
+                throw exceptf<>("Cannot save a checkpoint in the middle of a cycle "
+                                "(the simulation must have run at least one cycle)");
+
+        os << CHECKPOINT_HEADER << endl
+           << "# cycle " << m_cycle << endl;
+        m_var_registry.RenderVariables(os, "*", true);
+    }
+
+    void Kernel::LoadCheckpoint(istream& is)
+    {
+        string header;
+        if (!getline(is, header) || header != CHECKPOINT_HEADER)
+            throw exceptf<>("Invalid checkpoint: missing header");
+
+        // Perform the pending storage updates first, for example the
+        // initialization writes, so that the checkpoint overwrites
+        // their effect below.
+        for (auto c : m_clocks)
+        {
+            for (Storage *s = c->m_activeStorages; s != NULL; s = s->GetNext())
+            {
+                s->Update();
+                s->Deactivate();
+            }
+            c->m_activeStorages = NULL;
+
+            for (Arbitrator* a = c->m_activeArbitrators; a != NULL; a = a->GetNext())
+                a->Deactivate();
+            c->m_activeArbitrators = NULL;
+        }
+
+        m_var_registry.LoadVariables(is);
+        m_lastsuspend = (CycleNo)-1;
+    }
+
+    void Kernel::SerializeSchedule(StreamSerializer& arch, void* p)
+    {
+        Kernel& kernel = *static_cast<Kernel*>(p);
+
+        // Processes are identified by their rank in name order, and
+        // clocks by their rank in creation order, so that the schedule
+        // does not depend on where objects live in host memory.
+        vector<Process*> procs(kernel.m_proc_registry.begin(), kernel.m_proc_registry.end());
+        sort(procs.begin(), procs.end(),
+             [](const Process* a, const Process* b) { return a->GetName() < b->GetName(); });
+        const vector<Clock*>& clocks = kernel.m_clocks;
+
+        vector<size_t>          active;      ///< Active clocks, in order.
+        vector<CycleNo>         ticks;       ///< Next tick of every clock.
+        vector<vector<size_t> > queues;      ///< Active processes of every clock, in order.
+        vector<unsigned int>    activations; ///< Activation count of every process.
+
+        if (arch.reading())
+        {
+            map<const Process*, size_t> ids;
+            for (size_t i = 0; i < procs.size(); ++i)
+            {
+                ids[procs[i]] = i;
+                activations.push_back(procs[i]->m_activations);
+            }
+            for (const Clock* c = kernel.GetActiveClocks(); c != NULL; c = c->m_next)
+                active.push_back(find(clocks.begin(), clocks.end(), c) - clocks.begin());
+            for (auto c : clocks)
+            {
+                ticks.push_back(c->m_cycle);
+                queues.push_back(vector<size_t>());
+                for (Process* q = c->m_activeProcesses; q != NULL; q = q->m_next)
+                    queues.back().push_back(ids[q]);
+            }
+        }
+
+        arch & "[ks" & active & ticks & queues & activations & "]";
+
+        if (arch.reading())
+            return;
+
+        if (ticks.size() != clocks.size() || queues.size() != clocks.size() || activations.size() != procs.size())
+            throw exceptf<>("Invalid schedule: expected %zu clocks and %zu processes, got %zu and %zu",
+                            clocks.size(), procs.size(), ticks.size(), activations.size());
+        for (auto i : active)
+            if (i >= clocks.size())
+                throw exceptf<>("Invalid schedule: clock %zu out of range", i);
+        for (auto& q : queues)
+            for (auto i : q)
+                if (i >= procs.size())
+                    throw exceptf<>("Invalid schedule: process %zu out of range", i);
+
+        // Rebuild the lists from scratch.
+        for (size_t i = 0; i < procs.size(); ++i)
+        {
+            procs[i]->m_activations = activations[i];
+            procs[i]->m_next  = NULL;
+            procs[i]->m_pPrev = NULL;
+        }
+        for (size_t i = 0; i < clocks.size(); ++i)
+        {
+            Clock& c = *clocks[i];
+            c.m_cycle     = ticks[i];
+            c.m_activated = false;
+            c.m_next      = NULL;
+
+            Process** tail = &c.m_activeProcesses;
+            for (auto j : queues[i])
+            {
+                Process* q = procs[j];
+                q->m_pPrev = tail;
+                *tail = q;
+                tail = &q->m_next;
+            }
+            *tail = NULL;
+        }
+
+        kernel.m_running.clear();
+        kernel.m_schedule.clear();
+        for (auto i : active)
+        {
+            Clock* c = clocks[i];
+            if (!c->m_activated)
+            {
+                c->m_activated = true;
+                kernel.m_schedule.push_back(c);
+                push_heap(kernel.m_schedule.begin(), kernel.m_schedule.end(), RunsAfter);
+            }
+        }
+    }
+
     void Kernel::SetDebugMode(int flags)
     {
         m_debugMode = flags;
@@ -349,30 +949,170 @@ namespace Simulator
     Kernel::RegisterProcess(Process& p)
     {
         m_proc_registry.insert(&p);
+
+        // Partition processes by top-level component, ie. the first
+        // part of their name (eg. "cpu3" for "cpu3.dcache:outgoing").
+        p.m_partition = GetPartitionId(p.GetName());
+        m_domainsChanged = true;
+    }
+
+    size_t Kernel::GetPartitionId(const string& name)
+    {
+        string component = name.substr(0, name.find_first_of(".:"));
+        auto i = m_partitionIds.find(component);
+        if (i == m_partitionIds.end())
+        {
+            i = m_partitionIds.insert(make_pair(component, m_partitions.size())).first;
+            m_partitions.push_back(Partition());
+        }
+        return i->second;
+    }
+
+    void Kernel::DeclareAccess(Process& process, const string& name)
+    {
+        process.m_accesses.push_back(GetPartitionId(name));
+        m_domainsChanged = true;
+    }
+
+    void Kernel::DeclareAccess(const string& accessor, const string& name)
+    {
+        const size_t a = GetPartitionId(accessor);
+        const size_t b = GetPartitionId(name);
+        if (a != b)
+        {
+            m_partitions[a].accesses.push_back(b);
+            m_domainsChanged = true;
+        }
+    }
+
+    void Kernel::SetStorageWrites(Process& process, const StorageTraceSet& traces)
+    {
+        std::vector<const Storage*>& writes = process.m_writes;
+        writes.clear();
+        for (const StorageTrace& trace : traces.m_storages)
+        {
+            writes.insert(writes.end(), trace.GetStorages().begin(), trace.GetStorages().end());
+        }
+        sort(writes.begin(), writes.end());
+        writes.erase(unique(writes.begin(), writes.end()), writes.end());
+        m_domainsChanged = true;
+    }
+
+    void Kernel::ComputeDomains()
+    {
+        // Find the storages that processes of several partitions write
+        std::map<const Storage*, std::pair<size_t, bool> > writers;
+        for (const Process* process : m_proc_registry)
+        {
+            for (const Storage* storage : process->m_writes)
+            {
+                auto w = writers.insert(make_pair(storage, make_pair(process->m_partition, false))).first;
+                if (w->second.first != process->m_partition)
+                {
+                    w->second.second = true;
+                }
+            }
+        }
+
+        for (Process* process : m_proc_registry)
+        {
+            std::vector<size_t>& domains = process->m_domains;
+            const std::vector<size_t>& accesses = m_partitions[process->m_partition].accesses;
+            domains.assign(1, process->m_partition);
+            domains.insert(domains.end(), accesses.begin(), accesses.end());
+            domains.insert(domains.end(), process->m_accesses.begin(), process->m_accesses.end());
+            for (const Storage* storage : process->m_writes)
+            {
+                if (writers[storage].second)
+                {
+                    domains.push_back(GetPartitionId(storage->GetName()));
+                }
+            }
+            sort(domains.begin(), domains.end());
+            domains.erase(unique(domains.begin(), domains.end()), domains.end());
+        }
+        m_domainsChanged = false;
+
+        // The tasks are ordered anew
+        for (auto& graph : m_taskGraphs)
+        {
+            graph.processes.clear();
+        }
+    }
+
+    void Kernel::SetNumThreads(size_t threads)
+    {
+        delete m_workers;
+        m_workers = (threads > 1) ? new WorkerPool(threads) : NULL;
+        m_workerStates.clear();
+        m_workerStates.resize((m_workers != NULL) ? threads : 0);
+    }
+
+    size_t Kernel::GetNumThreads() const
+    {
+        return (m_workers != NULL) ? m_workers->GetNumWorkers() : 1;
+    }
+
+    void Kernel::SetCycleObserver(CycleObserver* observer, CycleNo period)
+    {
+        assert(observer == NULL || period > 0);
+        m_observer        = observer;
+        m_observerPeriod  = period;
+        m_nextObservation = (observer != NULL) ? (m_cycle + period - 1) / period * period : 0;
     }
 
     Kernel::Kernel()
         : m_lastsuspend((CycleNo)-1),
           m_cycle(0),
           m_master_freq(0),
-          m_clock(NULL),
-          m_process(NULL),
           m_clocks(),
-          m_activeClocks(NULL),
-          m_phase(PHASE_COMMIT),
+          m_schedule(),
+          m_running(),
           m_debugMode(0),
           m_aborted(false),
           m_suspended(false),
           m_config(NULL),
           m_var_registry(),
-          m_proc_registry()
+          m_eventTrace(),
+          m_proc_registry(),
+          m_numStorages(0),
+          m_partitionIds(),
+          m_partitions(),
+          m_domainsChanged(true),
+          m_tasks(),
+          m_taskGraphs(),
+          m_taskGraph(NULL),
+          m_taskEdges(),
+          m_domainTasks(),
+          m_taskReady(),
+          m_tasksLeft(0),
+          m_taskFailed(false),
+          m_taskPhase(PHASE_ACQUIRE),
+          m_taskLock(),
+          m_workerStates(),
+          m_workers(NULL),
+          m_parallel(true),
+          m_termination(),
+          m_terminator(NULL),
+          m_observer(NULL),
+          m_observerPeriod(0),
+          m_nextObservation(0),
+          m_profiling(false),
+          m_profileTicks(0),
+          m_profileNanos(0),
+          m_profiledArbitrators(),
+          m_profiledStorages()
     {
         m_var_registry.RegisterVariable(m_cycle, "kernel.cycle", SVC_CUMULATIVE);
-        m_var_registry.RegisterVariable(m_phase, "kernel.phase", SVC_STATE);
+        m_var_registry.RegisterVariable(t_phase, "kernel.phase", SVC_STATE);
+        m_var_registry.RegisterVariable(this, "kernel.schedule", SVC_STATE,
+                                        Serialization::SV_OTHER, 0, 0,
+                                        &Kernel::SerializeSchedule);
     }
 
     Kernel::~Kernel()
     {
+        delete m_workers;
         for (auto c : m_clocks)
             delete c;
     }
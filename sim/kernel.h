@@ -5,7 +5,12 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <exception>
+#include <ostream>
+#include <sstream>
+#include <string>
 #include <cassert>
+#include <cstdio>
 
 // Dependencies of Kernel.
 #include "sim/types.h"
@@ -13,6 +18,9 @@
 #include "sim/delegate.h"
 #include "sim/storagetrace.h"
 #include "sim/sampling.h"
+#include "sim/eventtrace.h"
+#include "sim/profile.h"
+#include "sim/workerpool.h"
 
 // Other classes that users of Kernel expect to see defined too.
 #include "sim/clock.h"
@@ -24,6 +32,18 @@ class Config;
 
 namespace Simulator
 {
+    /**
+     * @brief Interface for objects that observe the simulation at
+     * regular intervals of simulated time, see Kernel::SetCycleObserver.
+     */
+    class CycleObserver
+    {
+    public:
+        /// Called by the simulation thread at the end of a cycle.
+        virtual void OnCycle(CycleNo cycle) = 0;
+        virtual ~CycleObserver() {}
+    };
+
     /**
      * Enumeration for the phases inside a cycle
      */
@@ -61,25 +81,200 @@ public:
         static const int DEBUG_CPU_MASK = DEBUG_SIM | DEBUG_PROG | DEBUG_DEADLOCK | DEBUG_FLOW | DEBUG_MEM | DEBUG_IO | DEBUG_REG;
 
     private:
+        /**
+         * A partition groups the processes of one top-level component
+         * (eg. a core, an FPU or the memory system). Besides the state
+         * of its own partition, a process may access that of:
+         * - the partitions declared with DeclareAccess();
+         * - the partitions of the storages that it writes (see
+         *   Process::SetStorageTraces) and that processes of other
+         *   partitions write too.
+         * These partitions are the domains of the process. The
+         * parallel kernel runs two processes concurrently only if they
+         * have no domain in common; processes that share a domain run
+         * in the order of the serial kernel.
+         */
+        struct Partition
+        {
+            std::vector<size_t> accesses; ///< Partitions accessed by all its processes.
+        };
+
+        /**
+         * A process to run in a phase of the parallel kernel. The
+         * tasks of a phase are numbered in the order of the serial
+         * kernel. A task runs once the preceding tasks that share a
+         * domain with it have run.
+         */
+        struct Task
+        {
+            Clock*             clock;
+            Process*           process;
+            size_t             waiting;     ///< Number of preceding tasks that have not run yet.
+            size_t             worker;      ///< Worker that ran the task, or NO_TASK if it did not run.
+            size_t             firstAction; ///< First deferred action of the task at the worker.
+            size_t             endAction;   ///< End of the deferred actions of the task.
+            bool               committed;   ///< The process committed.
+            bool               terminated;  ///< The program requested to terminate.
+            std::exception_ptr error;       ///< Exception thrown by the process.
+        };
+
+        /**
+         * The order between the tasks of a phase. Consecutive cycles
+         * tend to run the same processes, so the graph of the last
+         * acquire and commit phases is kept, and reused as long as the
+         * same processes run.
+         */
+        struct TaskGraph
+        {
+            std::vector<Process*> processes; ///< The process of each task.
+            std::vector<size_t>   waiting;   ///< Number of preceding tasks of each task.
+            std::vector<size_t>   firstNext; ///< Start of the following tasks of each task in next, and the end.
+            std::vector<size_t>   next;      ///< The following tasks of all tasks.
+        };
+
+        /**
+         * Per host thread state of the parallel kernel. The lists of
+         * active components and the output are shared, so the changes
+         * that tasks make to them are deferred, and applied after the
+         * phase in the order of the tasks (see ApplyDeferredActions).
+         */
+        struct Worker
+        {
+            struct Action
+            {
+                enum Kind { ACTIVATE, DEACTIVATE, UPDATE, ARBITRATE, OUTPUT };
+                Kind   kind;
+                Clock* clock;   ///< The clock to activate the process in.
+                void*  object;  ///< The process, storage or arbitrator.
+                size_t output;  ///< Index of the output in outputs.
+            };
+
+            struct Output
+            {
+                FILE*                   file;      ///< Output stream, or NULL for stream.
+                std::ostream*           stream;
+                std::string             text;
+                std::ios_base::fmtflags flags;     ///< Format of stream after the output.
+                std::streamsize         precision;
+            };
+
+            std::vector<Action> actions;
+            std::vector<Output> outputs;
+        };
+
+        static const size_t NO_TASK = (size_t)-1;
+
         CycleNo             m_lastsuspend;  ///< Avoid suspending twice on the same cycle.
         CycleNo             m_cycle;        ///< Current cycle of the simulation.
         Clock::Frequency    m_master_freq;  ///< Master frequency
-        Clock*              m_clock;        ///< The currently active clock.
-        Process*            m_process;      ///< The currently executing process.
         std::vector<Clock*> m_clocks;       ///< All clocks in the system.
-        Clock*              m_activeClocks; ///< The clocks that have active components
+        std::vector<Clock*> m_schedule;     ///< Heap of the clocks that have active components, earliest tick first
+        std::vector<Clock*> m_running;      ///< The clocks that tick in the current cycle, in creation order
+
+        // The following are per host thread, so that the parallel kernel
+        // can run processes concurrently.
+        static thread_local Clock*      t_clock;     ///< The currently active clock.
+        static thread_local Process*    t_process;   ///< The currently executing process.
+        static thread_local CyclePhase  t_phase;     ///< Current sub-cycle phase of the simulation.
+        static thread_local Worker*     t_worker;    ///< Worker state while running a task of the parallel kernel.
 
-        CyclePhase          m_phase;        ///< Current sub-cycle phase of the simulation.
         int                 m_debugMode;    ///< Bit mask of enabled debugging modes.
         bool                m_aborted;      ///< Should the run be aborted?
         bool                m_suspended;    ///< Should the run be suspended?
 
         Config*             m_config;       ///< Attached configuration object.
         VariableRegistry    m_var_registry; ///< Attached variable registry.
+        EventTrace          m_eventTrace;   ///< Binary event trace.
         std::set<Process*>  m_proc_registry; ///< Set of all processes instantiated.
+        uint32_t            m_numStorages;  ///< Number of storage identifiers allocated.
+
+        std::map<std::string, size_t> m_partitionIds; ///< Partition index by component name.
+        std::vector<Partition> m_partitions;   ///< All partitions, by index.
+        bool                m_domainsChanged; ///< Declarations changed since the domains were computed.
+        std::vector<Task>   m_tasks;        ///< Tasks of the current phase of the parallel kernel.
+        TaskGraph           m_taskGraphs[2]; ///< Graph of the last acquire and commit phases.
+        const TaskGraph*    m_taskGraph;    ///< Graph of the current phase.
+        std::vector<std::pair<size_t, size_t> > m_taskEdges; ///< Pairs of ordered tasks, while numbering them.
+        std::vector<size_t> m_domainTasks;  ///< Last task of each domain, while numbering the tasks.
+        std::vector<size_t> m_taskReady;    ///< Heap of the tasks that can run, lowest first.
+        size_t              m_tasksLeft;    ///< Number of tasks that have not run yet.
+        bool                m_taskFailed;   ///< A task threw an error; run no more tasks.
+        CyclePhase          m_taskPhase;    ///< The phase that the tasks run.
+        SpinLock            m_taskLock;     ///< Protects the task graph while the tasks run.
+        std::vector<Worker> m_workerStates; ///< State of each host thread.
+        WorkerPool*         m_workers;      ///< Host threads for the parallel kernel, or NULL.
+        bool                m_parallel;     ///< Use the parallel kernel if there are host threads.
+
+        std::exception_ptr  m_termination;  ///< Termination requested by the program in this cycle.
+        Process*            m_terminator;   ///< The process that requested the termination.
+
+        CycleObserver*      m_observer;     ///< Notified every m_observerPeriod cycles, or NULL.
+        CycleNo             m_observerPeriod;
+        CycleNo             m_nextObservation; ///< Cycle at or after which to notify the observer.
+
+        bool                m_profiling;    ///< Measure host time per process, arbitrator and storage?
+        HostTicks           m_profileTicks; ///< Host ticks when profiling was first enabled.
+        uint64_t            m_profileNanos; ///< Wall clock time when profiling was first enabled.
+        std::vector<Arbitrator*> m_profiledArbitrators; ///< Arbitrators with a non-empty profile.
+        std::vector<Storage*>    m_profiledStorages;    ///< Storages with a non-empty profile.
 
         bool UpdateStorages();
 
+        // Run a process delegate, an arbitrator or a storage update,
+        // measuring its host time if profiling is enabled.
+        Result InvokeProcess(Process& process);
+        void   Arbitrate(Arbitrator& arbitrator);
+        void   UpdateStorage(Storage& storage);
+
+        // Move the clocks that tick in the current cycle from the
+        // schedule to m_running, and put m_running clocks that are
+        // still active back on the schedule.
+        void StartCycle();
+        void EndCycle();
+
+        // Run a process in the acquire phase, and in the check and
+        // commit phases. CommitProcess returns true if it committed.
+        void AcquireProcess(Process& process);
+        bool CommitProcess(Process& process);
+
+        // Record a termination requested by the program while running
+        // a process. The termination takes effect at the end of the
+        // cycle, so that the cycle completes as with the parallel kernel.
+        void RecordTermination(Process& process, std::exception_ptr e);
+
+        // Parallel kernel: run the acquire, arbitrate and commit
+        // phases of the current cycle. Returns true if idle.
+        bool RunParallelCycle();
+        bool RunParallelPhase(CyclePhase phase);
+        void BuildTaskGraph(TaskGraph& graph);
+        void ComputeDomains();
+        void ApplyDeferredActions();
+        void RunTask(size_t index, Worker& worker);
+        size_t GetPartitionId(const std::string& name);
+        static void WorkerJob(void* kernel, size_t worker);
+
+        // Storage, Arbitrator, Clock and Process defer their
+        // activations with these during a parallel phase.
+        friend class Storage;
+        friend class Arbitrator;
+        friend class Clock;
+        friend class Process;
+        static bool IsParallelPhase() { return t_worker != NULL; }
+        static void DeferStorageUpdate(Storage& storage) { t_worker->actions.push_back({Worker::Action::UPDATE, NULL, &storage, 0}); }
+        static void DeferArbitration(Arbitrator& arbitrator) { t_worker->actions.push_back({Worker::Action::ARBITRATE, NULL, &arbitrator, 0}); }
+        static void DeferProcessActivation(Clock* clock, Process& process)
+        {
+            t_worker->actions.push_back({(clock != NULL) ? Worker::Action::ACTIVATE : Worker::Action::DEACTIVATE, clock, &process, 0});
+        }
+
+        // Process::SetStorageTraces declares the storages that the
+        // process writes with this.
+        void SetStorageWrites(Process& process, const StorageTraceSet& traces);
+
+        // Serializer for the lists of active clocks and processes,
+        // registered as variable "kernel.schedule".
+        static void SerializeSchedule(StreamSerializer& arch, void* kernel);
+
 #ifdef STATIC_KERNEL
         static Kernel* g_kernel;
     public:
@@ -101,11 +296,106 @@ public:
         VariableRegistry& GetVariableRegistry() { return m_var_registry; }
         const VariableRegistry& GetVariableRegistry() const { return m_var_registry; }
 
+        EventTrace& GetEventTrace() { return m_eventTrace; }
+
         /**
          * @brief Register a process for introspection.
          */
         void RegisterProcess(Process&);
 
+        /**
+         * @brief Allocate a small identifier for a storage, used by
+         * the storage trace checks.
+         */
+        uint32_t AllocateStorageId() { return m_numStorages++; }
+
+        /**
+         * @brief Set the number of host threads used to run processes.
+         * With 1 (the default), the serial kernel is used. With more,
+         * the processes of the acquire and commit phases run on a pool
+         * of host threads, as ordered by their domains (see Partition),
+         * while arbitration and storage updates remain serial. The
+         * simulation is the same as with the serial kernel, except
+         * after an error other than a termination requested by the
+         * program: processes that do not share a domain with the
+         * failing one may have run although they follow it.
+         */
+        void SetNumThreads(size_t threads);
+
+        /**
+         * @brief Declare that a process accesses the state of another
+         * component directly, other than through storages and ports
+         * (eg. a client of a memory that calls IMemory::Read). The
+         * parallel kernel runs the process in order with the processes
+         * of that component (see Partition).
+         * @param name the name of the component; the process accesses
+         * the state of its top-level component.
+         */
+        void DeclareAccess(Process& process, const std::string& name);
+
+        /**
+         * @brief Declare that all processes of a component access the
+         * state of another component directly (eg. a memory, whose
+         * processes call back into its clients through IMemoryCallback).
+         * The arguments are object names; the declaration applies to
+         * their top-level components.
+         */
+        void DeclareAccess(const std::string& accessor, const std::string& name);
+
+        /**
+         * @brief Enable or disable the parallel kernel. While disabled,
+         * the serial kernel is used whatever the number of host threads,
+         * eg. while the cores access memory functionally, which they do
+         * without declaring it.
+         */
+        void SetParallel(bool parallel) { m_parallel = parallel; }
+
+        /**
+         * @brief Write output of the simulation, eg. debug output or
+         * output of the simulated program. During a phase of the
+         * parallel kernel, the output is written at the end of the
+         * phase, in the order of the serial kernel.
+         */
+        static void WriteOutput(FILE* file, const std::string& text);
+
+        /**
+         * @brief Write output formatted into text to the stream, then
+         * set the format of the stream to that of text, as if text had
+         * been formatted into the stream itself (see WriteOutput above).
+         */
+        static void WriteOutput(std::ostream& os, const std::ostringstream& text);
+
+        /**
+         * @brief Returns the number of host threads used to run processes.
+         */
+        size_t GetNumThreads() const;
+
+        /**
+         * @brief Set the object notified at the end of the first cycle
+         * of every period of simulated cycles, or NULL for none.
+         * Since time skips the cycles where no clock ticks, the
+         * observer is notified at the first simulated cycle at or after
+         * each multiple of the period.
+         */
+        void SetCycleObserver(CycleObserver* observer, CycleNo period);
+
+        /**
+         * @brief Enable or disable the host time profiler.
+         * While enabled, the kernel accumulates the host time and the
+         * number of invocations of each process delegate, arbitrator
+         * and storage update. Counts are kept when disabled again.
+         */
+        void SetProfiling(bool enable);
+        bool IsProfiling() const { return m_profiling; }
+
+        /**
+         * @brief Print the host time profile of the processes,
+         * arbitrators and storages whose name matches pattern, and
+         * their totals by component class.
+         * @param limit the maximum number of rows per list, 0 for all.
+         */
+        void PrintProfile(std::ostream& os, const std::string& pattern, size_t limit = 0) const;
+
         /**
          * @brief Inspect all registered processes.
          */
@@ -129,17 +419,20 @@ public:
         /**
          * @brief Get the currently active clock
          */
-        inline Clock* GetActiveClock() const { return m_clock; }
+        inline Clock* GetActiveClock() const { return t_clock; }
 
         /**
          * @brief Get the currently executing process
          */
-        inline Process* GetActiveProcess() const { return m_process; }
+        inline Process* GetActiveProcess() const { return t_process; }
 
         /**
-         * @brief Get the currently scheduled processes
+         * @brief Get the clocks that have active components.
+         * The clocks are linked in the order in which they will run;
+         * use Clock::GetNext() to iterate. This relinks the clocks,
+         * so the list is only valid until the next call.
          */
-        inline const Clock* GetActiveClocks() const { return m_activeClocks; }
+        const Clock* GetActiveClocks();
 
         /**
          * @brief Get the cycle counter.
@@ -153,7 +446,7 @@ public:
          * Gets the current sub-cycle phase of the simulation.
          * @return the current sub-cycle phase.
          */
-        inline CyclePhase GetCyclePhase() const { return m_phase; }
+        inline CyclePhase GetCyclePhase() const { return t_phase; }
 
         /**
          * Sets the debug flags.
@@ -182,6 +475,24 @@ public:
          */
         RunState Step(CycleNo cycles = 1);
 
+        /**
+         * @brief Saves the simulation state to a stream.
+         * The checkpoint contains all the registered variables,
+         * including the schedule of clocks and processes. It must be
+         * taken between two cycles, ie. not before the simulation has
+         * started or after an error in the middle of a cycle.
+         * @param os the stream to write the checkpoint to.
+         */
+        void SaveCheckpoint(std::ostream& os) const;
+
+        /**
+         * @brief Restores the simulation state from a stream.
+         * The checkpoint must have been saved by a simulation with the
+         * same configuration, ie. with the same set of variables.
+         * @param is the stream to read the checkpoint from.
+         */
+        void LoadCheckpoint(std::istream& is);
+
         /**
          * @brief Aborts the simulation
          * Stops the current simulation, in Step(). This is best called asynchronously,
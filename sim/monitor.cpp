@@ -9,6 +9,7 @@
 #include <fstream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -46,7 +47,14 @@ Monitor::Monitor(Simulator::MGSystem& sys, bool enabled, const string& mdfile, c
       m_sampler(0),
       m_quiet(quiet),
       m_running(false),
-      m_enabled(true)
+      m_enabled(true),
+      m_sampleCycles(0),
+      m_recordSize(0),
+      m_ring(),
+      m_ringSize(0),
+      m_ringHead(0),
+      m_ringTail(0),
+      m_ringStalls(0)
 {
     if (!enabled)
     {
@@ -85,19 +93,41 @@ Monitor::Monitor(Simulator::MGSystem& sys, bool enabled, const string& mdfile, c
         return ;
     }
 
-    float msd = sys.GetKernel()->GetConfig()->getValue<float>("MonitorSampleDelay");
-    msd = fabs(msd);
-    m_tsdelay.tv_sec = msd;
-    m_tsdelay.tv_nsec = (msd - (float)m_tsdelay.tv_sec) * 1000000000.;
+    m_recordSize = m_sampler->GetBufferSize() + 2 * sizeof(struct timeval);
+    m_sampleCycles = sys.GetKernel()->GetConfig()->getValueOrDefault<Simulator::CycleNo>("MonitorSampleCycles", 0);
+    if (m_sampleCycles != 0)
+    {
+        m_ringSize = max<size_t>(sys.GetKernel()->GetConfig()->getValueOrDefault<size_t>("MonitorBufferSize", 1024), 1);
+        m_ring.resize(m_ringSize * m_recordSize);
 
-    if (!m_quiet)
-        clog << "# monitoring enabled, sampling "
-                  << m_sampler->GetBufferSize()
-                  << " bytes every "
-                  << m_tsdelay.tv_sec << '.'
-                  << setfill('0') << setw(9) << m_tsdelay.tv_nsec
-                  << "s to file " << outfile << endl
-                  << "# metadata output to file " << mdfile << endl;
+        // The ring is drained every millisecond
+        m_tsdelay.tv_sec = 0;
+        m_tsdelay.tv_nsec = 1000000;
+
+        if (!m_quiet)
+            clog << "# monitoring enabled, sampling "
+                 << m_sampler->GetBufferSize()
+                 << " bytes every "
+                 << m_sampleCycles
+                 << " cycles to file " << outfile << endl
+                 << "# metadata output to file " << mdfile << endl;
+    }
+    else
+    {
+        float msd = sys.GetKernel()->GetConfig()->getValue<float>("MonitorSampleDelay");
+        msd = fabs(msd);
+        m_tsdelay.tv_sec = msd;
+        m_tsdelay.tv_nsec = (msd - (float)m_tsdelay.tv_sec) * 1000000000.;
+
+        if (!m_quiet)
+            clog << "# monitoring enabled, sampling "
+                      << m_sampler->GetBufferSize()
+                      << " bytes every "
+                      << m_tsdelay.tv_sec << '.'
+                      << setfill('0') << setw(9) << m_tsdelay.tv_nsec
+                      << "s to file " << outfile << endl
+                      << "# metadata output to file " << mdfile << endl;
+    }
 
     m_monitorthread = new std::thread(runmonitor, this);
 
@@ -113,11 +143,23 @@ Monitor::~Monitor()
         if (!m_quiet)
             clog << "# shutting down monitoring..." << endl;
 
-        m_enabled = false;
-        m_runlock.unlock();
+        // Release: the records sampled before are visible to the
+        // monitor thread once it sees the flag cleared.
+        m_enabled.store(false, memory_order_release);
+        if (m_sampleCycles != 0)
+        {
+            m_sys.GetKernel()->SetCycleObserver(NULL, 0);
+        }
+        else
+        {
+            m_runlock.unlock();
+        }
         m_monitorthread->join();
         delete m_monitorthread;
 
+        if (!m_quiet && m_ringStalls != 0)
+            clog << "# simulation waited for the monitor on " << m_ringStalls << " samples." << endl;
+
         m_outputfile->close();
         delete m_outputfile;
         delete m_sampler;
@@ -132,7 +174,10 @@ void Monitor::start()
         if (!m_quiet)
             clog << "# starting monitor..." << endl;
         m_running = true;
-        m_runlock.unlock();
+        if (m_sampleCycles != 0)
+            m_sys.GetKernel()->SetCycleObserver(this, m_sampleCycles);
+        else
+            m_runlock.unlock();
     }
 }
 
@@ -141,35 +186,104 @@ void Monitor::stop()
     if (m_running) {
         if (!m_quiet)
             clog << "# stopping monitor..." << endl;
-        m_runlock.lock();
+        if (m_sampleCycles != 0)
+            m_sys.GetKernel()->SetCycleObserver(NULL, 0);
+        else
+            m_runlock.lock();
         m_running = false;
     }
 }
 
+static void sleepfor(const struct timespec& ts)
+{
+#if defined(HAVE_NANOSLEEP)
+    nanosleep(&ts, 0);
+#elif defined(HAVE_USLEEP)
+    usleep(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#else
+#error No sub-microsecond wait available on this system.
+#endif
+}
+
+void Monitor::sample(char* record)
+{
+    struct timeval *tv_begin = (struct timeval*)(void*)record;
+    struct timeval *tv_end = (struct timeval*)(void*)(record + sizeof(struct timeval));
+    char *databuf = record + 2 * sizeof(struct timeval);
+
+    gettimeofday(tv_begin, 0);
+    m_sampler->SampleToBuffer(databuf);
+    gettimeofday(tv_end, 0);
+}
+
+void Monitor::OnCycle(Simulator::CycleNo /*cycle*/)
+{
+    // Called by the simulation thread: fill the next record in the ring.
+    const size_t tail = m_ringTail.load(memory_order_relaxed);
+    if (tail - m_ringHead.load(memory_order_acquire) == m_ringSize)
+    {
+        // The ring is full; wait for the monitor thread to catch up.
+        ++m_ringStalls;
+        while (tail - m_ringHead.load(memory_order_acquire) == m_ringSize)
+            this_thread::yield();
+    }
+
+    sample(&m_ring[(tail % m_ringSize) * m_recordSize]);
+    m_ringTail.store(tail + 1, memory_order_release);
+}
+
 void Monitor::run()
 {
     if (!m_quiet)
         clog << "# monitor thread started." << endl;
 
-    const size_t datasz = m_sampler->GetBufferSize();
-    const size_t allsz = datasz + 2 * sizeof(struct timeval);
-    char *allbuf = new char[allsz];
+    if (m_sampleCycles != 0)
+        runCycles();
+    else
+        runTimed();
+}
+
+void Monitor::runCycles()
+{
+    for (;;)
+    {
+        // Read the flag before the ring, so that the records sampled
+        // before shutdown are all written out.
+        const bool enabled = m_enabled.load(memory_order_acquire);
 
-    struct timeval *tv_begin = (struct timeval*)(void*)allbuf;
-    struct timeval *tv_end = (struct timeval*)(void*)(allbuf + sizeof(struct timeval));
-    char *databuf = allbuf + 2 * sizeof(struct timeval);
+        size_t head = m_ringHead.load(memory_order_relaxed);
+        const size_t tail = m_ringTail.load(memory_order_acquire);
+        if (head == tail)
+        {
+            if (!enabled)
+                break;
+            sleepfor(m_tsdelay);
+            continue;
+        }
+
+        // Write out the available records, in at most two runs
+        // since the ring wraps around.
+        while (head != tail)
+        {
+            const size_t first = head % m_ringSize;
+            const size_t count = min(tail - head, m_ringSize - first);
+            m_outputfile->write(&m_ring[first * m_recordSize], count * m_recordSize);
+            head += count;
+            m_ringHead.store(head, memory_order_release);
+        }
+    }
+}
+
+void Monitor::runTimed()
+{
+    const size_t allsz = m_recordSize;
+    char *allbuf = new char[allsz];
 
     Simulator::CycleNo lastCycle = 0;
 
-    while (m_enabled)
+    while (m_enabled.load(memory_order_acquire))
     {
-#if defined(HAVE_NANOSLEEP)
-        nanosleep(&m_tsdelay, 0);
-#elif defined(HAVE_USLEEP)
-        usleep(m_tsdelay.tv_sec * 1000000 + m_tsdelay.tv_usec);
-#else
-#error No sub-microsecond wait available on this system.
-#endif
+        sleepfor(m_tsdelay);
 
         Simulator::CycleNo currentCycle = m_sys.GetKernel()->GetCycleNo();
         if (currentCycle == lastCycle)
@@ -179,9 +293,7 @@ void Monitor::run()
 
         m_runlock.lock();
 
-        gettimeofday(tv_begin, 0);
-        m_sampler->SampleToBuffer(databuf);
-        gettimeofday(tv_end, 0);
+        sample(allbuf);
 
         m_outputfile->write(allbuf, allsz);
 
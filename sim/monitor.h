@@ -2,18 +2,30 @@
 #ifndef MONITOR_H
 # define MONITOR_H
 
+#include "sim/kernel.h"
+
+#include <atomic>
 #include <fstream>
 #include <ctime>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 namespace Simulator {
     class MGSystem;
     class BinarySampler;
 }
 
-
-class Monitor
+/*
+  The monitor samples variables either every MonitorSampleDelay
+  seconds of host time, from the monitor thread; or every
+  MonitorSampleCycles simulated cycles, from the simulation thread at
+  the end of the cycle. In the latter case the samples are handed to
+  the monitor thread through a single-producer, single-consumer ring
+  of MonitorBufferSize records, and the monitor thread only writes
+  them out. The simulation waits if the ring is full.
+*/
+class Monitor : public Simulator::CycleObserver
 {
     Simulator::MGSystem&      m_sys;
     std::ofstream*            m_outputfile;
@@ -25,10 +37,21 @@ class Monitor
 
     bool                      m_quiet;
     bool                      m_running;
-    volatile bool             m_enabled;
+    std::atomic<bool>         m_enabled;      ///< Cleared by the simulation thread to stop the monitor thread
+
+    Simulator::CycleNo        m_sampleCycles; ///< Sampling period in cycles, 0 to sample on host time
+    size_t                    m_recordSize;   ///< Size of a record: timestamps and sample
+    std::vector<char>         m_ring;         ///< Records sampled by the simulation thread
+    size_t                    m_ringSize;     ///< Number of records in the ring
+    std::atomic<size_t>       m_ringHead;     ///< Number of records written out by the monitor thread
+    std::atomic<size_t>       m_ringTail;     ///< Number of records sampled by the simulation thread
+    uint64_t                  m_ringStalls;   ///< Number of samples that waited for room in the ring
 
     friend void* runmonitor(void*);
     void run();
+    void runTimed();
+    void runCycles();
+    void sample(char* record);
 
 public:
     Monitor(Simulator::MGSystem& sys, bool enable, const std::string& mdfile, const std::string& outfile, bool quiet);
@@ -38,6 +61,8 @@ public:
 
     void start();
     void stop();
+
+    void OnCycle(Simulator::CycleNo cycle) override;
 };
 
 #endif
@@ -1,4 +1,7 @@
+#include <cstdarg>
 #include <cstdio>
+#include <string>
+#include <vector>
 #include "sim/kernel.h"
 
 namespace Simulator
@@ -46,42 +49,73 @@ namespace Simulator
         }
     }
 
+    // Append printf-style formatted text to a string.
+    static void AppendFormatV(std::string& text, const char* msg, va_list args)
+    {
+        va_list copy;
+        va_copy(copy, args);
+        int size = vsnprintf(NULL, 0, msg, copy);
+        va_end(copy);
+        if (size > 0)
+        {
+            std::vector<char> buf(size + 1);
+            vsnprintf(&buf[0], buf.size(), msg, args);
+            text.append(&buf[0], size);
+        }
+    }
+
+    static void AppendFormat(std::string& text, const char* msg, ...)
+    {
+        va_list args;
+        va_start(args, msg);
+        AppendFormatV(text, msg, args);
+        va_end(args);
+    }
+
+    // The messages are written with Kernel::WriteOutput, so that they
+    // appear in the same order with the parallel kernel.
     void Object::OutputWrite_(const char* msg, ...) const
     {
         va_list args;
+        std::string text;
 
-        fprintf(stderr, "[%08lld:%s]\t\to ", (unsigned long long)GetKernel()->GetCycleNo(), GetName().c_str());
+        AppendFormat(text, "[%08lld:%s]\t\to ", (unsigned long long)GetKernel()->GetCycleNo(), GetName().c_str());
         va_start(args, msg);
-        vfprintf(stderr, msg, args);
+        AppendFormatV(text, msg, args);
         va_end(args);
-        fputc('\n', stderr);
+        text += '\n';
+        Kernel::WriteOutput(stderr, text);
     }
 
     void Object::DeadlockWrite_(const char* msg, ...) const
     {
         va_list args;
+        std::string text;
 
-        fprintf(stderr, "[%08lld:%s]\t(%s)\td ", (unsigned long long)GetKernel()->GetCycleNo(), GetName().c_str(),
-                GetKernel()->GetActiveProcess()->GetName().c_str());
+        AppendFormat(text, "[%08lld:%s]\t(%s)\td ", (unsigned long long)GetKernel()->GetCycleNo(), GetName().c_str(),
+                     GetKernel()->GetActiveProcess()->GetName().c_str());
         va_start(args, msg);
-        vfprintf(stderr, msg, args);
+        AppendFormatV(text, msg, args);
         va_end(args);
-        fputc('\n', stderr);
+        text += '\n';
+        Kernel::WriteOutput(stderr, text);
     }
 
     void Object::DebugSimWrite_(const char* msg, ...) const
     {
         va_list args;
+        std::string text;
 
-        fprintf(stderr, "[%08lld:%s]\t", (unsigned long long)GetKernel()->GetCycleNo(), GetName().c_str());
+        AppendFormat(text, "[%08lld:%s]\t", (unsigned long long)GetKernel()->GetCycleNo(), GetName().c_str());
         const Process *p = GetKernel()->GetActiveProcess();
         if (p)
-            fprintf(stderr, "(%s)", p->GetName().c_str());
-        fputc('\t', stderr);
+            AppendFormat(text, "(%s)", p->GetName().c_str());
+        text += '\t';
         va_start(args, msg);
-        vfprintf(stderr, msg, args);
+        AppendFormatV(text, msg, args);
         va_end(args);
-        fputc('\n', stderr);
+        text += '\n';
+        Kernel::WriteOutput(stderr, text);
     }
 
 
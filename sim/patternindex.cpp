@@ -0,0 +1,280 @@
+#include "sim/patternindex.h"
+
+#include <algorithm>
+#include <fnmatch.h>
+
+using namespace std;
+
+GlobPattern::GlobPattern(const string& pattern)
+    : m_pattern(pattern), m_tokens(), m_sets(), m_fallback(false)
+{
+    if (!compile())
+    {
+        m_tokens.clear();
+        m_sets.clear();
+        m_fallback = true;
+    }
+}
+
+bool GlobPattern::compile()
+{
+    const string& p = m_pattern;
+    for (size_t i = 0; i < p.size(); ++i)
+    {
+        Token t;
+        t.c   = 0;
+        t.set = 0;
+        switch (p[i])
+        {
+        case '*':
+            if (!m_tokens.empty() && m_tokens.back().kind == Token::STAR)
+                continue;
+            t.kind = Token::STAR;
+            break;
+
+        case '?':
+            t.kind = Token::ANY;
+            break;
+
+        case '\\':
+            if (++i == p.size())
+                return false;
+            t.kind = Token::CHAR;
+            t.c    = p[i];
+            break;
+
+        case '[':
+        {
+            bitset<256> set;
+            size_t j = i + 1;
+            const bool negate = (j < p.size() && (p[j] == '!' || p[j] == '^'));
+            if (negate)
+                ++j;
+
+            // A ']' first in the set is a member
+            bool first = true;
+            for (; j < p.size() && (first || p[j] != ']'); ++j, first = false)
+            {
+                unsigned char lo = p[j];
+                if (lo == '[' && j + 1 < p.size() && (p[j+1] == ':' || p[j+1] == '.' || p[j+1] == '='))
+                    return false; // Character classes and collating symbols
+                if (lo == '\\')
+                {
+                    if (++j == p.size())
+                        return false;
+                    lo = p[j];
+                }
+
+                unsigned char hi = lo;
+                if (j + 2 < p.size() && p[j+1] == '-' && p[j+2] != ']')
+                {
+                    j += 2;
+                    hi = p[j];
+                    if (hi == '\\')
+                    {
+                        if (++j == p.size())
+                            return false;
+                        hi = p[j];
+                    }
+                    if (hi == '[')
+                        return false;
+                }
+                for (unsigned c = lo; c <= hi; ++c)
+                    set[c] = true;
+            }
+            if (j == p.size())
+                return false; // Unterminated set
+
+            if (negate)
+                set.flip();
+            t.kind = Token::SET;
+            t.set  = m_sets.size();
+            m_sets.push_back(set);
+            i = j;
+            break;
+        }
+
+        default:
+            t.kind = Token::CHAR;
+            t.c    = p[i];
+            break;
+        }
+        m_tokens.push_back(t);
+    }
+    return true;
+}
+
+bool GlobPattern::match(const string& name) const
+{
+    if (m_fallback)
+        return fnmatch(m_pattern.c_str(), name.c_str(), 0) != FNM_NOMATCH;
+
+    // Linear matching with backtracking to the last star only, which
+    // is sufficient since a later star can match anything an earlier
+    // one would have had to.
+    const size_t np = m_tokens.size();
+    size_t p = 0, n = 0;
+    size_t star = np, mark = 0;
+    while (n < name.size())
+    {
+        if (p < np && m_tokens[p].kind == Token::STAR)
+        {
+            star = p++;
+            mark = n;
+            continue;
+        }
+
+        if (p < np)
+        {
+            const Token& t = m_tokens[p];
+            const unsigned char c = name[n];
+            bool ok;
+            switch (t.kind)
+            {
+            case Token::CHAR: ok = (t.c == c); break;
+            case Token::SET:  ok = m_sets[t.set][c]; break;
+            default:          ok = true; break;
+            }
+            if (ok)
+            {
+                ++p;
+                ++n;
+                continue;
+            }
+        }
+
+        if (star == np)
+            return false;
+
+        // Let the last star match one more character
+        p = star + 1;
+        n = ++mark;
+    }
+
+    while (p < np && m_tokens[p].kind == Token::STAR)
+        ++p;
+    return p == np;
+}
+
+string GlobPattern::literalPrefix() const
+{
+    string s;
+    for (auto& t : m_tokens)
+    {
+        if (t.kind != Token::CHAR)
+            break;
+        s += (char)t.c;
+    }
+    return s;
+}
+
+string GlobPattern::literalSuffix() const
+{
+    string s;
+    for (auto t = m_tokens.rbegin(); t != m_tokens.rend() && t->kind == Token::CHAR; ++t)
+        s += (char)t->c;
+    reverse(s.begin(), s.end());
+    return s;
+}
+
+bool GlobPattern::isLiteral() const
+{
+    if (m_fallback)
+        return false;
+    for (auto& t : m_tokens)
+        if (t.kind != Token::CHAR)
+            return false;
+    return true;
+}
+
+PatternIndex::PatternIndex()
+    : m_patterns(), m_prefixes(), m_literals(), m_nodes(1), m_candidates()
+{
+}
+
+void PatternIndex::clear()
+{
+    m_patterns.clear();
+    m_prefixes.clear();
+    m_literals.clear();
+    m_nodes.assign(1, Node());
+}
+
+void PatternIndex::add(const string& pattern)
+{
+    const size_t index = m_patterns.size();
+    m_patterns.push_back(GlobPattern(pattern));
+    const GlobPattern& glob = m_patterns.back();
+
+    if (glob.isLiteral())
+    {
+        m_prefixes.push_back(string());
+        m_literals[glob.literalPrefix()] = index;
+        return;
+    }
+    m_prefixes.push_back(glob.literalPrefix());
+
+    // Insert the suffix backwards into the trie
+    const string suffix = glob.literalSuffix();
+    size_t node = 0;
+    for (auto c = suffix.rbegin(); c != suffix.rend(); ++c)
+    {
+        auto& children = m_nodes[node].children;
+        auto child = find_if(children.begin(), children.end(),
+                             [c](const pair<char, size_t>& e) { return e.first == *c; });
+        if (child != children.end())
+        {
+            node = child->second;
+        }
+        else
+        {
+            m_nodes[node].children.push_back(make_pair(*c, m_nodes.size()));
+            node = m_nodes.size();
+            m_nodes.push_back(Node());
+        }
+    }
+    m_nodes[node].patterns.push_back(index);
+}
+
+size_t PatternIndex::find(const string& name) const
+{
+    size_t best = npos;
+    auto lit = m_literals.find(name);
+    if (lit != m_literals.end())
+    {
+        best = lit->second;
+    }
+
+    // Collect the wildcard patterns whose suffix ends the name
+    m_candidates.clear();
+    size_t node = 0;
+    for (size_t i = name.size(); ; --i)
+    {
+        const Node& n = m_nodes[node];
+        m_candidates.insert(m_candidates.end(), n.patterns.begin(), n.patterns.end());
+        if (i == 0)
+            break;
+
+        auto child = find_if(n.children.begin(), n.children.end(),
+                             [&](const pair<char, size_t>& e) { return e.first == name[i - 1]; });
+        if (child == n.children.end())
+            break;
+        node = child->second;
+    }
+
+    // Test them by decreasing priority
+    sort(m_candidates.begin(), m_candidates.end(), greater<size_t>());
+    for (size_t c : m_candidates)
+    {
+        if (best != npos && c < best)
+            break;
+
+        const string& prefix = m_prefixes[c];
+        if (name.compare(0, prefix.size(), prefix) == 0 && m_patterns[c].match(name))
+        {
+            best = c;
+            break;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,91 @@
+// -*- c++ -*-
+#ifndef PATTERNINDEX_H
+#define PATTERNINDEX_H
+
+#include <bitset>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// GlobPattern: a shell pattern compiled for matching.
+//
+// The semantics are those of fnmatch() without flags: '*' and '?'
+// also match '/' and '.', "[...]" matches a set of characters with
+// ranges and negation by '!' or '^', and a backslash quotes the next
+// character. Patterns that use other features (eg. character classes
+// like "[:alpha:]") are matched with fnmatch().
+//
+class GlobPattern
+{
+    struct Token
+    {
+        enum Kind { CHAR, ANY, STAR, SET } kind;
+        unsigned char c;    ///< For CHAR: the character
+        size_t        set;  ///< For SET: index in m_sets
+    };
+
+    std::string                   m_pattern;
+    std::vector<Token>            m_tokens;
+    std::vector<std::bitset<256>> m_sets;
+    bool                          m_fallback; ///< Use fnmatch() instead of the tokens
+
+    bool compile();
+
+public:
+    explicit GlobPattern(const std::string& pattern);
+
+    bool match(const std::string& name) const;
+
+    const std::string& str() const { return m_pattern; }
+
+    // The text before the first special character, and after the
+    // last one. Both are the whole pattern for a literal.
+    std::string literalPrefix() const;
+    std::string literalSuffix() const;
+    bool isLiteral() const;
+};
+
+/// PatternIndex: finds the pattern of highest priority that matches
+// a name, among many patterns.
+//
+// Configuration keys have the form "component:Key" and nearly all
+// patterns end with the literal key name, with globs in the component
+// part. The index therefore keeps the wildcard patterns in a trie of
+// their literal suffixes, read backwards: walking the trie with the
+// end of a name yields the few patterns that can match it, which are
+// then tested by decreasing priority. Literal patterns are found
+// with a hash table.
+//
+class PatternIndex
+{
+    struct Node
+    {
+        std::vector<std::pair<char, size_t> > children;
+        std::vector<size_t>                   patterns; ///< Indices in m_patterns ending here
+
+        Node() : children(), patterns() {}
+    };
+
+    std::vector<GlobPattern>                m_patterns;   ///< By priority
+    std::vector<std::string>                m_prefixes;   ///< Literal prefix of each pattern
+    std::unordered_map<std::string, size_t> m_literals;   ///< Highest priority literal pattern by name
+    std::vector<Node>                       m_nodes;      ///< Suffix trie; the first node is the root
+    mutable std::vector<size_t>             m_candidates; ///< Scratch space for find()
+
+public:
+    static const size_t npos = (size_t)-1;
+
+    PatternIndex();
+
+    // Adds a pattern; patterns added later have a higher priority.
+    void add(const std::string& pattern);
+    void clear();
+    size_t size() const { return m_patterns.size(); }
+
+    // Returns the index, in order of addition, of the pattern of
+    // highest priority that matches name, or npos if none does.
+    size_t find(const std::string& name) const;
+};
+
+#endif
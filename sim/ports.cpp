@@ -18,11 +18,19 @@ namespace Simulator
                                                  SVC_CUMULATIVE);
     }
 
+    void ArbitratedProcessSet::Add(const Process& process)
+    {
+        assert(Find(process) == npos);
+        m_indices[&process] = m_processes.size();
+        m_processes.push_back(&process);
+        m_requests.resize((m_processes.size() + WORD_BITS - 1) / WORD_BITS, 0);
+    }
+
     SimpleArbitratedPort::SimpleArbitratedPort(Kernel& k, const string& name)
         : ArbitratedPort(k, name),
           m_processes(),
-          m_requests(),
-          m_lastrequest((CycleNo)-1)
+          m_lastrequest((CycleNo)-1),
+          m_lock()
     {
         k.GetVariableRegistry().RegisterVariable(m_lastrequest,
                                                  GetName() + ":lastrequest",
@@ -31,17 +39,13 @@ namespace Simulator
 
     void SimpleArbitratedPort::AddProcess(const Process& process)
     {
-        assert(find(m_processes.begin(),
-                    m_processes.end(),
-                    &process) == m_processes.end());
-        m_processes.push_back(&process);
+        m_processes.Add(process);
     }
 
-    void SimpleArbitratedPort::AddRequest(const Process& process, CycleNo c)
+    bool SimpleArbitratedPort::AddRequest(ArbitratedProcessSet& set, size_t index, CycleNo c)
     {
-        if (find(m_requests.begin(),
-                 m_requests.end(),
-                 &process) != m_requests.end())
+        lock_guard<SpinLock> guard(m_lock);
+        if (set.HasRequested(index))
         {
             // A process can request more than once in an arbitrator cycle
             // if the requester is in a higher frequency domain than the
@@ -49,10 +53,19 @@ namespace Simulator
             // However the same process cannot request more than once
             // in the same cycle.
             assert(c != m_lastrequest);
-            return;
+            return false;
         }
-        m_requests.push_back(&process);
+        set.AddRequest(index);
         m_lastrequest = c;
+        return true;
+    }
+
+    size_t SimpleArbitratedPort::AddRequest(const Process& process, CycleNo c)
+    {
+        size_t index = m_processes.Find(process);
+        assert(index != ArbitratedProcessSet::npos);
+        AddRequest(m_processes, index, c);
+        return index;
     }
 
     PriorityArbitratedPort::PriorityArbitratedPort(Kernel& k,
@@ -65,30 +78,10 @@ namespace Simulator
     void PriorityArbitratedPort::Arbitrate()
     {
         SetSelectedProcess(NULL);
-        if (m_requests.empty()) return;
+        if (!m_processes.HasRequests()) return;
 
-        if (m_requests.size() == 1)
-        {
-            // Optimization for common case
-            SetSelectedProcess(*m_requests.begin());
-        }
-        else
-        {
-            // Choose the request with the highest priority
-            auto min = m_processes.size();
-            for (auto i : m_requests)
-            {
-                // The position in the vector is its priority
-                size_t priority = find(m_processes.begin(), m_processes.end(), i) - m_processes.begin();
-                if (priority < min)
-                {
-                    min = priority;
-                    SetSelectedProcess(i);
-                }
-            }
-        }
-        assert(GetSelectedProcess() != NULL);
-        m_requests.clear();
+        SetSelectedProcess(m_processes[m_processes.FindRequest(0)]);
+        m_processes.ClearRequests();
         MarkBusy();
     }
 
@@ -102,49 +95,19 @@ namespace Simulator
     }
 
     // Select a process that acquires the port.
-    // Every process gets a turn.
+    // Every process gets a turn: the first requester after the
+    // last selected one wins, and the last selected one only
+    // when it is the sole requester.
     void CyclicArbitratedPort::Arbitrate()
     {
         assert(m_lastSelected < m_processes.size());
 
         SetSelectedProcess(NULL);
-        if (m_requests.empty()) return;
+        if (!m_processes.HasRequests()) return;
 
-        if (m_requests.size() == 1)
-        {
-            SetSelectedProcess(*m_requests.begin());
-            m_lastSelected = find(m_processes.begin(),
-                                  m_processes.end(),
-                                  GetSelectedProcess()) - m_processes.begin();
-        }
-        else
-        {
-            auto sz = m_processes.size();
-            auto min = sz;
-            for (auto i : m_requests)
-            {
-                // pos = position of the requesting process in the
-                // list of all processes.
-                auto pos = find(m_processes.begin(),
-                                m_processes.end(),
-                                i) - m_processes.begin();
-
-                // Compute the distance between the requesting process
-                // and the last selected.
-                auto d = (pos + sz - m_lastSelected) % sz;
-                if (d != 0 && d < min)
-                {
-                    // Different process, shortest distance, select
-                    // this one.
-                    min = d;
-                    SetSelectedProcess(i);
-                }
-            }
-            // Remember which one we selected
-            m_lastSelected = (m_lastSelected + min) % sz;
-        }
-        assert(GetSelectedProcess() != NULL);
-        m_requests.clear();
+        m_lastSelected = m_processes.FindNextRequest(m_lastSelected);
+        SetSelectedProcess(m_processes[m_lastSelected]);
+        m_processes.ClearRequests();
         MarkBusy();
     }
 
@@ -154,76 +117,42 @@ namespace Simulator
           m_cyclicprocesses()
     {}
 
+    void PriorityCyclicArbitratedPort::AddRequest(const Process& process, CycleNo c)
+    {
+        size_t index = m_processes.Find(process);
+        if (index != ArbitratedProcessSet::npos)
+        {
+            SimpleArbitratedPort::AddRequest(m_processes, index, c);
+        }
+        else
+        {
+            index = m_cyclicprocesses.Find(process);
+            assert(index != ArbitratedProcessSet::npos);
+            SimpleArbitratedPort::AddRequest(m_cyclicprocesses, index, c);
+        }
+    }
+
     void PriorityCyclicArbitratedPort::Arbitrate()
     {
         SetSelectedProcess(NULL);
-        if (m_requests.empty()) return;
-
-        if (m_requests.size() == 1)
+        if (m_processes.HasRequests())
         {
-            // Optimization for common case
-            SetSelectedProcess(*m_requests.begin());
-
-            // If we just selected a cyclic process, remember it for
-            // the next round of cyclic arbitration.
-            size_t maybe_cyclic_last = find(m_cyclicprocesses.begin(),
-                                            m_cyclicprocesses.end(),
-                                            GetSelectedProcess()) - m_cyclicprocesses.begin();
-            if (maybe_cyclic_last < m_cyclicprocesses.size())
-                m_lastSelected = maybe_cyclic_last;
+            // Priority processes go first, by order of priority.
+            SetSelectedProcess(m_processes[m_processes.FindRequest(0)]);
+        }
+        else if (m_cyclicprocesses.HasRequests())
+        {
+            // Otherwise the cyclic processes take turns; remember
+            // which one was selected for the next round.
+            m_lastSelected = m_cyclicprocesses.FindNextRequest(m_lastSelected);
+            SetSelectedProcess(m_cyclicprocesses[m_lastSelected]);
         }
         else
         {
-            // First try to select using priorities.
-            auto sz = m_processes.size();
-            auto min = sz;
-            for (auto i : m_requests)
-            {
-                // The position in the vector is its priority
-                size_t priority = find(m_processes.begin(), m_processes.end(), i) - m_processes.begin();
-                if (priority == sz)
-                {
-                    // this request is for a cyclic process, don't use
-                    // it as a candidate.
-                    continue;
-                }
-                if (priority < min)
-                {
-                    min = priority;
-                    SetSelectedProcess(i);
-                }
-            }
-
-            if (min == sz)
-            {
-                // no priority process found, the request is for a
-                // cyclic process.
-                min = sz = m_cyclicprocesses.size();
-                for (auto i : m_requests)
-                {
-                    // pos = position of the requesting process in the
-                    // list of all processes.
-                    auto pos = find(m_cyclicprocesses.begin(),
-                                    m_cyclicprocesses.end(),
-                                    i) - m_cyclicprocesses.begin();
-
-                    // Find the distance between the requesting process
-                    // and the last selected
-                    auto d = (pos + sz - m_lastSelected) % sz;
-                    if (d != 0 && d < min)
-                    {
-                        // Different process, shortest distance,
-                        // select this one.
-                        min = d;
-                        SetSelectedProcess(i);
-                    }
-                }
-                // Remember which one we selected
-                m_lastSelected = (m_lastSelected + min) % sz;
-            }
+            return;
         }
-        assert(GetSelectedProcess() != NULL);
-        m_requests.clear();
+        m_processes.ClearRequests();
+        m_cyclicprocesses.ClearRequests();
         MarkBusy();
     }
 
@@ -3,11 +3,13 @@
 #define PORTS_H
 
 #include "kernel.h"
+#include "workerpool.h"
 #include <cassert>
 #include <algorithm>
 #include <map>
 #include <set>
 #include <limits>
+#include <unordered_map>
 
 namespace Simulator
 {
@@ -62,6 +64,101 @@ namespace Simulator
         const std::string& GetName() const { return m_name; }
     };
 
+    //
+    // ArbitratedProcessSet: the processes that may access a port,
+    // numbered densely in registration order, and the set of those
+    // that have requested access within a cycle.
+    //
+    // The requests are kept as a bit set over the process indices, so
+    // that arbitration finds the lowest or the next requester with
+    // find-first-set over a few words instead of scanning the
+    // requests. The index of a process is looked up linearly for the
+    // few processes of most ports, and through a hash table for ports
+    // shared by many processes (eg. the delegation network input).
+    //
+    class ArbitratedProcessSet
+    {
+        typedef uint64_t Word;
+        static const size_t WORD_BITS = 64;
+        static const size_t MAX_LINEAR_LOOKUP = 8;
+
+        std::vector<const Process*>                    m_processes;
+        std::unordered_map<const Process*, size_t>     m_indices;
+        std::vector<Word>                              m_requests;
+        size_t                                         m_numRequests;
+
+    public:
+        static const size_t npos = (size_t)-1;
+
+        // Register a process, which gets the next index.
+        void Add(const Process& process);
+
+        // The index of a process, or npos if it is not registered.
+        size_t Find(const Process& process) const
+        {
+            if (m_processes.size() <= MAX_LINEAR_LOOKUP)
+            {
+                for (size_t i = 0; i < m_processes.size(); ++i)
+                    if (m_processes[i] == &process)
+                        return i;
+                return npos;
+            }
+            auto p = m_indices.find(&process);
+            return (p == m_indices.end()) ? npos : p->second;
+        }
+
+        size_t         size()              const { return m_processes.size(); }
+        const Process* operator[](size_t i) const { return m_processes[i]; }
+
+        // Request set operations
+        bool   HasRequests()           const { return m_numRequests != 0; }
+        size_t GetNumRequests()        const { return m_numRequests; }
+        bool   HasRequested(size_t i)  const { return (m_requests[i / WORD_BITS] >> (i % WORD_BITS)) & 1; }
+
+        void AddRequest(size_t i)
+        {
+            m_requests[i / WORD_BITS] |= (Word)1 << (i % WORD_BITS);
+            ++m_numRequests;
+        }
+
+        void ClearRequests()
+        {
+            if (m_numRequests != 0)
+            {
+                std::fill(m_requests.begin(), m_requests.end(), 0);
+                m_numRequests = 0;
+            }
+        }
+
+        // The lowest requesting index at or after from, or npos.
+        size_t FindRequest(size_t from) const
+        {
+            size_t w = from / WORD_BITS;
+            if (w >= m_requests.size())
+                return npos;
+            Word bits = m_requests[w] & (~(Word)0 << (from % WORD_BITS));
+            while (bits == 0)
+            {
+                if (++w == m_requests.size())
+                    return npos;
+                bits = m_requests[w];
+            }
+            return w * WORD_BITS + __builtin_ctzll(bits);
+        }
+
+        // The first requesting index after last in cyclic order,
+        // wrapping around to last itself. There must be a request.
+        size_t FindNextRequest(size_t last) const
+        {
+            size_t i = FindRequest(last + 1);
+            return (i != npos) ? i : FindRequest(0);
+        }
+
+        ArbitratedProcessSet()
+            : m_processes(), m_indices(), m_requests(), m_numRequests(0)
+        {}
+    };
+
     //
     // SimpleArbitratedPort: simple base class for ports using a
     // simple list of processes.
@@ -73,18 +170,22 @@ namespace Simulator
     class SimpleArbitratedPort : public ArbitratedPort
     {
     protected:
-        typedef std::vector<const Process*> ProcessList;
-
-        // The list of all processes that *may* access the port.
-        ProcessList    m_processes;
-
-        // The list of all processes that have requested access within
-        // this cycle.
-        ProcessList    m_requests;
+        // The processes that *may* access the port, and those that
+        // have requested access within this cycle.
+        ArbitratedProcessSet m_processes;
 
         // The last cycle counter of a request.
         CycleNo        m_lastrequest;
 
+        // Protects the requests when processes run on multiple host
+        // threads (see Kernel::SetNumThreads).
+        SpinLock       m_lock;
+
+        // Register a request by the process with the given index in
+        // the set. Returns false if the process had already requested
+        // in this arbitrator cycle.
+        bool AddRequest(ArbitratedProcessSet& set, size_t index, CycleNo c);
+
     public:
         // Register a process that may access the port.
         void AddProcess(const Process& process);
@@ -93,14 +194,12 @@ namespace Simulator
         // Test if a process may access the port.
         bool CanAccess(const Process& process) const
         {
-            return std::find(m_processes.begin(),
-                             m_processes.end(),
-                             &process) != m_processes.end();
+            return m_processes.Find(process) != ArbitratedProcessSet::npos;
         }
 
         // Register a process as wanting to access the port (candidate for
-        // arbitration).
-        void AddRequest(const Process& process, CycleNo c);
+        // arbitration). Returns the index of the process.
+        size_t AddRequest(const Process& process, CycleNo c);
 
         // Constructor, destructor etc.
         SimpleArbitratedPort(Kernel&, const std::string& name);
@@ -176,16 +275,18 @@ namespace Simulator
     {
     protected:
         // The set of cyclic processes (that have lowest priority)
-        ProcessList m_cyclicprocesses;
+        ArbitratedProcessSet m_cyclicprocesses;
 
         // Test if a process may access the port.
         bool CanAccess(const Process& process) const {
             return SimpleArbitratedPort::CanAccess(process)
-                || (std::find(m_cyclicprocesses.begin(),
-                              m_cyclicprocesses.end(),
-                              &process) != m_cyclicprocesses.end());
+                || m_cyclicprocesses.Find(process) != ArbitratedProcessSet::npos;
         }
 
+        // Register a priority or cyclic process as wanting to access
+        // the port.
+        void AddRequest(const Process& process, CycleNo c);
+
     private:
         // hide AddProcess from base class to force use
         // of AddPriorityProcess below;
@@ -199,7 +300,7 @@ namespace Simulator
             SimpleArbitratedPort::AddProcess(process);
         }
         void AddCyclicProcess(const Process& process) {
-            m_cyclicprocesses.push_back(&process);
+            m_cyclicprocesses.Add(process);
         }
 
     protected:
@@ -541,18 +642,19 @@ namespace Simulator
         : public PriorityArbitratedPort,
           public WritePort<I>
     {
-        typedef std::map<const Process*, I> IndexMap;
-
         ReadWriteStructure<I>& m_structure;
-        IndexMap               m_indices;
+        std::vector<I>         m_indices;   ///< Per process index, the requested index
 
     protected:
         // Register a request to access the structure for
         // write.
         void AddRequest(const Process& process, const I& index, CycleNo c)
         {
-            PriorityArbitratedPort::AddRequest(process, c);
-            m_indices[&process] = index;
+            size_t i = PriorityArbitratedPort::AddRequest(process, c);
+            std::lock_guard<SpinLock> guard(m_lock);
+            if (m_indices.size() < m_processes.size())
+                m_indices.resize(m_processes.size());
+            m_indices[i] = index;
         }
 
     public:
@@ -584,14 +686,13 @@ namespace Simulator
         void Arbitrate()
         {
             PriorityArbitratedPort::Arbitrate();
-            auto process = GetSelectedProcess();
-            if (process != NULL)
+            if (GetSelectedProcess() != NULL)
             {
                 // A process was selected; make its index active for
                 // write port arbitration
-                auto p = m_indices.find(process);
-                assert(p != m_indices.end());
-                WritePort<I>::SetRequestIndex(p->second);
+                size_t i = m_processes.Find(*GetSelectedProcess());
+                assert(i < m_indices.size());
+                WritePort<I>::SetRequestIndex(m_indices[i]);
             }
         }
 
@@ -4,8 +4,8 @@
 
 namespace Simulator
 {
-    static std::string&& renameProcess(std::string cname,
-                                       const std::string& pname)
+    static std::string renameProcess(std::string cname,
+                                      const std::string& pname)
     {
         assert(pname.size() > 0);
         size_t i = 0;
@@ -24,7 +24,7 @@ namespace Simulator
             else
                 cname += pname[i];
         }
-        return std::move(cname);
+        return cname;
     }
 
 
@@ -35,10 +35,17 @@ namespace Simulator
           m_activations(0),
           m_next(0),
           m_pPrev(0),
-          m_stalls(0)
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
-        , m_storages(),
-          m_currentStorages()
+          m_stalls(0),
+          m_parent(parent),
+          m_profile(),
+          m_partition(0),
+          m_accesses(),
+          m_writes(),
+          m_domains()
+#if !defined(DISABLE_TRACE_CHECKS)
+        , m_traces(),
+          m_traceState(StorageTraceAutomaton::START),
+          m_invalidTrace()
 #endif
     {
         auto& kernel = *parent.GetKernel();
@@ -8,6 +8,7 @@
 
 #include <string>
 #include <type_traits>
+#include <vector>
 #include "sim/storagetrace.h"
 
 namespace Simulator
@@ -61,10 +62,17 @@ namespace Simulator
         Process**         m_pPrev;         ///< Prev pointer in the list of processes that require updates
 
         uint64_t          m_stalls;        ///< Number of times the process stalled (failed).
-
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
-        StorageTraceSet   m_storages;         ///< Set of storage traces this process can have
-        StorageTrace      m_currentStorages;  ///< Storage trace for this cycle
+        const Object&     m_parent;        ///< The component of this process.
+        ProfileCounter    m_profile;       ///< Host time of the delegate (see Kernel::SetProfiling).
+        size_t            m_partition;     ///< Partition of this process in the parallel kernel.
+        std::vector<size_t>         m_accesses; ///< Partitions declared with Kernel::DeclareAccess.
+        std::vector<const Storage*> m_writes;   ///< Storages in the storage traces.
+        std::vector<size_t>         m_domains;  ///< Partitions ordering this process, see Kernel::Partition.
+
+#if !defined(DISABLE_TRACE_CHECKS)
+        StorageTraceAutomaton        m_traces;       ///< Storage traces this process can have
+        StorageTraceAutomaton::State m_traceState;   ///< Position in m_traces for this cycle
+        StorageTrace                 m_invalidTrace; ///< Storage trace for this cycle, once rejected
 #endif
 
         // Processes are non-copyable and non-assignable
@@ -79,6 +87,8 @@ namespace Simulator
         const Process* GetNext() const { return m_next;  }
         RunState GetState() const { return m_state; }
         const std::string& GetName() const { return m_name; }
+        const Object& GetParent() const { return m_parent; }
+        const ProfileCounter& GetProfile() const { return m_profile; }
 
         // Deactivate a process from receiving invocations from its
         // clock. Used by storages (cf storage.h) when they become empty.
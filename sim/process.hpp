@@ -6,12 +6,21 @@
 #endif
 
 #include <cassert>
+#include <cstdlib>
 
 namespace Simulator
 {
     inline
     void Process::Deactivate()
     {
+        if (Kernel::IsParallelPhase())
+        {
+            // The list of active processes is shared; the parallel
+            // kernel removes the process at the end of the phase.
+            Kernel::DeferProcessActivation(NULL, *this);
+            return;
+        }
+
         // A process can be sensitive to multiple objects, so we only
         // remove it from the list if the count becomes zero.
         if (--m_activations == 0)
@@ -27,46 +36,40 @@ namespace Simulator
 
     inline
     void Process::OnBeginCycle() {
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
-        m_currentStorages.clear();
+#if !defined(DISABLE_TRACE_CHECKS)
+        m_traceState = StorageTraceAutomaton::START;
 #endif
     }
 
     inline
     void Process::OnEndCycle() const {
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
+#if !defined(DISABLE_TRACE_CHECKS)
         // Check if the process accessed storages in a way that isn't allowed
-        if (!m_storages.Contains(m_currentStorages))
+        if (!m_traces.Accepts(m_traceState))
         {
             std::cerr << std::endl
-                      << "Invalid access by " << GetName() << ": " << m_currentStorages << std::endl;
+                      << "Invalid access by " << GetName() << ": "
+                      << (m_traceState == StorageTraceAutomaton::REJECT ? m_invalidTrace : m_traces.GetTrace(m_traceState))
+                      << std::endl;
 #ifdef VERBOSE_TRACE_CHECKS
             std::cerr << "Allowed traces:" << std::endl
-                      << m_storages;
+                      << m_traces;
 #endif
 #ifdef ABORT_ON_TRACE_FAILURE
-            assert(false);
+            std::abort();
 #endif
         };
 #endif
     }
 
-    inline
-    void Process::OnStorageAccess(const Storage& s)
-    {
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
-        m_currentStorages.Append(s);
-#else
-        (void)s;
-#endif
-    }
+    // Process::OnStorageAccess is defined in storage.hpp, as it needs
+    // the storage's trace identifier.
 
     inline
     void Process::SetStorageTraces(const StorageTraceSet& sl) {
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
-        m_storages = sl;
-#else
-        (void)sl;
+        m_parent.GetKernel()->SetStorageWrites(*this, sl);
+#if !defined(DISABLE_TRACE_CHECKS)
+        m_traces.Compile(sl);
 #endif
     }
 
@@ -0,0 +1,147 @@
+#include "sim/kernel.h"
+#include "sim/storage.h"
+#include "sim/getclassname.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <fnmatch.h>
+
+using namespace std;
+
+namespace Simulator
+{
+    static uint64_t ReadHostNanos()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Kernel::SetProfiling(bool enable)
+    {
+        if (enable && m_profileTicks == 0)
+        {
+            // Reference point to calibrate the tick rate against the
+            // wall clock when the profile is printed.
+            m_profileTicks = ReadHostTicks();
+            m_profileNanos = ReadHostNanos();
+        }
+        m_profiling = enable;
+    }
+
+    namespace
+    {
+        struct ProfileRow
+        {
+            const char*    kind;
+            string         name;
+            string         cls;
+            ProfileCounter count;
+            size_t         instances;
+        };
+
+        bool MoreTime(const ProfileRow& a, const ProfileRow& b)
+        {
+            return a.count.ticks > b.count.ticks ||
+                (a.count.ticks == b.count.ticks && a.name < b.name);
+        }
+
+        string ComponentClass(const type_info& info)
+        {
+            string name = GetClassName(info);
+            const string ns = "Simulator::";
+            for (size_t p; (p = name.find(ns)) != string::npos; )
+                name.erase(p, ns.size());
+            return name;
+        }
+
+        void PrintRows(ostream& os, const vector<ProfileRow>& rows, size_t limit,
+                       double nsPerTick, HostTicks total, bool byClass)
+        {
+            os << "# kind              calls   time (us)   ns/call  %time  "
+               << (byClass ? "class (instances)" : "name") << endl;
+            for (size_t i = 0; i < rows.size() && (limit == 0 || i < limit); ++i)
+            {
+                const ProfileRow& r = rows[i];
+                const double ns = r.count.ticks * nsPerTick;
+                os << left << setw(11) << r.kind << right
+                   << setw(14) << r.count.calls
+                   << setw(12) << fixed << setprecision(0) << ns / 1000
+                   << setw(10) << setprecision(1) << (r.count.calls ? ns / r.count.calls : 0.)
+                   << setw(7) << setprecision(1) << (total ? 100. * r.count.ticks / total : 0.)
+                   << "  " << (byClass ? r.cls : r.name);
+                if (byClass)
+                    os << " (" << r.instances << ")";
+                os << endl;
+            }
+            if (limit != 0 && rows.size() > limit)
+                os << "# (" << rows.size() - limit << " more rows omitted)" << endl;
+        }
+    }
+
+    void Kernel::PrintProfile(ostream& os, const string& pattern, size_t limit) const
+    {
+        if (m_profileTicks == 0)
+        {
+            os << "Host time profiling is disabled; enable it with KernelProfile = true." << endl;
+            return;
+        }
+
+        vector<ProfileRow> rows;
+        for (const Process* p : m_proc_registry)
+        {
+            if (p->m_profile.calls != 0)
+                rows.push_back({"process", p->GetName(), ComponentClass(typeid(p->GetParent())), p->m_profile, 1});
+        }
+        for (const Arbitrator* a : m_profiledArbitrators)
+        {
+            rows.push_back({"arbitrator", a->GetName(), ComponentClass(typeid(*a)), a->m_profile, 1});
+        }
+        for (const Storage* s : m_profiledStorages)
+        {
+            rows.push_back({"storage", s->GetName(), ComponentClass(typeid(*s)), s->m_profile, 1});
+        }
+
+        HostTicks total = 0;
+        for (auto& r : rows)
+            total += r.count.ticks;
+
+        // Keep the matching rows, and total them by component class.
+        vector<ProfileRow> classes;
+        map<pair<string, string>, size_t> index;
+        size_t n = 0;
+        for (auto& r : rows)
+        {
+            if (FNM_NOMATCH == fnmatch(pattern.c_str(), r.name.c_str(), 0))
+                continue;
+
+            auto i = index.insert(make_pair(make_pair(string(r.kind), r.cls), classes.size()));
+            if (i.second)
+                classes.push_back({r.kind, r.cls, r.cls, ProfileCounter(), 0});
+            ProfileRow& c = classes[i.first->second];
+            c.count.ticks += r.count.ticks;
+            c.count.calls += r.count.calls;
+            ++c.instances;
+
+            rows[n++] = r;
+        }
+        rows.erase(rows.begin() + n, rows.end());
+        sort(rows.begin(), rows.end(), MoreTime);
+        sort(classes.begin(), classes.end(), MoreTime);
+
+        const HostTicks ticks = ReadHostTicks() - m_profileTicks;
+        const uint64_t  nanos = ReadHostNanos() - m_profileNanos;
+        const double nsPerTick = (ticks != 0) ? (double)nanos / ticks : 1.;
+
+        const ios_base::fmtflags flags = os.flags();
+        const streamsize prec = os.precision();
+        os << "# host time measured: " << fixed << setprecision(3) << total * nsPerTick / 1e6
+           << " ms, by component class:" << endl;
+        PrintRows(os, classes, limit, nsPerTick, total, true);
+        os << "# by process, arbitrator and storage:" << endl;
+        PrintRows(os, rows, limit, nsPerTick, total, false);
+        os.flags(flags);
+        os.precision(prec);
+    }
+}
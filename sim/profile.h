@@ -0,0 +1,42 @@
+// -*- c++ -*-
+#ifndef SIM_PROFILE_H
+#define SIM_PROFILE_H
+
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace Simulator
+{
+    // Host time stamps for the kernel profiler (see
+    // Kernel::SetProfiling). On x86 this is the time stamp counter,
+    // whose rate is calibrated against the wall clock when the profile
+    // is reported; elsewhere it is the steady clock in nanoseconds.
+    typedef uint64_t HostTicks;
+
+    static inline HostTicks ReadHostTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Host time spent in, and number of invocations of, a process
+    // delegate, an arbitrator or a storage update.
+    struct ProfileCounter
+    {
+        HostTicks ticks;
+        uint64_t  calls;
+
+        ProfileCounter() : ticks(0), calls(0) {}
+        void Add(HostTicks t) { ticks += t; ++calls; }
+    };
+}
+
+#endif
@@ -3,14 +3,55 @@
 #include <sim/except.h>
 
 #include <sstream>
+#include <algorithm>
 #include <fnmatch.h>
 
 using namespace std;
 
 namespace Simulator
 {
+    void SampleBatch::Add(const void* var, size_t width)
+    {
+        const char *p = (const char*)var;
+        if (!m_runs.empty() && m_runs.back().first + m_runs.back().second == p)
+            m_runs.back().second += width;
+        else
+            m_runs.push_back(make_pair(p, width));
+        m_size += width;
+    }
+
+    uint32_t VariableRegistry::NameTable::Intern(const string& name)
+    {
+        auto i = m_ids.insert(make_pair(name, (uint32_t)m_names.size()));
+        if (i.second)
+            m_names.push_back(name);
+        return i.first->second;
+    }
+
+    bool VariableRegistry::NameTable::Find(const string& name, uint32_t& id) const
+    {
+        auto i = m_ids.find(name);
+        if (i == m_ids.end())
+            return false;
+        id = i->second;
+        return true;
+    }
+
+    // Split a variable name after its last ':'.
+    static inline size_t SplitName(const string& name)
+    {
+        size_t p = name.rfind(':');
+        return (p == string::npos) ? 0 : p + 1;
+    }
+
+    static inline uint64_t MakeKey(uint32_t prefix, uint32_t leaf)
+    {
+        return ((uint64_t)prefix << 32) | leaf;
+    }
+
     VariableRegistry::VariableRegistry()
-        : m_registry()
+        : m_vars(), m_prefixes(), m_leaves(), m_index(),
+          m_maxValues(), m_lastPrefix(0), m_sorted()
     {}
 
     void VariableRegistry::RegisterVariable(void *var, const string& name,
@@ -19,29 +60,162 @@ namespace Simulator
                                             size_t width, void *maxval,
                                             serializer_func_t ser)
     {
-        if (m_registry.find(name) != m_registry.end())
-            throw exceptf<>("Duplicate variable registration: %s",
-                            name.c_str());
+        size_t split = SplitName(name);
 
         VarInfo vinfo;
 
         vinfo.var = var;
+        vinfo.ser = ser;
         vinfo.width = width;
+        if (m_vars.empty() ||
+            name.compare(0, split, m_prefixes[m_lastPrefix]) != 0)
+            m_lastPrefix = m_prefixes.Intern(name.substr(0, split));
+        vinfo.prefix = m_lastPrefix;
+        vinfo.leaf = m_leaves.Intern(name.substr(split));
+        vinfo.max = NO_MAX;
         vinfo.type = type;
         vinfo.cat = cat;
-        vinfo.ser = ser;
+
+        if (!m_index.insert(make_pair(MakeKey(vinfo.prefix, vinfo.leaf),
+                                      (VarID)m_vars.size())).second)
+            throw exceptf<>("Duplicate variable registration: %s",
+                            name.c_str());
 
         const char *maxdata = (const char*)maxval;
         if (maxdata)
-            for (size_t i = 0; i < width; ++i)
-                vinfo.max.push_back(maxdata[i]);
+        {
+            vinfo.max = m_maxValues.size();
+            m_maxValues.insert(m_maxValues.end(), maxdata, maxdata + width);
+        }
+
+        m_vars.push_back(vinfo);
+    }
+
+    string VariableRegistry::GetName(VarID id) const
+    {
+        const VarInfo& vinfo = m_vars[id];
+        return m_prefixes[vinfo.prefix] + m_leaves[vinfo.leaf];
+    }
+
+    bool VariableRegistry::FindVariable(const string& name, VarID& id) const
+    {
+        size_t split = SplitName(name);
+        uint32_t prefix, leaf;
+        if (!m_prefixes.Find(name.substr(0, split), prefix) ||
+            !m_leaves.Find(name.substr(split), leaf))
+            return false;
+
+        auto i = m_index.find(MakeKey(prefix, leaf));
+        if (i == m_index.end())
+            return false;
+        id = i->second;
+        return true;
+    }
+
+    // Compare the concatenations a1+a2 and b1+b2 like
+    // std::string::compare would.
+    static int CompareConcat(const string& a1, const string& a2,
+                             const string& b1, const string& b2)
+    {
+        const char *pa = a1.data(), *pb = b1.data();
+        size_t na = a1.size(), nb = b1.size();
+        bool seconda = false, secondb = false;
+        for (;;)
+        {
+            if (na == 0 && !seconda) { pa = a2.data(); na = a2.size(); seconda = true; continue; }
+            if (nb == 0 && !secondb) { pb = b2.data(); nb = b2.size(); secondb = true; continue; }
+            if (na == 0 || nb == 0)
+                return (na == 0) ? ((nb == 0) ? 0 : -1) : 1;
+
+            size_t n = min(na, nb);
+            int r = memcmp(pa, pb, n);
+            if (r != 0)
+                return r;
+            pa += n; na -= n;
+            pb += n; nb -= n;
+        }
+    }
+
+    int VariableRegistry::CompareName(VarID id, const string& name) const
+    {
+        static const string empty;
+        const VarInfo& vinfo = m_vars[id];
+        return CompareConcat(m_prefixes[vinfo.prefix], m_leaves[vinfo.leaf],
+                             name, empty);
+    }
 
-        m_registry[name] = vinfo;
+    bool VariableRegistry::LessName(VarID a, VarID b) const
+    {
+        const VarInfo& va = m_vars[a], &vb = m_vars[b];
+        if (va.prefix == vb.prefix)
+            return m_leaves[va.leaf] < m_leaves[vb.leaf];
+        return CompareConcat(m_prefixes[va.prefix], m_leaves[va.leaf],
+                             m_prefixes[vb.prefix], m_leaves[vb.leaf]) < 0;
+    }
+
+    const vector<VariableRegistry::VarID>& VariableRegistry::GetSortedVariables() const
+    {
+        if (m_sorted.size() != m_vars.size())
+        {
+            // Variables were registered since the last query.
+            m_sorted.resize(m_vars.size());
+            for (size_t i = 0; i < m_sorted.size(); ++i)
+                m_sorted[i] = i;
+            sort(m_sorted.begin(), m_sorted.end(),
+                 [this](VarID a, VarID b) -> bool { return LessName(a, b); });
+        }
+        return m_sorted;
+    }
+
+    template<typename F>
+    void VariableRegistry::ForEachMatch(const string& pat, F f) const
+    {
+        // The literal prefix of the pattern, up to its first special
+        // character, bounds the range of names that can match.
+        size_t litsize = pat.find_first_of("*?[\\");
+        if (litsize == string::npos)
+        {
+            // No wildcard: the pattern only matches itself.
+            VarID id;
+            if (FindVariable(pat, id))
+                f(id, pat);
+            return;
+        }
+        string lit = pat.substr(0, litsize);
+
+        const vector<VarID>& sorted = GetSortedVariables();
+        auto i = lower_bound(sorted.begin(), sorted.end(), lit,
+                             [this](VarID id, const string& s) -> bool
+                             { return CompareName(id, s) < 0; });
+
+        string name;
+        for (; i != sorted.end(); ++i)
+        {
+            const VarInfo& vinfo = m_vars[*i];
+            name = m_prefixes[vinfo.prefix];
+            name += m_leaves[vinfo.leaf];
+            if (name.compare(0, litsize, lit) != 0)
+                break;
+            if (FNM_NOMATCH == fnmatch(pat.c_str(), name.c_str(), 0))
+                continue;
+            f(*i, name);
+        }
+    }
+
+    void VariableRegistry::FindVariables(vector<VarID>& ids, const string& pat) const
+    {
+        ForEachMatch(pat, [&ids](VarID id, const string&) { ids.push_back(id); });
+    }
+
+    void VariableRegistry::AddToBatch(SampleBatch& batch, const vector<VarID>& ids) const
+    {
+        for (auto id : ids)
+            batch.Add(m_vars[id].var, m_vars[id].width);
     }
 
     void VariableRegistry::ListVariables_onevar(ostream& os,
                                                 const string& name,
-                                                const VarInfo& vinfo)
+                                                const VarInfo& vinfo) const
     {
         os << dec << vinfo.width << "\t";
 
@@ -64,9 +238,9 @@ namespace Simulator
         case Serialization::SV_OTHER: os << "\tother\t"; break;
         }
 
-        if (vinfo.max.size() > 0)
+        if (vinfo.max != NO_MAX)
         {
-            const void *p = &vinfo.max[0];
+            const void *p = &m_maxValues[vinfo.max];
             StreamSerializer s(os, false);
             s.serialize_raw_ro(vinfo.type, p, vinfo.width);
         }
@@ -86,37 +260,36 @@ namespace Simulator
     void VariableRegistry::ListVariables(ostream& os, const string& pat) const
     {
         ListVariables_header(os);
-        for (auto& i : GetRegistry())
-        {
-            if (FNM_NOMATCH == fnmatch(pat.c_str(), i.first.c_str(), 0))
-                continue;
-            ListVariables_onevar(os, i.first, i.second);
-        }
+        ForEachMatch(pat, [this, &os](VarID id, const string& name)
+                     { ListVariables_onevar(os, name, m_vars[id]); });
     }
 
 
     void VariableRegistry::SetVariables(ostream& os, const string& pat,
                                         const string& val) const
     {
-        for (auto& i : m_registry)
-        {
-            if (FNM_NOMATCH == fnmatch(pat.c_str(), i.first.c_str(), 0))
-                continue;
-            os << "Writing " << i.first << "..." << std::endl;
+        ForEachMatch(pat, [this, &os, &val](VarID id, const string& name)
+                     {
+                         os << "Writing " << name << "..." << std::endl;
 
-            istringstream is(val);
-            StreamSerializer s(is);
+                         istringstream is(val);
+                         StreamSerializer s(is);
+                         SerializeVariable(s, m_vars[id]);
+                     });
+    }
 
-            switch(i.second.type)
-            {
-            case Serialization::SV_BITS:
-            case Serialization::SV_BINARY:
-                s.serialize_raw(i.second.type, i.second.var, i.second.width);
-                break;
-            default:
-                i.second.ser(s, i.second.var);
-                break;
-            }
+    void VariableRegistry::SerializeVariable(StreamSerializer& s,
+                                             const VarInfo& vinfo)
+    {
+        switch(vinfo.type)
+        {
+        case Serialization::SV_BITS:
+        case Serialization::SV_BINARY:
+            s.serialize_raw(vinfo.type, vinfo.var, vinfo.width);
+            break;
+        default:
+            vinfo.ser(s, vinfo.var);
+            break;
         }
     }
 
@@ -125,30 +298,82 @@ namespace Simulator
                                            bool compact) const
     {
         bool some = false;
-        for (auto& i : m_registry)
+        ForEachMatch(pat, [this, &os, compact, &some](VarID id, const string& name)
+                     {
+                         os << name << " =";
+
+                         StreamSerializer s(os, compact);
+                         SerializeVariable(s, m_vars[id]);
+                         os << endl;
+                         some = true;
+                     });
+        return some;
+    }
+
+    void VariableRegistry::LoadVariables(istream& is) const
+    {
+        // Check that the input matches the registry before loading
+        // anything, so that a mismatching input leaves the variables
+        // untouched.
+        vector<string> values(m_vars.size());
+        vector<bool> present(m_vars.size(), false);
+        string line;
+        while (getline(is, line))
         {
-            if (FNM_NOMATCH == fnmatch(pat.c_str(), i.first.c_str(), 0))
+            if (line.empty() || line[0] == '#')
                 continue;
 
-            os << i.first << " =";
+            size_t eq = line.find(" =");
+            if (eq == string::npos)
+                throw exceptf<>("Invalid variable input: %s",
+                                line.substr(0, 80).c_str());
 
-            StreamSerializer s(os, compact);
+            string name = line.substr(0, eq);
+            VarID id;
+            if (!FindVariable(name, id))
+                throw exceptf<>("Unknown variable: %s", name.c_str());
+            if (present[id])
+                throw exceptf<>("Duplicate variable: %s", name.c_str());
+            present[id] = true;
+            values[id] = line.substr(eq + 2);
+        }
+
+        const vector<VarID>& sorted = GetSortedVariables();
+        for (auto id : sorted)
+            if (!present[id])
+                throw exceptf<>("Missing variable: %s", GetName(id).c_str());
+
+        // A value can still fail to parse after the variables before
+        // it were loaded, so snapshot every variable and roll back to
+        // the snapshot on error.
+        vector<string> snapshot(m_vars.size());
+        for (auto id : sorted)
+        {
+            ostringstream os;
+            StreamSerializer s(os, true);
+            SerializeVariable(s, m_vars[id]);
+            snapshot[id] = os.str();
+        }
 
-            const VarInfo& vinfo = i.second;
-            switch(vinfo.type)
+        for (auto id : sorted)
+        {
+            istringstream vs(values[id]);
+            StreamSerializer s(vs);
+            try
             {
-            case Serialization::SV_BITS:
-            case Serialization::SV_BINARY:
-                s.serialize_raw(vinfo.type, vinfo.var, vinfo.width);
-                break;
-            default:
-                vinfo.ser(s, vinfo.var);
+                SerializeVariable(s, m_vars[id]);
+            }
+            catch (const exception& e)
+            {
+                for (auto rid : sorted)
+                {
+                    istringstream rs(snapshot[rid]);
+                    StreamSerializer r(rs);
+                    SerializeVariable(r, m_vars[rid]);
+                }
+                throw exceptf<>("While loading %s: %s", GetName(id).c_str(), e.what());
             }
-            os << endl;
-            some = true;
         }
-        return some;
     }
 
-
 }
@@ -5,6 +5,8 @@
 #include <type_traits>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <cstring>
 
 #include <sim/serialization.h>
 #include <sim/streamserializer.h>
@@ -19,33 +21,87 @@ namespace Simulator
         SVC_CUMULATIVE, // stats: integral of level over time
     };
 
+    // SampleBatch: a fixed selection of variables, copied together
+    // into a contiguous record. The selection is kept as a list of
+    // (address, size) runs computed once, where variables adjacent
+    // in memory and in the record share a run.
+    class SampleBatch
+    {
+        std::vector<std::pair<const char*, size_t> > m_runs;
+        size_t m_size;
+
+    public:
+        SampleBatch() : m_runs(), m_size(0) {}
+
+        // Append a variable to the record.
+        void Add(const void* var, size_t width);
+
+        void   Clear() { m_runs.clear(); m_size = 0; }
+        size_t GetSize() const { return m_size; }
+        size_t GetNumRuns() const { return m_runs.size(); }
+
+        // Copy the current values of the variables into buf, which
+        // must hold GetSize() bytes.
+        void CopyTo(char* buf) const
+        {
+            for (auto& r : m_runs)
+            {
+                memcpy(buf, r.first, r.second);
+                buf += r.second;
+            }
+        }
+    };
+
     class VariableRegistry
     {
     public:
         typedef Serialization::SerializationValueType ValueType;
         typedef void (*serializer_func_t)(StreamSerializer&, void*);
 
+        // Variables are numbered densely in registration order.
+        typedef uint32_t VarID;
+
     private:
+        // A table of interned strings, numbered densely.
+        class NameTable
+        {
+            std::unordered_map<std::string, uint32_t> m_ids;
+            std::vector<std::string>                  m_names;
+        public:
+            uint32_t Intern(const std::string& name);
+            bool     Find(const std::string& name, uint32_t& id) const;
+            const std::string& operator[](uint32_t id) const { return m_names[id]; }
+            NameTable() : m_ids(), m_names() {}
+        };
+
+        // The name of a variable is the concatenation of an interned
+        // prefix, up to and including the last ':' (the component
+        // path), and an interned leaf. Both are shared among many
+        // variables, eg. the same leaf among all caches.
         struct VarInfo
         {
-            ValueType              type;
             void *                 var;
-            size_t                 width;
             serializer_func_t      ser;
+            size_t                 width;
+            uint32_t               prefix;
+            uint32_t               leaf;
+            uint32_t               max;     ///< Offset of the maximum in m_maxValues, or NO_MAX
+            ValueType              type;
             VariableCategory       cat;
-            std::vector<char>      max;
-
-            VarInfo()
-                : type(Serialization::SV_INTEGER), var(0), width(0), ser(0),
-                  cat(SVC_LEVEL), max() {};
-            VarInfo(const VarInfo&) = default;
-            VarInfo& operator=(const VarInfo&) = default;
         };
+        static const uint32_t NO_MAX = (uint32_t)-1;
 
-        typedef std::map<std::string, VarInfo> var_registry_t;
-        var_registry_t m_registry;
+        std::vector<VarInfo>                    m_vars;
+        NameTable                               m_prefixes;
+        NameTable                               m_leaves;
+        std::unordered_map<uint64_t, VarID>     m_index;     ///< (prefix, leaf) -> variable
+        std::vector<char>                       m_maxValues;
+        uint32_t                                m_lastPrefix; ///< Components register their variables together
 
-        const var_registry_t& GetRegistry() const { return m_registry; }
+        // The variables in name order, built on demand for queries.
+        mutable std::vector<VarID>              m_sorted;
+
+        const std::vector<VarID>& GetSortedVariables() const;
 
     public:
         VariableRegistry();
@@ -81,6 +137,24 @@ namespace Simulator
                               const std::string& name,
                               VariableCategory cat, size_t sz);
 
+        size_t GetNumVariables() const { return m_vars.size(); }
+
+        // The full name of a variable.
+        std::string GetName(VarID id) const;
+
+        // Look up a variable by its full name. Returns false if there
+        // is no such variable.
+        bool FindVariable(const std::string& name, VarID& id) const;
+
+        // Append the variables whose name match the pattern to ids,
+        // in name order. Only the names sharing the literal prefix of
+        // the pattern (up to its first wildcard) are matched against
+        // it, found by binary search in the sorted names.
+        void FindVariables(std::vector<VarID>& ids, const std::string& pat) const;
+
+        // Append variables to a sample batch.
+        void AddToBatch(SampleBatch& batch, const std::vector<VarID>& ids) const;
+
         // Load a value from a string into zero or more variables.
         void SetVariables(std::ostream& os, const std::string& pat, const std::string& val) const;
 
@@ -93,15 +167,29 @@ namespace Simulator
         bool RenderVariables(std::ostream& os, const std::string &pat = "*",
                              bool compact = false) const;
 
+        // Load the values of all registered variables from the
+        // output of RenderVariables() with the pattern "*". Lines
+        // starting with '#' are ignored. Throws an exception without
+        // modifying any variable if the input names an unknown
+        // variable or misses one.
+        void LoadVariables(std::istream& is) const;
+
 
     private:
         // Helper methods
-        static
+        template<typename F>
+        void ForEachMatch(const std::string& pat, F f) const;
+        int  CompareName(VarID id, const std::string& name) const;
+        bool LessName(VarID a, VarID b) const;
+
         void ListVariables_onevar(std::ostream& os,
                                   const std::string& name,
-                                  const VarInfo& vinfo);
+                                  const VarInfo& vinfo) const;
         static
         void ListVariables_header(std::ostream& os);
+        static
+        void SerializeVariable(StreamSerializer& s,
+                               const VarInfo& vinfo);
 
         friend class BinarySampler;
     };
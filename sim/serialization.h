@@ -5,6 +5,7 @@
 #include <type_traits>
 #include <vector>
 #include <deque>
+#include <queue>
 #include <map>
 #include <cstddef>
 #include <cstdint>
@@ -154,6 +155,26 @@ namespace Simulator
         struct serialize_trait<std::deque<T> >
             : public container_serializer<std::deque<T>, 'q'> {};
 
+        // General serializer for std::queue. The elements are
+        // serialized like the underlying sequential container.
+        template<typename T, typename Container>
+        struct serialize_trait<std::queue<T, Container> >
+        {
+            template<typename A>
+            static void serialize(A& arch, std::queue<T, Container>& q)
+            {
+                // std::queue exposes its container to subclasses only.
+                struct access : public std::queue<T, Container>
+                {
+                    static Container& get(std::queue<T, Container>& q)
+                    {
+                        return q.*(&access::c);
+                    }
+                };
+                arch & access::get(q);
+            }
+        };
+
         // General serializer for std::vector<char>
         // (array of bytes)
         template<typename ByteType>
@@ -182,6 +203,29 @@ namespace Simulator
         struct serialize_trait<std::vector<uint8_t> >
             : public byte_serializer<uint8_t> {};
 
+        // General serializer for std::vector<bool>, whose elements
+        // cannot be referenced individually.
+        template<>
+        struct serialize_trait<std::vector<bool> >
+        {
+            template<typename A>
+            static void serialize(A& arch, std::vector<bool>& v)
+            {
+                size_t sz = v.size();
+                arch & "[b" & sz;
+                v.resize(sz);
+
+                for (size_t i = 0; i < sz; ++i)
+                {
+                    bool b = v[i];
+                    arch & b;
+                    v[i] = b;
+                }
+
+                arch & "]";
+            }
+        };
+
         // Base serializer for pointer types.
         // Note that this is not enabled automatically
         // as we avoid to silently misserialize arrays.
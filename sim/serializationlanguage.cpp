@@ -56,7 +56,9 @@ namespace Simulator
                 RenderBitVector(os, (const bool*)p, w, compact);
                 break;
             case SV_BOOL:
-                RenderBoolean(os, *(const bool*)p, compact);
+                // Read the byte, as a bool that was never assigned
+                // (eg. in a recycled message) may hold any value.
+                RenderBoolean(os, *(const uint8_t*)p != 0, compact);
                 break;
             case SV_INTEGER:
                 RenderInteger(os, p, w, compact);
@@ -111,17 +113,19 @@ namespace Simulator
             // A sequence of N>2 trues is serialized as "+N."
             // A sequence of N>2 falses is serialized as "-N."
             // An underscore is used to separate groups of 8 bits.
-            const bool* s = buf;
-            const bool* end = s + max;
+            // The bools are read as bytes, like in RenderValue().
+            const uint8_t* start = (const uint8_t*)buf;
+            const uint8_t* s = start;
+            const uint8_t* end = s + max;
             while (s < end)
             {
-                if (!compact && s > buf && (s - buf) % 8 == 0)
+                if (!compact && s > start && (s - start) % 8 == 0)
                     os << '_';
 
-                if (compact && s + 2 < end && s[1] == s[0] && s[2] == s[0])
+                if (compact && s + 2 < end && !s[1] == !s[0] && !s[2] == !s[0])
                 {
                     size_t n;
-                    for (n = 2; s + n < end && s[n] == s[0]; ++n)
+                    for (n = 2; s + n < end && !s[n] == !s[0]; ++n)
                         ;
                     os << (s[0] ? '+' : '-') << n << '.';
                     s += n;
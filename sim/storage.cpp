@@ -31,7 +31,9 @@ namespace Simulator
         : Object(name, parent),
           m_next(NULL),
           m_clock(clock),
-          InitStateVariable(activated, false)
+          m_traceId(GetKernel()->AllocateStorageId()),
+          InitStateVariable(activated, false),
+          m_profile()
     {}
 
     Storage::~Storage()
@@ -13,9 +13,13 @@ namespace Simulator
     class Storage
         : public virtual Object
     {
+        friend class Kernel;
+
         Storage*              m_next;         ///< Next pointer in the list of storages that require updates
         Clock&                m_clock;        ///< The clock that governs this storage
+        const uint32_t        m_traceId;      ///< Small identifier for storage trace checks
         DefineStateVariable(bool, activated); ///< Has the storage already been activated this cycle?
+        ProfileCounter        m_profile;      ///< Host time of Update (see Kernel::SetProfiling)
 
     protected:
 
@@ -38,6 +42,12 @@ namespace Simulator
         // Accessor for the clock that governs this storage.
         Clock& GetClock() const { return m_clock; }
 
+        // Identifier of this storage in the storage trace automata.
+        uint32_t GetTraceId() const { return m_traceId; }
+
+        // Host time profile of the updates of this storage.
+        const ProfileCounter& GetProfile() const { return m_profile; }
+
         // Used in Kernel::UpdateStorages.
         void Deactivate() { m_activated = false; }
         virtual void Update() = 0;
@@ -13,10 +13,33 @@ namespace Simulator
 #endif
     }
 
+    inline
+    void Process::OnStorageAccess(const Storage& s)
+    {
+#if !defined(DISABLE_TRACE_CHECKS)
+        if (m_traceState != StorageTraceAutomaton::REJECT)
+        {
+            auto next = m_traces.Next(m_traceState, s.GetTraceId());
+            if (next != StorageTraceAutomaton::REJECT)
+            {
+                m_traceState = next;
+                return;
+            }
+
+            // Keep the whole trace for the report at the end of the cycle
+            m_invalidTrace = m_traces.GetTrace(m_traceState);
+            m_traceState = StorageTraceAutomaton::REJECT;
+        }
+        m_invalidTrace.Append(s);
+#else
+        (void)s;
+#endif
+    }
+
     inline
     void Storage::MarkUpdate()
     {
-#if !defined(NDEBUG) && !defined(DISABLE_TRACE_CHECKS)
+#if !defined(DISABLE_TRACE_CHECKS)
         if (IsAcquiring()) {
             auto p = GetKernel()->GetActiveProcess();
             p->OnStorageAccess(*this);
@@ -28,6 +51,12 @@ namespace Simulator
     void Storage::RegisterUpdate()
     {
         if (!m_activated) {
+            if (Kernel::IsParallelPhase()) {
+                // The clock's storage list is shared; the parallel
+                // kernel registers the update at the end of the phase.
+                Kernel::DeferStorageUpdate(*this);
+                return;
+            }
             m_next = GetClock().ActivateStorage(*this);
             m_activated = true;
         }
@@ -1,6 +1,7 @@
 #include "storagetrace.h"
 #include "storage.h"
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -29,6 +30,79 @@ ostream& operator<<(ostream& os, const StorageTraceSet& sts)
     return os;
 }
 
+StorageTraceAutomaton::StorageTraceAutomaton()
+    : m_first(2, 0), m_edges(), m_accept(1, true), m_parent(1, REJECT), m_storage(1, NULL)
+{
+}
+
+void StorageTraceAutomaton::Compile(const StorageTraceSet& sts)
+{
+    // Build the trie with per-state edge lists first
+    vector<vector<Edge> > edges(1);
+    m_accept.assign(1, sts.m_storages.empty());
+    m_parent.assign(1, REJECT);
+    m_storage.assign(1, NULL);
+
+    for (auto& trace : sts.m_storages)
+    {
+        State s = START;
+        for (auto st : trace.m_storages)
+        {
+            const uint32_t id = st->GetTraceId();
+            auto e = find_if(edges[s].begin(), edges[s].end(),
+                             [id](const Edge& x) { return x.storage == id; });
+            if (e != edges[s].end())
+            {
+                s = e->next;
+                continue;
+            }
+
+            const State n = edges.size();
+            edges[s].push_back(Edge{id, n});
+            edges.push_back(vector<Edge>());
+            m_accept.push_back(false);
+            m_parent.push_back(s);
+            m_storage.push_back(st);
+            s = n;
+        }
+        m_accept[s] = true;
+    }
+
+    // Then lay out the edges of each state contiguously
+    m_first.clear();
+    m_edges.clear();
+    for (auto& e : edges)
+    {
+        m_first.push_back(m_edges.size());
+        m_edges.insert(m_edges.end(), e.begin(), e.end());
+    }
+    m_first.push_back(m_edges.size());
+}
+
+StorageTrace StorageTraceAutomaton::GetTrace(State s) const
+{
+    StorageTrace trace;
+    for (; s != START && s != REJECT; s = m_parent[s])
+        trace.m_storages.push_back(m_storage[s]);
+    reverse(trace.m_storages.begin(), trace.m_storages.end());
+    return trace;
+}
+
+ostream& operator<<(ostream& os, const StorageTraceAutomaton& sta)
+{
+    bool any = false;
+    for (StorageTraceAutomaton::State s = 0; s < sta.m_accept.size(); ++s)
+    {
+        if (sta.m_accept[s])
+        {
+            os << "- " << sta.GetTrace(s) << endl;
+            any = true;
+        }
+    }
+    if (!any)
+        os << "(no traces)" << endl;
+    return os;
+}
 
 }
 
@@ -6,6 +6,7 @@
 #include <iterator>
 #include <vector>
 #include <iostream>
+#include <cstdint>
 
 namespace Simulator
 {
@@ -27,11 +28,17 @@ class Storage;
   A ^ B     Union. Any from A or B.
   A * B     Sequence. Any from A, then any from B.
   opt(A)    Optional. Any from A or an empty trace.
+
+ The set is built once when the system is created, then compiled into
+ a StorageTraceAutomaton which the process steps through on each
+ storage access.
 */
 
 /// List of a storage access trace
 class StorageTrace
 {
+    friend class StorageTraceAutomaton;
+
     std::vector<const Storage*> m_storages;
 
 public:
@@ -68,6 +75,7 @@ public:
     }
     bool empty() const { return m_storages.empty(); }
     void clear() { m_storages.clear(); }
+    const std::vector<const Storage*>& GetStorages() const { return m_storages; }
 
     friend std::ostream& operator<<(std::ostream& os, const StorageTrace& st);
 };
@@ -173,5 +181,57 @@ static inline StorageTraceSet opt(const StorageTraceSet& s) {
     return s ^ StorageTraceSet(StorageTrace());
 }
 
+/// Deterministic automaton accepting the traces of a StorageTraceSet.
+//
+// The automaton is the trie of the traces, over the trace identifiers
+// of the storages (see Storage::GetTraceId). The transitions of each
+// state are stored contiguously, so that checking an access scans the
+// few storages that may follow the current prefix.
+class StorageTraceAutomaton
+{
+public:
+    typedef uint32_t State;
+    static const State START  = 0;
+    static const State REJECT = (State)-1;
+
+private:
+    struct Edge
+    {
+        uint32_t storage;   ///< Trace identifier of the storage
+        State    next;
+    };
+
+    std::vector<uint32_t>       m_first;    ///< Per state, index of its first edge; one more entry at the end
+    std::vector<Edge>           m_edges;
+    std::vector<bool>           m_accept;   ///< Per state, whether a trace ends here
+    std::vector<State>          m_parent;   ///< Per state, the state before the last access
+    std::vector<const Storage*> m_storage;  ///< Per state, the storage of the last access
+
+public:
+    /// Constructs an automaton that accepts the empty trace only
+    StorageTraceAutomaton();
+
+    /// Compiles a set of traces. As with StorageTraceSet::Contains,
+    /// an empty set accepts the empty trace.
+    void Compile(const StorageTraceSet& sts);
+
+    State Next(State s, uint32_t storage) const
+    {
+        if (s == REJECT)
+            return REJECT;
+        for (uint32_t i = m_first[s], e = m_first[s + 1]; i != e; ++i)
+            if (m_edges[i].storage == storage)
+                return m_edges[i].next;
+        return REJECT;
+    }
+
+    bool Accepts(State s) const { return s != REJECT && m_accept[s]; }
+
+    /// The accesses that lead from START to s.
+    StorageTrace GetTrace(State s) const;
+
+    friend std::ostream& operator<<(std::ostream& os, const StorageTraceAutomaton& sta);
+};
+
 }
 #endif
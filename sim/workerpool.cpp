@@ -0,0 +1,149 @@
+#include <sys_config.h>
+#include "sim/workerpool.h"
+
+#ifdef CAN_USE_SIGMASK_ON_STD_THREAD
+#include <csignal>
+#include <cstdio>
+#include <pthread.h>
+#define pthread(Function, ...) do { if (pthread_ ## Function(__VA_ARGS__)) perror("pthread_" #Function); } while(0)
+#endif
+
+namespace Simulator
+{
+    // Number of polls before a helper goes to sleep waiting for the
+    // next round. Rounds follow each other quickly while the
+    // simulation runs, so spinning a little avoids a system call per
+    // simulation phase.
+    static const unsigned SPIN_BEFORE_SLEEP = 4096;
+
+    void* runworker(void *arg)
+    {
+#ifdef CAN_USE_SIGMASK_ON_STD_THREAD
+        // Signals (eg. interrupts from the user, or the alarm of the
+        // real-time clocks) are handled by the main thread only.
+        sigset_t sigset;
+        sigemptyset(&sigset);
+        sigaddset(&sigset, SIGALRM);
+        sigaddset(&sigset, SIGINT);
+        sigaddset(&sigset, SIGQUIT);
+        sigaddset(&sigset, SIGHUP);
+        sigaddset(&sigset, SIGTERM);
+        pthread(sigmask, SIG_BLOCK, &sigset, 0);
+#endif
+
+        WorkerPool *p = (WorkerPool*) arg;
+        p->HelperMain();
+        return 0;
+    }
+
+    WorkerPool::WorkerPool(size_t numWorkers)
+        : m_threads(),
+          m_job(0),
+          m_arg(0),
+          m_count(0),
+          m_round(0),
+          m_nextItem(0),
+          m_busy(0),
+          m_exit(false),
+          m_sleeplock(),
+          m_wakeup(),
+          m_errlock(),
+          m_error(),
+          m_errorItem(0)
+    {
+        for (size_t i = 1; i < numWorkers; ++i)
+            m_threads.push_back(new std::thread(runworker, this));
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_sleeplock);
+            m_exit = true;
+            ++m_round;
+        }
+        m_wakeup.notify_all();
+
+        for (auto t : m_threads)
+        {
+            t->join();
+            delete t;
+        }
+    }
+
+    void WorkerPool::RunItems()
+    {
+        size_t i;
+        while ((i = m_nextItem.fetch_add(1, std::memory_order_relaxed)) < m_count)
+        {
+            try
+            {
+                m_job(m_arg, i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(m_errlock);
+                if (!m_error || i < m_errorItem)
+                {
+                    m_error = std::current_exception();
+                    m_errorItem = i;
+                }
+            }
+        }
+    }
+
+    void WorkerPool::HelperMain()
+    {
+        unsigned long seen = 0;
+        for (;;)
+        {
+            // Wait for the next round.
+            unsigned spins = 0;
+            while (m_round.load(std::memory_order_acquire) == seen)
+            {
+                if (++spins < SPIN_BEFORE_SLEEP)
+                    continue;
+
+                std::unique_lock<std::mutex> guard(m_sleeplock);
+                m_wakeup.wait(guard, [&]{ return m_round.load(std::memory_order_acquire) != seen; });
+            }
+            seen = m_round.load(std::memory_order_acquire);
+
+            if (m_exit)
+                break;
+
+            RunItems();
+            m_busy.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void WorkerPool::Run(job_t job, void* arg, size_t count, size_t* failed)
+    {
+        m_job      = job;
+        m_arg      = arg;
+        m_count    = count;
+        m_error    = std::exception_ptr();
+        m_nextItem.store(0, std::memory_order_relaxed);
+        m_busy.store(m_threads.size(), std::memory_order_relaxed);
+
+        {
+            // Start the round; the lock orders the increment with
+            // helpers that are about to go to sleep.
+            std::lock_guard<std::mutex> guard(m_sleeplock);
+            m_round.fetch_add(1, std::memory_order_release);
+        }
+        m_wakeup.notify_all();
+
+        // Participate, then wait for the helpers to finish.
+        RunItems();
+        while (m_busy.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+
+        if (m_error)
+        {
+            if (failed != 0)
+                *failed = m_errorItem;
+            std::rethrow_exception(m_error);
+        }
+    }
+}
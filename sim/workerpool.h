@@ -0,0 +1,86 @@
+// -*- c++ -*-
+#ifndef SIM_WORKERPOOL_H
+#define SIM_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace Simulator
+{
+    // SpinLock: a minimal lock for very short critical sections that
+    // may be entered by several kernel worker threads, for example
+    // the request lists of arbitrated ports.
+    class SpinLock
+    {
+        std::atomic_flag m_flag;
+    public:
+        void lock()   { while (m_flag.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+        void unlock() { m_flag.clear(std::memory_order_release); }
+
+        SpinLock() : m_flag() { m_flag.clear(); }
+        SpinLock(const SpinLock&) = delete;
+        SpinLock& operator=(const SpinLock&) = delete;
+    };
+
+    // WorkerPool: a fixed set of host threads used by the parallel
+    // kernel to run the same job over a range of work items.
+    //
+    // Run(job, arg, n) calls job(arg, i) for every i in [0, n) and
+    // returns once all items have completed. The calling thread
+    // participates as one of the workers. Items are handed out
+    // dynamically, so the job must not depend on which thread runs
+    // which item.
+    //
+    // If one or more items throw an exception, the exception of the
+    // item with the lowest index is rethrown by Run() after all
+    // items have completed.
+    class WorkerPool
+    {
+    public:
+        typedef void (*job_t)(void* arg, size_t item);
+
+    private:
+        std::vector<std::thread*> m_threads;    ///< The helper threads.
+
+        job_t                     m_job;        ///< The job of the current round.
+        void*                     m_arg;        ///< The argument to the current job.
+        size_t                    m_count;      ///< The number of items in the current round.
+
+        std::atomic<unsigned long> m_round;     ///< Round counter, bumped to start a round.
+        std::atomic<size_t>       m_nextItem;   ///< Next item to hand out.
+        std::atomic<size_t>       m_busy;       ///< Number of helpers still in the current round.
+        std::atomic<bool>         m_exit;       ///< Set to terminate the helpers.
+
+        std::mutex                m_sleeplock;  ///< Protects the sleep condition.
+        std::condition_variable   m_wakeup;     ///< Wakes up sleeping helpers.
+
+        std::mutex                m_errlock;    ///< Protects the error fields below.
+        std::exception_ptr        m_error;      ///< First error of the current round.
+        size_t                    m_errorItem;  ///< Item that produced m_error.
+
+        void RunItems();
+        void HelperMain();
+        friend void* runworker(void*);
+
+    public:
+        // Create a pool with the given total number of workers,
+        // including the calling thread.
+        WorkerPool(size_t numWorkers);
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        size_t GetNumWorkers() const { return m_threads.size() + 1; }
+
+        // Run job(arg, i) for all i in [0, count).
+        // Returns the failing item in *failed if an exception was thrown.
+        void Run(job_t job, void* arg, size_t count, size_t* failed = 0);
+    };
+}
+
+#endif
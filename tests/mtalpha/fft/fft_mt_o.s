@@ -243,6 +243,9 @@ _FFT_2:
 	end
     .end _FFT_2
 
+    .section .rodata
+    .ascii "\0TEST_INPUTS:R10:10\0"
+
 /****************************************
  * Sine/Cosine lookup table
  ****************************************/
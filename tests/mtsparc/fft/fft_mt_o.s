@@ -232,6 +232,9 @@ _FFT_2:
 	
 	end
 
+    .section .rodata
+    .ascii "\0TEST_INPUTS:R10:10\0"
+
 /****************************************
  * Sine/Cosine lookup table
  ****************************************/
@@ -9,18 +9,47 @@ mem=${6:?}
 TEST=${7:?}
 fail=0
 
+# Lines of the simulator output that depend on the host, not on the
+# simulation.
+hostlines='random seed|\(us\)$|\(Kibytes\)$'
+# Lines that report saving or restoring a checkpoint.
+ckptlines='^### (saved|restored) checkpoint'
+
+runstatus() {
+  if test $1 = 0; then
+      echo "PASS"
+  elif test $1 = 137; then
+      echo "TIMEOUT"
+  elif test $1 = 134; then
+      echo "ABORT"
+  elif test $1 -ge 128; then
+      echo "SIGNAL ($1)"
+  else
+      echo "FAIL"
+  fi
+}
+
 dotest() {
-  local i extraarg extradesc
+  local i extraarg extradesc batch runs budget
   extraarg=$1
   extradesc=$2
   thesim=$3
+  batch=$4
+
+  # A batch gets the time budget of all its runs
+  runs=1
+  if test -n "$batch"; then
+      runs=$(grep -c . "$batch")
+      extraarg="$extraarg --batch $batch"
+  fi
+  budget=$((${TIMEOUT:-5} * $runs))
 
   cmd="$thesim $SIMARGS -o NumProcessors=$ncores $extraarg $TEST"
   echo "- \`\`$cmd\`\`"
   printf "%s %s" "  " "=> "
   set +e
   exec 3>&2 4>&1 >"$$.out" 2>&1
-  $timeout $cmd 
+  TIMEOUT=$budget $timeout $cmd
   x=$?
   exec 2>&3 1>&4
   set -e
@@ -28,21 +57,81 @@ dotest() {
   if test $x = 0; then
         echo "**PASS**"
   else
-    if test $x = 137; then
-        echo "**TIMEOUT**"
-    elif test $x = 134; then
-        echo "**ABORT**"
-    elif test $x -ge 128; then
-        echo "**SIGNAL ($x)**"
+    echo "**$(runstatus $x)**"
+    if test $x -ge 128 && test $x != 137 && test $x != 134; then
         rekill=1
-    else
-        echo "**FAIL**"
+    fi
+    if test -n "$batch"; then
+        # The exit status of a batch only tells that a run failed;
+        # report each run from the markers printed by the simulator.
+        # Runs without an end marker did not complete.
+        printf "\n  Runs::\n\n"
+        i=0
+        while read -r line; do
+            i=$(($i + 1))
+            st=$(sed -n "s/^### end batch run $i: exit status \([0-9]*\)\$/\1/p" "$$.out")
+            if test -n "$st"; then
+                printf "    %s => **%s**\n" "$line" "$(runstatus $st)"
+            else
+                printf "    %s => **INCOMPLETE**\n" "$line"
+            fi
+        done < "$batch"
     fi
     printf "\n  Command line::\n\n  %s\n\n  Output::\n\n" "$cmd"
     sed -e 's/^/    /g' < "$$.out"
     printf "\n  Exit status: %d\n\n" $x
     fail=1
   fi
+
+  if test $x = 0 && test -n "$KERNEL_THREADS"; then
+    # The parallel kernel must simulate the same cycles and produce
+    # the same output as the serial kernel.
+    pcmd="$thesim $SIMARGS -o NumProcessors=$ncores -o KernelThreads=$KERNEL_THREADS $extraarg $TEST"
+    printf "%s %s" "  " "=> "
+    set +e
+    TIMEOUT=$budget $timeout $pcmd >"$$.par" 2>&1
+    x=$?
+    set -e
+    if test $x = 0 && diff <(grep -Ev "$hostlines" "$$.out") <(grep -Ev "$hostlines" "$$.par") >"$$.diff"; then
+        echo "**PASS** (KernelThreads=$KERNEL_THREADS)"
+    else
+        echo "**MISMATCH** (KernelThreads=$KERNEL_THREADS)"
+        printf "\n  Command line::\n\n  %s\n\n  Differences::\n\n" "$pcmd"
+        sed -e 's/^/    /g' < "$$.diff"
+        printf "\n  Exit status: %d\n\n" $x
+        fail=1
+    fi
+    rm -f "$$.par" "$$.diff"
+  fi
+
+  if test $x = 0 && test -n "$CHECKPOINT_AT" && test -z "$batch"; then
+    # A simulation restored from a checkpoint must end as the
+    # simulation that saved it. Batch runs would all save to the
+    # same file, so they are not checked.
+    scmd="$thesim $SIMARGS -o NumProcessors=$ncores --checkpoint-at $CHECKPOINT_AT --checkpoint-file $$.ckpt $extraarg $TEST"
+    rcmd="$thesim $SIMARGS -o NumProcessors=$ncores --restore $$.ckpt $extraarg $TEST"
+    printf "%s %s" "  " "=> "
+    set +e
+    TIMEOUT=$budget $timeout $scmd >"$$.save" 2>&1 && TIMEOUT=$budget $timeout $rcmd >"$$.rest" 2>&1
+    x=$?
+    set -e
+    if test $x = 0 && diff <(grep -Ev "$hostlines|$ckptlines" "$$.out") <(grep -Ev "$hostlines|$ckptlines" "$$.rest") >"$$.diff"; then
+        echo "**PASS** (checkpoint at cycle $CHECKPOINT_AT)"
+    else
+        echo "**MISMATCH** (checkpoint at cycle $CHECKPOINT_AT)"
+        printf "\n  Command lines::\n\n  %s\n  %s\n\n" "$scmd" "$rcmd"
+        if test $x = 0; then
+            printf "  Differences::\n\n"
+            sed -e 's/^/    /g' < "$$.diff"
+        else
+            printf "  Output::\n\n"
+            cat "$$.save" "$$.rest" 2>/dev/null | sed -e 's/^/    /g'
+        fi
+        printf "\n  Exit status: %d\n\n" $x
+        fail=1
+    fi
+    rm -f "$$.ckpt" "$$.save" "$$.rest" "$$.diff"
+  fi
   rm -f "$$.out"
 
   if test -n "$rekill"; then
@@ -57,10 +146,13 @@ for cfg in "$cfg1" "$cfg2"; do
  if test -n "$rdata"; then
     reg=$(echo "$rdata"|cut -d: -f2)
     vals=$(echo "$rdata"|cut -d: -f3)
+    # Run all the input values from a single instantiation of the system
     for val in $vals; do
-	dotest "-c $cfg -t -o MemoryType=$mem -$reg $val" "config=$cfgname MemType=$mem $reg=$val" "$sim"
-	dotest "-c $cfg -t -o MemoryType=$mem -$reg $val" "config=$cfgname MemType=$mem $reg=$val" "$sim-dyn"
-    done
+	echo "-$reg $val"
+    done > "$$.batch"
+    dotest "-c $cfg -t -o MemoryType=$mem" "config=$cfgname MemType=$mem $reg=$vals" "$sim" "$$.batch"
+    dotest "-c $cfg -t -o MemoryType=$mem" "config=$cfgname MemType=$mem $reg=$vals" "$sim-dyn" "$$.batch"
+    rm -f "$$.batch"
  else
     dotest "-c $cfg -t -o MemoryType=$mem" "MemType=$mem" "$sim"
     dotest "-c $cfg -t -o MemoryType=$mem" "MemType=$mem" "$sim-dyn"